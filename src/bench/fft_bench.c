@@ -0,0 +1,93 @@
+#include <common.h>
+#include <epulse.h>
+
+#include <math.h>
+#include <time.h>
+
+/*
+ * Measures the cost of one spectrum frame (window + real FFT + log band
+ * mapping) for the FFT sizes the analyzer can use, and what that costs
+ * in CPU when redrawing at 60 frames per second.
+ */
+
+#define BENCH_BANDS 64
+#define BENCH_FPS 60
+#define BENCH_RATE ((float)EPULSE_SPECTRUM_RATE / EPULSE_SPECTRUM_DECIMATION)
+#define BENCH_MIN_TIME 0.5
+
+static double
+_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+_bench(unsigned int size)
+{
+   Epulse_Fft *fft;
+   float *samples, *power, bands[BENCH_BANDS];
+   double start, fft_time, frame_time;
+   unsigned int i, runs;
+
+   fft = epulse_fft_new(size);
+   samples = malloc(size * sizeof(float));
+   power = malloc(size / 2 * sizeof(float));
+   if (!fft || !samples || !power)
+     {
+        fprintf(stderr, "Could not allocate a %u point FFT\n", size);
+        goto end;
+     }
+
+   for (i = 0; i < size; i++)
+      samples[i] = 0.5f * sinf(2.0f * M_PI * 1000.0f * i / BENCH_RATE) +
+                   0.01f * ((float)rand() / RAND_MAX - 0.5f);
+
+   runs = 0;
+   start = _now();
+   do
+     {
+        epulse_fft_power(fft, samples, power);
+        runs++;
+     }
+   while (_now() - start < BENCH_MIN_TIME);
+   fft_time = (_now() - start) / runs;
+
+   runs = 0;
+   start = _now();
+   do
+     {
+        epulse_fft_power(fft, samples, power);
+        epulse_fft_bands(fft, power, BENCH_RATE, bands, BENCH_BANDS);
+        runs++;
+     }
+   while (_now() - start < BENCH_MIN_TIME);
+   frame_time = (_now() - start) / runs;
+
+   printf("%6u %12.2f %12.2f %10.3f%%\n", size, fft_time * 1e6,
+          frame_time * 1e6, frame_time * BENCH_FPS * 100.0);
+
+ end:
+   epulse_fft_free(fft);
+   free(samples);
+   free(power);
+}
+
+int
+main(int argc EINA_UNUSED, char *argv[] EINA_UNUSED)
+{
+   unsigned int size;
+
+   if (!epulse_common_init("fft_bench"))
+      return EXIT_FAILURE;
+
+   printf("%6s %12s %12s %11s\n", "size", "fft (us)", "frame (us)",
+          "cpu@60fps");
+   for (size = 512; size <= 8192; size *= 2)
+      _bench(size);
+
+   epulse_common_shutdown();
+   return EXIT_SUCCESS;
+}
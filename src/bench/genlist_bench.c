@@ -0,0 +1,253 @@
+#include <common.h>
+#include <epulse.h>
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <Ecore_File.h>
+
+#include "playbacks_view.h"
+#include "icon_cache.h"
+
+/*
+ * Feeds the playbacks view synthetic streams, one application each, and
+ * measures with the default genlist settings and no content recycling,
+ * then with the large list ones: how long the rows take to be appended
+ * and first drawn, the frame rate while scrolling through all of them
+ * and the memory they take. Each mode runs in a process of its own.
+ *
+ * The state cache and the config are kept in a temporary directory, so
+ * only the synthetic streams are in the view. Drawing goes to the buffer
+ * engine unless ELM_ENGINE says otherwise.
+ */
+
+#define BENCH_STREAMS 1000
+#define BENCH_WIDTH 480
+#define BENCH_HEIGHT 640
+#define BENCH_SCROLL_STEP 3 /* rows per frame */
+
+static unsigned int _delivered = 0;
+
+static double
+_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long
+_rss_kb(void)
+{
+   long size, rss = 0;
+   FILE *f = fopen("/proc/self/statm", "r");
+
+   if (!f)
+      return 0;
+   if (fscanf(f, "%ld %ld", &size, &rss) != 2)
+      rss = 0;
+   fclose(f);
+
+   return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* lets queued events and the genlist jobs run, then draws */
+static void
+_frame(Evas *evas)
+{
+   ecore_main_loop_iterate();
+   evas_smart_objects_calculate(evas);
+   evas_render(evas);
+}
+
+static void
+_event_free_cb(void *data EINA_UNUSED, void *event)
+{
+   Epulse_Event_Sink_Input *ev = event;
+
+   free(ev->base.name);
+   free(ev->icon);
+   free(ev->app);
+   free(ev);
+   _delivered++;
+}
+
+static void
+_streams_add(void)
+{
+   Epulse_Event_Sink_Input *ev;
+   char buf[64];
+   unsigned int i;
+
+   for (i = 0; i < BENCH_STREAMS; i++)
+     {
+        ev = calloc(1, sizeof(Epulse_Event_Sink_Input));
+        EINA_SAFETY_ON_NULL_RETURN(ev);
+
+        ev->base.index = i;
+        snprintf(buf, sizeof(buf), "Stream %u", i);
+        ev->base.name = strdup(buf);
+        pa_cvolume_set(&ev->base.volume, 2, PA_VOLUME_NORM);
+        ev->base.changed = EPULSE_CHANGE_ALL;
+        snprintf(buf, sizeof(buf), "Application %u", i);
+        ev->app = strdup(buf);
+        ev->icon = strdup("audio-card");
+        ev->sink = 0;
+        ev->pid = -1;
+
+        ecore_event_add(SINK_INPUT_ADDED, ev, _event_free_cb, NULL);
+     }
+}
+
+static void
+_bench(Eina_Bool large)
+{
+   Evas_Object *win, *view, *genlist;
+   Elm_Object_Item *it;
+   Eina_List *children;
+   Evas *evas;
+   double start, append, first, scroll;
+   unsigned int frames = 0, i;
+   long rss;
+
+   win = elm_win_add(NULL, "genlist_bench", ELM_WIN_BASIC);
+   EINA_SAFETY_ON_NULL_RETURN(win);
+   evas = evas_object_evas_get(win);
+   evas_object_resize(win, BENCH_WIDTH, BENCH_HEIGHT);
+   evas_object_show(win);
+
+   view = playbacks_view_add(win);
+   if (!view)
+     {
+        fprintf(stderr, "Could not create the view, is the theme built?\n");
+        evas_object_del(win);
+        return;
+     }
+   evas_object_size_hint_weight_set(view, EVAS_HINT_EXPAND,
+                                    EVAS_HINT_EXPAND);
+   elm_win_resize_object_add(win, view);
+   evas_object_show(view);
+
+   /* the genlist comes first in the box of the view */
+   children = elm_box_children_get(elm_layout_content_get(view, "list"));
+   genlist = eina_list_data_get(children);
+   eina_list_free(children);
+   epulse_genlist_large_set(genlist, large);
+   playbacks_view_content_reuse_set(view, large);
+   _frame(evas);
+
+   rss = _rss_kb();
+   _delivered = 0;
+   start = _now();
+   _streams_add();
+   while (_delivered < BENCH_STREAMS)
+      ecore_main_loop_iterate();
+   append = _now() - start;
+
+   _frame(evas);
+   first = _now() - start;
+   rss = _rss_kb() - rss;
+
+   start = _now();
+   it = elm_genlist_first_item_get(genlist);
+   while (it)
+     {
+        elm_genlist_item_show(it, ELM_GENLIST_ITEM_SCROLLTO_TOP);
+        _frame(evas);
+        frames++;
+        for (i = 0; it && i < BENCH_SCROLL_STEP; i++)
+           it = elm_genlist_item_next_get(it);
+     }
+   scroll = _now() - start;
+
+   printf("%-8s %12.2f %12.2f %10.1f %10ld\n", large ? "large" : "default",
+          append * 1000.0, first * 1000.0,
+          scroll > 0.0 ? frames / scroll : 0.0, rss);
+
+   evas_object_del(win);
+   ecore_main_loop_iterate();
+}
+
+/* runs in a child, the second mode must not find the pools the first
+ * one grew */
+static int
+_mode_run(int argc, char *argv[], Eina_Bool large)
+{
+   if (!epulse_common_init("genlist_bench"))
+      return EXIT_FAILURE;
+   elm_init(argc, argv);
+
+   /* the views are not connected, their meters cannot start */
+   eina_log_domain_level_set("eina_safety", EINA_LOG_LEVEL_CRITICAL);
+
+   if (epulse_init_deferred() <= 0)
+     {
+        fprintf(stderr, "Could not init epulse\n");
+        goto err;
+     }
+   elm_theme_extension_add(NULL, BENCH_THEME);
+
+   _bench(large);
+
+   icon_cache_shutdown();
+   elm_theme_extension_del(NULL, BENCH_THEME);
+   epulse_shutdown();
+   elm_shutdown();
+   epulse_common_shutdown();
+   return EXIT_SUCCESS;
+
+ err:
+   elm_shutdown();
+   epulse_common_shutdown();
+   return EXIT_FAILURE;
+}
+
+int
+main(int argc, char *argv[])
+{
+   char dir[] = "/tmp/genlist_bench.XXXXXX";
+   int i, status, ret = EXIT_SUCCESS;
+   pid_t pid;
+
+   setenv("ELM_ENGINE", "buffer", 0);
+
+   /* the user's cached streams would be replayed into the view */
+   if (!mkdtemp(dir))
+     {
+        fprintf(stderr, "Could not create a temporary directory\n");
+        return EXIT_FAILURE;
+     }
+   setenv("XDG_CACHE_HOME", dir, 1);
+   setenv("XDG_CONFIG_HOME", dir, 1);
+
+   printf("%u streams\n", BENCH_STREAMS);
+   printf("%-8s %12s %12s %10s %10s\n", "mode", "append (ms)",
+          "first (ms)", "scroll fps", "rss (kB)");
+
+   for (i = 0; i < 2; i++)
+     {
+        fflush(stdout);
+        pid = fork();
+        if (pid < 0)
+          {
+             perror("fork");
+             ret = EXIT_FAILURE;
+             break;
+          }
+        if (!pid)
+          {
+             status = _mode_run(argc, argv, i == 1);
+             fflush(stdout);
+             _exit(status);
+          }
+
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != EXIT_SUCCESS)
+           ret = EXIT_FAILURE;
+     }
+
+   ecore_file_recursive_rm(dir);
+   return ret;
+}
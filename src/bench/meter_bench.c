@@ -0,0 +1,152 @@
+#include <common.h>
+#include <epulse.h>
+
+#include <time.h>
+
+/*
+ * Measures the CPU the process uses with BENCH_METERS live meter
+ * widgets, as many as rows with 30 streams, against the same process
+ * with none. Every meter is a peak-detect record stream on the monitor
+ * of the default sink, which costs the client what a stream meter does.
+ * The bench fails when the meters cost more than BENCH_CPU_TARGET
+ * percent of one core.
+ *
+ * Needs a running PulseAudio server, the bench is skipped without one.
+ * Drawing goes to the buffer engine unless ELM_ENGINE says otherwise.
+ */
+
+#define BENCH_METERS 30
+#define BENCH_TIME 5.0
+#define BENCH_CONNECT_TIMEOUT 5.0
+#define BENCH_CPU_TARGET 1.0 /* percent */
+
+static int _sink = -1;
+static Ecore_Timer *_timeout = NULL;
+
+static double
+_cpu_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static Eina_Bool
+_sink_default_cb(void *data EINA_UNUSED, int type EINA_UNUSED, void *info)
+{
+   Epulse_Event_Sink *ev = info;
+
+   /* the one replayed from the state cache comes before the connection */
+   _sink = ev->base.index;
+   if (epulse_connected_get())
+      ecore_main_loop_quit();
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool
+_quit_cb(void *data EINA_UNUSED)
+{
+   ecore_main_loop_quit();
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool
+_timeout_cb(void *data EINA_UNUSED)
+{
+   _timeout = NULL;
+   ecore_main_loop_quit();
+   return ECORE_CALLBACK_CANCEL;
+}
+
+/* percent of one core used while the loop runs for BENCH_TIME */
+static double
+_cpu_measure(void)
+{
+   double cpu = _cpu_now(), wall = ecore_time_get();
+
+   ecore_timer_add(BENCH_TIME, _quit_cb, NULL);
+   ecore_main_loop_begin();
+
+   return (_cpu_now() - cpu) * 100.0 / (ecore_time_get() - wall);
+}
+
+int
+main(int argc, char *argv[])
+{
+   Ecore_Event_Handler *handler;
+   Evas_Object *win, *box, *bar;
+   double idle, meters;
+   unsigned int i;
+   int ret = EXIT_SUCCESS;
+
+   setenv("ELM_ENGINE", "buffer", 0);
+
+   if (!epulse_common_init("meter_bench"))
+      return EXIT_FAILURE;
+   elm_init(argc, argv);
+
+   if (epulse_init() <= 0)
+     {
+        printf("No PulseAudio server, meter bench skipped\n");
+        goto end;
+     }
+
+   handler = ecore_event_handler_add(SINK_DEFAULT, _sink_default_cb, NULL);
+   _timeout = ecore_timer_add(BENCH_CONNECT_TIMEOUT, _timeout_cb, NULL);
+   ecore_main_loop_begin();
+   ecore_event_handler_del(handler);
+   if (_timeout)
+      ecore_timer_del(_timeout);
+   if (_sink < 0 || !epulse_connected_get())
+     {
+        printf("No default sink, meter bench skipped\n");
+        epulse_shutdown();
+        goto end;
+     }
+
+   win = elm_win_add(NULL, "meter_bench", ELM_WIN_BASIC);
+   EINA_SAFETY_ON_NULL_GOTO(win, err);
+   evas_object_resize(win, 320, 20 * BENCH_METERS);
+   box = elm_box_add(win);
+   evas_object_size_hint_weight_set(box, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   elm_win_resize_object_add(win, box);
+   evas_object_show(box);
+   evas_object_show(win);
+
+   idle = _cpu_measure();
+
+   for (i = 0; i < BENCH_METERS; i++)
+     {
+        bar = epulse_meter_widget_add(box, EPULSE_METER_SINK, _sink);
+        elm_box_pack_end(box, bar);
+        evas_object_show(bar);
+     }
+   meters = _cpu_measure();
+
+   printf("%u meters at %u updates/s\n", BENCH_METERS,
+          epulse_meter_rate_get());
+   printf("%-10s %10s\n", "meters", "cpu (%)");
+   printf("%-10u %10.2f\n", 0, idle);
+   printf("%-10u %10.2f\n", BENCH_METERS, meters);
+   if (meters - idle > BENCH_CPU_TARGET)
+     {
+        printf("Meters use %.2f%% of a core, the target is below %.2f%%\n",
+               meters - idle, BENCH_CPU_TARGET);
+        ret = EXIT_FAILURE;
+     }
+
+   evas_object_del(win);
+   epulse_shutdown();
+ end:
+   elm_shutdown();
+   epulse_common_shutdown();
+   return ret;
+
+ err:
+   epulse_shutdown();
+   elm_shutdown();
+   epulse_common_shutdown();
+   return EXIT_FAILURE;
+}
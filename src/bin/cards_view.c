@@ -0,0 +1,367 @@
+#include "cards_view.h"
+
+#include "epulse.h"
+#include "icon_cache.h"
+#include "name_filter.h"
+
+#define CARDS_KEY "cards.key"
+#define ICON_SIZE 40 /* the icon part of the row */
+
+struct Card
+{
+   int index;
+   const char *name;
+   const char *icon;
+   /* copy of the event table, the strings are stringshares */
+   Epulse_Card_Profile *profiles;
+   unsigned int profile_count;
+   int active;
+
+   Elm_Object_Item *item;
+};
+
+struct Cards_View
+{
+   Evas_Object *self;
+   Evas_Object *genlist;
+   Elm_Genlist_Item_Class *itc;
+
+   Eina_List *cards;
+   Ecore_Event_Handler *disconnected;
+   Ecore_Event_Handler *card_added;
+   Ecore_Event_Handler *card_changed;
+   Ecore_Event_Handler *card_removed;
+};
+
+static void
+_card_profiles_free(struct Card *card)
+{
+   unsigned int i;
+
+   for (i = 0; i < card->profile_count; i++)
+     {
+        eina_stringshare_del(card->profiles[i].name);
+        eina_stringshare_del(card->profiles[i].description);
+     }
+   free(card->profiles);
+   card->profiles = NULL;
+   card->profile_count = 0;
+   card->active = -1;
+}
+
+static void
+_card_profiles_set(struct Card *card, const Epulse_Event_Card *ev)
+{
+   unsigned int i;
+
+   _card_profiles_free(card);
+   if (!ev->profile_count)
+      return;
+
+   card->profiles = malloc(ev->profile_count * sizeof(Epulse_Card_Profile));
+   EINA_SAFETY_ON_NULL_RETURN(card->profiles);
+
+   memcpy(card->profiles, ev->profiles,
+          ev->profile_count * sizeof(Epulse_Card_Profile));
+   for (i = 0; i < ev->profile_count; i++)
+     {
+        eina_stringshare_ref(card->profiles[i].name);
+        eina_stringshare_ref(card->profiles[i].description);
+     }
+   card->profile_count = ev->profile_count;
+   card->active = ev->active;
+}
+
+static const char *
+_card_active_description(const struct Card *card)
+{
+   if (card->active < 0 || (unsigned int)card->active >= card->profile_count)
+      return NULL;
+
+   return card->profiles[card->active].description;
+}
+
+static Eina_Bool
+_disconnected_cb(void *data, int type EINA_UNUSED, void *info EINA_UNUSED)
+{
+   struct Cards_View *cv = data;
+   struct Card *card;
+
+   EINA_LIST_FREE(cv->cards, card)
+      elm_object_item_del(card->item);
+   name_filter_clear(cv->genlist);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool
+_card_add_cb(void *data, int type EINA_UNUSED, void *info)
+{
+   struct Cards_View *cv = data;
+   Epulse_Event_Card *ev = info;
+   struct Card *card = calloc(1, sizeof(struct Card));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(card, ECORE_CALLBACK_PASS_ON);
+
+   card->index = ev->index;
+   card->name = eina_stringshare_add(ev->name);
+   card->icon = eina_stringshare_add(ev->icon);
+   _card_profiles_set(card, ev);
+
+   cv->cards = eina_list_append(cv->cards, card);
+   name_filter_row_set(cv->genlist, card, card->name);
+   card->item = elm_genlist_item_append(cv->genlist, cv->itc, card, NULL,
+                                        ELM_GENLIST_ITEM_NONE, NULL, cv);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool
+_card_removed_cb(void *data, int type EINA_UNUSED, void *info)
+{
+   struct Cards_View *cv = data;
+   Epulse_Event_Card *ev = info;
+   Eina_List *l, *ll;
+   struct Card *card;
+
+   EINA_LIST_FOREACH_SAFE(cv->cards, l, ll, card)
+     {
+        if (card->index == ev->index)
+          {
+             cv->cards = eina_list_remove_list(cv->cards, l);
+             name_filter_row_del(cv->genlist, card);
+             elm_object_item_del(card->item);
+             break;
+          }
+     }
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool
+_card_changed_cb(void *data, int type EINA_UNUSED, void *info)
+{
+   struct Cards_View *cv = data;
+   Epulse_Event_Card *ev = info;
+   Evas_Object *item;
+   Eina_List *l;
+   struct Card *card;
+
+   EINA_LIST_FOREACH(cv->cards, l, card)
+     {
+        if (card->index != ev->index)
+           continue;
+
+        if (ev->changed & EPULSE_CHANGE_NAME)
+          {
+             eina_stringshare_replace(&card->name, ev->name);
+             name_filter_row_set(cv->genlist, card, card->name);
+             elm_genlist_item_fields_update(card->item, "name",
+                                            ELM_GENLIST_ITEM_FIELD_TEXT);
+          }
+
+        if (ev->changed & EPULSE_CHANGE_ICON)
+          {
+             eina_stringshare_replace(&card->icon, ev->icon);
+             elm_genlist_item_fields_update(card->item, "icon",
+                                            ELM_GENLIST_ITEM_FIELD_CONTENT);
+          }
+
+        /* a profile switch only relabels the hoversel, the items of the
+         * table stay valid as long as the table did not change */
+        if (ev->changed & EPULSE_CHANGE_PROFILES)
+          {
+             _card_profiles_set(card, ev);
+             elm_genlist_item_fields_update(card->item, "hover",
+                                            ELM_GENLIST_ITEM_FIELD_CONTENT);
+          }
+        else if (ev->changed & EPULSE_CHANGE_ACTIVE_PROFILE)
+          {
+             card->active = ev->active;
+             item = elm_object_item_part_content_get(card->item, "hover");
+             if (item)
+                elm_object_text_set(item, _card_active_description(card));
+          }
+
+        break;
+     }
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static void
+_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *o EINA_UNUSED,
+        void *event_info EINA_UNUSED)
+{
+   struct Cards_View *cv = data;
+
+   eina_list_free(cv->cards);
+   if (cv->card_added)
+     {
+        ecore_event_handler_del(cv->card_added);
+        cv->card_added = NULL;
+     }
+   if (cv->card_changed)
+     {
+        ecore_event_handler_del(cv->card_changed);
+        cv->card_changed = NULL;
+     }
+   if (cv->card_removed)
+     {
+        ecore_event_handler_del(cv->card_removed);
+        cv->card_removed = NULL;
+     }
+   if (cv->disconnected)
+     {
+        ecore_event_handler_del(cv->disconnected);
+        cv->disconnected = NULL;
+     }
+   elm_genlist_item_class_free(cv->itc);
+   free(cv);
+}
+
+static char *
+_item_text_get(void *data, Evas_Object *obj EINA_UNUSED, const char *part)
+{
+   struct Card *card = data;
+
+   if (!strcmp(part, "name"))
+      return card->name ? strdup(card->name) : NULL;
+
+   return NULL;
+}
+
+static void
+_item_del(void *data, Evas_Object *obj EINA_UNUSED)
+{
+   struct Card *card = data;
+
+   eina_stringshare_del(card->name);
+   eina_stringshare_del(card->icon);
+   _card_profiles_free(card);
+   free(card);
+}
+
+static void
+_profile_selected_cb(void *data, Evas_Object *o EINA_UNUSED,
+                     void *event_info)
+{
+   struct Card *card = data;
+   unsigned int i = (uintptr_t)elm_object_item_data_get(event_info);
+
+   if (i >= card->profile_count || (int)i == card->active)
+      return;
+
+   /* the label follows once the server reports the switch, a refused
+    * one leaves it showing the profile still in use */
+   if (!epulse_card_profile_set(card->index, card->profiles[i].name))
+      ERR("Could not change the profile of card %d", card->index);
+}
+
+static Evas_Object *
+_item_content_get(void *data, Evas_Object *obj, const char *part)
+{
+   Evas_Object *item = NULL;
+   Elm_Object_Item *it;
+   struct Card *card = data;
+   unsigned int i;
+
+   if (!strcmp(part, "icon"))
+     {
+        item = icon_cache_icon_add(obj, card->icon, ICON_SIZE);
+     }
+   else if (!strcmp(part, "hover"))
+     {
+        if (!card->profile_count)
+           return NULL;
+
+        item = elm_hoversel_add(obj);
+        EINA_SAFETY_ON_NULL_RETURN_VAL(item, NULL);
+
+        for (i = 0; i < card->profile_count; i++)
+          {
+             it = elm_hoversel_item_add(item, card->profiles[i].description,
+                                        NULL, ELM_ICON_NONE, NULL,
+                                        (void *)(uintptr_t)i);
+             if (!card->profiles[i].available)
+                elm_object_item_disabled_set(it, EINA_TRUE);
+          }
+        elm_object_text_set(item, _card_active_description(card));
+        evas_object_smart_callback_add(item, "selected",
+                                       _profile_selected_cb, card);
+     }
+
+   return item;
+}
+
+#ifdef EPULSE_GENLIST_FILTER
+static Eina_Bool
+_item_filter_get(void *data, Evas_Object *obj, void *key EINA_UNUSED)
+{
+   return name_filter_match(obj, data);
+}
+#endif
+
+void
+cards_view_filter_set(Evas_Object *obj, const char *query)
+{
+   struct Cards_View *cv = evas_object_data_get(obj, CARDS_KEY);
+
+   EINA_SAFETY_ON_NULL_RETURN(cv);
+
+   name_filter_query_set(cv->genlist, query);
+}
+
+Evas_Object *
+cards_view_add(Evas_Object *parent)
+{
+   Evas_Object *layout;
+   struct Cards_View *cv;
+
+   cv = calloc(1, sizeof(struct Cards_View));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(cv, NULL);
+
+   layout = epulse_layout_add(parent, "cards", "default");
+   EINA_SAFETY_ON_NULL_GOTO(layout, err);
+   cv->self = layout;
+
+   cv->genlist = elm_genlist_add(layout);
+   EINA_SAFETY_ON_NULL_GOTO(cv->genlist, err_genlist);
+   elm_genlist_homogeneous_set(cv->genlist, EINA_TRUE);
+   name_filter_add(cv->genlist);
+
+   cv->itc = elm_genlist_item_class_new();
+   EINA_SAFETY_ON_NULL_GOTO(cv->itc, err_genlist);
+   cv->itc->item_style = "cards";
+   cv->itc->func.text_get = _item_text_get;
+   cv->itc->func.content_get = _item_content_get;
+#ifdef EPULSE_GENLIST_FILTER
+   cv->itc->func.filter_get = _item_filter_get;
+#endif
+   cv->itc->func.del = _item_del;
+
+   cv->disconnected = ecore_event_handler_add(DISCONNECTED,
+                                              _disconnected_cb, cv);
+   cv->card_added = ecore_event_handler_add(CARD_ADDED, _card_add_cb, cv);
+   cv->card_changed = ecore_event_handler_add(CARD_CHANGED,
+                                              _card_changed_cb, cv);
+   cv->card_removed = ecore_event_handler_add(CARD_REMOVED,
+                                              _card_removed_cb, cv);
+
+   evas_object_event_callback_add(layout, EVAS_CALLBACK_DEL, _del_cb, cv);
+   evas_object_data_set(layout, CARDS_KEY, cv);
+   elm_layout_content_set(layout, "list", cv->genlist);
+
+   evas_object_size_hint_weight_set(cv->genlist, EVAS_HINT_EXPAND,
+                                    EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(cv->genlist, EVAS_HINT_FILL,
+                                   EVAS_HINT_FILL);
+
+   return layout;
+
+ err_genlist:
+   evas_object_del(layout);
+ err:
+   free(cv);
+
+   return NULL;
+}
@@ -0,0 +1,13 @@
+#ifndef _CARDS_VIEW_H_
+#define _CARDS_VIEW_H_
+
+#include "common.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+Evas_Object *cards_view_add(Evas_Object *parent);
+void cards_view_filter_set(Evas_Object *obj, const char *query);
+
+#endif /* _CARDS_VIEW_H_ */
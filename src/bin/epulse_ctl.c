@@ -0,0 +1,93 @@
+#include <common.h>
+#include <epulse.h>
+
+/*
+ * Sends its arguments as one command to the mixer serving the control
+ * socket and prints the reply, see src/lib/epulse_ctl.c for the commands.
+ */
+
+static int _status = EXIT_FAILURE;
+static Eina_Bool _finished = EINA_FALSE;
+
+static Eina_Bool
+_reply_cb(void *data EINA_UNUSED, const char *line)
+{
+   if (!strcmp(line, "ok"))
+     {
+        _status = EXIT_SUCCESS;
+        return EINA_FALSE;
+     }
+
+   if (!strncmp(line, "error", 5))
+     {
+        fprintf(stderr, "epulse-ctl: %s\n", line[5] ? line + 6 : "failed");
+        return EINA_FALSE;
+     }
+
+   printf("%s\n", line);
+   return EINA_TRUE;
+}
+
+static void
+_done_cb(void *data EINA_UNUSED, Eina_Bool delivered)
+{
+   if (!delivered)
+      fprintf(stderr, "epulse-ctl: no mixer is serving '%s'\n",
+              EPULSE_CTL_NAME);
+
+   /* also called before the main loop runs when nothing is listening */
+   _finished = EINA_TRUE;
+   ecore_main_loop_quit();
+}
+
+int
+main(int argc, char *argv[])
+{
+   Eina_Strbuf *command;
+   int i;
+
+   if (argc < 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))
+     {
+        fprintf(stderr, "Usage: %s <command> [arguments]\n"
+                "Commands:\n"
+                "  set-sink-volume <sink> <volume>\n"
+                "  set-sink-mute <sink> <1|0|toggle>\n"
+                "  set-source-volume <source> <volume>\n"
+                "  set-source-mute <source> <1|0|toggle>\n"
+                "  set-sink-input-volume <input> <volume>\n"
+                "  set-sink-input-mute <input> <1|0|toggle>\n"
+                "  move-sink-input <input> <sink>\n"
+                "  set-default-sink <sink>\n"
+                "  get-default-sink\n"
+                "  switch-output <sink>\n"
+                "  fade-sink-volume <sink> <volume> <ms>\n"
+                "  set-ducking <percent>\n"
+                "  list-sinks | list-sources | list-sink-inputs\n"
+                "  save-scene <name> | apply-scene <name>\n"
+                "  delete-scene <name> | list-scenes\n"
+                "  set-card-profile <card> <profile> | list-cards\n"
+                "Sinks may be given as @DEFAULT_SINK@, volumes are in "
+                "percent, absolute or +N/-N.\n", argv[0]);
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+     }
+
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(epulse_common_init("epulse-ctl"),
+                                   EXIT_FAILURE);
+
+   command = eina_strbuf_new();
+   for (i = 1; i < argc; i++)
+     {
+        if (i > 1)
+           eina_strbuf_append_char(command, ' ');
+        eina_strbuf_append(command, argv[i]);
+     }
+
+   epulse_ipc_request(EPULSE_CTL_NAME, eina_strbuf_string_get(command),
+                      _reply_cb, _done_cb, NULL);
+   if (!_finished)
+      ecore_main_loop_begin();
+
+   eina_strbuf_free(command);
+   epulse_common_shutdown();
+   return _status;
+}
@@ -0,0 +1,221 @@
+#include "icon_cache.h"
+
+#include <Efreet.h>
+
+/*
+ * Process wide cache of icon theme lookups, by icon name and size.
+ *
+ * Resolving a freedesktop icon name walks the icon theme directories,
+ * which takes milliseconds with big themes. Rows get their icon from
+ * here instead: a known name is set right away from its path, an
+ * unknown one shows the placeholder while it is looked up, and the
+ * icons still alive are updated once the answer is there.
+ * Lookups are done from an idler, a few milliseconds at a time, on the
+ * main loop: efreet is not thread safe and E uses it from there too.
+ */
+
+#define ICON_PLACEHOLDER "audio-card"
+#define LOOKUP_SLICE 0.004 /* seconds of lookups per idler run */
+
+typedef struct _Icon_Entry Icon_Entry;
+struct _Icon_Entry
+{
+   const char *name;
+   int size;
+   char *path;         /* NULL when the theme does not have it */
+   Eina_Bool resolved;
+   Eina_Bool queued;
+   Eina_List *waiters; /* icons showing the placeholder meanwhile */
+};
+
+static Eina_Hash *_entries = NULL;
+static Eina_List *_queue = NULL;
+static Ecore_Idler *_idler = NULL;
+
+static void
+_entry_free_cb(void *data)
+{
+   Icon_Entry *entry = data;
+
+   eina_list_free(entry->waiters);
+   eina_stringshare_del(entry->name);
+   free(entry->path);
+   free(entry);
+}
+
+static Icon_Entry *
+_entry_get(const char *name, int size)
+{
+   Icon_Entry *entry;
+   char key[256];
+
+   snprintf(key, sizeof(key), "%s@%d", name, size);
+   entry = eina_hash_find(_entries, key);
+   if (entry)
+      return entry;
+
+   entry = calloc(1, sizeof(Icon_Entry));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(entry, NULL);
+
+   entry->name = eina_stringshare_add(name);
+   entry->size = size;
+   eina_hash_add(_entries, key, entry);
+
+   return entry;
+}
+
+static void
+_icon_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj,
+             void *event_info EINA_UNUSED)
+{
+   Icon_Entry *entry = data;
+
+   entry->waiters = eina_list_remove(entry->waiters, obj);
+}
+
+/* shows the resolved placeholder, if any, while name is looked up */
+static void
+_placeholder_set(Evas_Object *icon, int size)
+{
+   Icon_Entry *entry = _entry_get(ICON_PLACEHOLDER, size);
+
+   if (entry && entry->resolved && entry->path)
+      elm_image_file_set(icon, entry->path, NULL);
+}
+
+static void
+_entry_resolve(Icon_Entry *entry, const char *theme)
+{
+   const char *path;
+   Evas_Object *icon;
+
+   path = efreet_icon_path_find(theme, entry->name, entry->size);
+   entry->path = path ? strdup(path) : NULL;
+   entry->resolved = EINA_TRUE;
+   entry->queued = EINA_FALSE;
+
+   EINA_LIST_FREE(entry->waiters, icon)
+     {
+        evas_object_event_callback_del_full(icon, EVAS_CALLBACK_DEL,
+                                            _icon_del_cb, entry);
+        if (entry->path)
+           elm_image_file_set(icon, entry->path, NULL);
+        else
+           _placeholder_set(icon, entry->size);
+     }
+}
+
+static Eina_Bool
+_lookup_idler_cb(void *data EINA_UNUSED)
+{
+   const char *theme = elm_config_icon_theme_get();
+   double start = ecore_time_get();
+   unsigned int count = 0;
+   Icon_Entry *entry;
+
+   /* the elementary theme is not an icon theme */
+   if (!theme || theme[0] == '_')
+      theme = "hicolor";
+
+   /* at least one per run, so a slow theme still gets through */
+   while (_queue && (!count || ecore_time_get() - start < LOOKUP_SLICE))
+     {
+        entry = eina_list_data_get(_queue);
+        _queue = eina_list_remove_list(_queue, _queue);
+        _entry_resolve(entry, theme);
+        count++;
+     }
+
+   DBG("Resolved %u icons in %.2f ms", count,
+       (ecore_time_get() - start) * 1000.0);
+
+   if (_queue)
+      return ECORE_CALLBACK_RENEW;
+
+   _idler = NULL;
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static void
+_entry_request(Icon_Entry *entry)
+{
+   if (entry->resolved || entry->queued)
+      return;
+
+   entry->queued = EINA_TRUE;
+   _queue = eina_list_append(_queue, entry);
+   /* rows realized in the same frame are served once it is drawn */
+   if (!_idler)
+      _idler = ecore_idler_add(_lookup_idler_cb, NULL);
+}
+
+/*
+ * Returns an icon showing name at size pixels, or the placeholder until
+ * the name is resolved.
+ */
+Evas_Object *
+icon_cache_icon_add(Evas_Object *parent, const char *name, int size)
+{
+   Evas_Object *icon;
+   Icon_Entry *entry;
+
+   if (!_entries)
+     {
+        _entries = eina_hash_string_superfast_new(_entry_free_cb);
+        _entry_request(_entry_get(ICON_PLACEHOLDER, size));
+     }
+
+   icon = elm_icon_add(parent);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(icon, NULL);
+
+   entry = _entry_get(name ? name : ICON_PLACEHOLDER, size);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(entry, icon);
+
+   if (entry->resolved)
+     {
+        if (entry->path)
+           elm_image_file_set(icon, entry->path, NULL);
+        else
+           _placeholder_set(icon, size);
+        return icon;
+     }
+
+   _placeholder_set(icon, size);
+   entry->waiters = eina_list_append(entry->waiters, icon);
+   evas_object_event_callback_add(icon, EVAS_CALLBACK_DEL, _icon_del_cb,
+                                  entry);
+   _entry_request(entry);
+
+   return icon;
+}
+
+void
+icon_cache_shutdown(void)
+{
+   Icon_Entry *entry;
+   Evas_Object *icon;
+   Eina_Iterator *it;
+
+   if (!_entries)
+      return;
+
+   /* the idler runs code of the module, which may be unloaded next */
+   if (_idler)
+     {
+        ecore_idler_del(_idler);
+        _idler = NULL;
+     }
+   _queue = eina_list_free(_queue);
+
+   it = eina_hash_iterator_data_new(_entries);
+   EINA_ITERATOR_FOREACH(it, entry)
+     {
+        EINA_LIST_FREE(entry->waiters, icon)
+           evas_object_event_callback_del_full(icon, EVAS_CALLBACK_DEL,
+                                               _icon_del_cb, entry);
+     }
+   eina_iterator_free(it);
+
+   eina_hash_free(_entries);
+   _entries = NULL;
+}
@@ -0,0 +1,14 @@
+#ifndef _ICON_CACHE_H_
+#define _ICON_CACHE_H_
+
+#include "common.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+Evas_Object *icon_cache_icon_add(Evas_Object *parent, const char *name,
+                                 int size);
+void icon_cache_shutdown(void);
+
+#endif /* _ICON_CACHE_H_ */
@@ -1,27 +1,140 @@
 #include <common.h>
 #include <epulse.h>
 #include "main_window.h"
+#include "monitor.h"
+#include "icon_cache.h"
 
 #define DEFAULT_HEIGHT 600
 #define DEFAULT_WIDTH 800
 
+static Evas_Object *_win = NULL;
+static Eina_Bool _resident = EINA_FALSE;
+static Eina_Bool _monitor = EINA_FALSE;
+static Eina_Bool _forwarded = EINA_FALSE;
+
+static void
+_win_show(void)
+{
+   evas_object_show(_win);
+   elm_win_raise(_win);
+   elm_win_activate(_win);
+}
+
+static void
+_ipc_command_cb(void *data EINA_UNUSED, Epulse_Ipc_Client *client EINA_UNUSED,
+                const char *command)
+{
+   if (!_win)
+      return;
+
+   if (!strcmp(command, "show"))
+      _win_show();
+   else if (!strcmp(command, "hide"))
+     {
+        if (_resident)
+           evas_object_hide(_win);
+     }
+   else if (!strcmp(command, "toggle"))
+     {
+        if (evas_object_visible_get(_win) && _resident)
+           evas_object_hide(_win);
+        else
+           _win_show();
+     }
+   else if (!strcmp(command, "quit"))
+      elm_exit();
+   else
+      WRN("Unknown command: %s", command);
+}
+
+static void
+_ipc_forward_cb(void *data EINA_UNUSED, Eina_Bool delivered)
+{
+   _forwarded = delivered;
+   elm_exit();
+}
+
+/* headless, prints the events as JSON lines until interrupted */
+static int
+_monitor_run(void)
+{
+   EINA_SAFETY_ON_FALSE_GOTO(epulse_init() > 0, err);
+
+   if (monitor_start())
+      elm_run();
+
+   monitor_stop();
+   epulse_shutdown();
+   epulse_common_shutdown();
+   return 0;
+
+ err:
+   epulse_common_shutdown();
+   return EXIT_FAILURE;
+}
+
 EAPI int
-elm_main(int argc EINA_UNUSED, char *argv[]  EINA_UNUSED)
+elm_main(int argc, char *argv[])
 {
-   Evas_Object *win;
+   Epulse_Ipc *ipc, *ctl;
+   int i;
+
+   for (i = 1; i < argc; i++)
+     {
+        if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--resident"))
+           _resident = EINA_TRUE;
+        else if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "--monitor"))
+           _monitor = EINA_TRUE;
+        else
+          {
+             fprintf(stderr, "Usage: %s [-r|--resident] [-m|--monitor]\n",
+                     argv[0]);
+             return EXIT_FAILURE;
+          }
+     }
 
    EINA_SAFETY_ON_FALSE_RETURN_VAL(epulse_common_init("epulse"), EXIT_FAILURE);
-   EINA_SAFETY_ON_FALSE_RETURN_VAL(epulse_init() > 0, EXIT_FAILURE);
 
-   win = main_window_add();
-   evas_object_resize(win, DEFAULT_WIDTH, DEFAULT_HEIGHT);
-   evas_object_show(win);
+   if (_monitor)
+      return _monitor_run();
+
+   /* Only one mixer per user, a running one is asked to show itself */
+   ipc = epulse_ipc_server_add(EPULSE_IPC_NAME, _ipc_command_cb, NULL);
+   if (!ipc)
+     {
+        epulse_ipc_send("show", _ipc_forward_cb, NULL);
+        elm_run();
+        if (_forwarded)
+          {
+             epulse_common_shutdown();
+             return 0;
+          }
+        WRN("Could not reach the running instance, starting a new one");
+     }
+
+   EINA_SAFETY_ON_FALSE_GOTO(epulse_init() > 0, err);
+
+   /* the module serves epulse-ctl when it is loaded */
+   ctl = epulse_ctl_server_add();
+
+   _win = main_window_add();
+   main_window_resident_set(_win, _resident);
+   evas_object_resize(_win, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+   evas_object_show(_win);
 
    elm_run();
 
+   icon_cache_shutdown();
+   epulse_ipc_server_del(ctl);
+   epulse_ipc_server_del(ipc);
    epulse_common_shutdown();
    epulse_shutdown();
    return 0;
+
+ err:
+   epulse_ipc_server_del(ipc);
+   epulse_common_shutdown();
+   return EXIT_FAILURE;
 }
 
 /*
@@ -4,107 +4,124 @@
 #include "playbacks_view.h"
 #include "sinks_view.h"
 #include "sources_view.h"
+#include "cards_view.h"
 
 #define MAIN_WINDOW_DATA "mainwindow.data"
+#define MAIN_CONTENT_DATA "maincontent.data"
 
 enum MAIN_SUBVIEWS {
    PLAYBACKS,
    OUTPUTS,
-   INPUTS
+   INPUTS,
+   CARDS
 };
 
-typedef struct _Main_Window Main_Window;
-struct _Main_Window
+/* Toolbar and the four views, usable inside any window or dialog */
+typedef struct _Main_Content Main_Content;
+struct _Main_Content
 {
-   Evas_Object *win;
+   Evas_Object *box;
    Evas_Object *toolbar;
+   Evas_Object *search;
    Evas_Object *layout;
    Evas_Object *naviframe;
    Evas_Object *playbacks;
    Evas_Object *inputs;
    Evas_Object *outputs;
-   Elm_Object_Item *toolbar_items[3];
-   Elm_Object_Item *views[3];
+   Evas_Object *cards;
+   Elm_Object_Item *toolbar_items[4];
+   Elm_Object_Item *views[4];
+};
+
+typedef struct _Main_Window Main_Window;
+struct _Main_Window
+{
+   Evas_Object *win;
+   Evas_Object *content;
+
+   /* closing only hides the window, the process keeps running */
+   Eina_Bool resident;
 };
 
 static void
 _del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *o EINA_UNUSED,
         void *event_info EINA_UNUSED)
 {
-   Main_Window *mw = data;
-
-   free(mw);
+   free(data);
 }
 
 static void
-_delete_request_cb(void *data EINA_UNUSED, Evas_Object *o EINA_UNUSED,
+_delete_request_cb(void *data, Evas_Object *o EINA_UNUSED,
                    void *event_info EINA_UNUSED)
 {
-   elm_exit();
+   Main_Window *mw = data;
+
+   if (mw->resident)
+      evas_object_hide(mw->win);
+   else
+      elm_exit();
 }
 
 static void
 _toolbar_item_cb(void *data, Evas_Object *obj EINA_UNUSED,
                  void *event_info EINA_UNUSED)
 {
-   Main_Window *mw = data;
+   Main_Content *mw = data;
    Elm_Object_Item *it = elm_toolbar_selected_item_get(obj);
 
    if (!mw->views[PLAYBACKS] || !mw->views[OUTPUTS] ||
-       !mw->views[INPUTS])
+       !mw->views[INPUTS] || !mw->views[CARDS])
       return;
 
    if (it == mw->toolbar_items[PLAYBACKS])
       elm_naviframe_item_promote(mw->views[PLAYBACKS]);
    else if (it == mw->toolbar_items[OUTPUTS])
       elm_naviframe_item_promote(mw->views[OUTPUTS]);
+   else if (it == mw->toolbar_items[CARDS])
+      elm_naviframe_item_promote(mw->views[CARDS]);
    else
       elm_naviframe_item_promote(mw->views[INPUTS]);
 }
 
+#ifdef EPULSE_GENLIST_FILTER
+/* filters the four views at once, every key press */
+static void
+_search_changed_cb(void *data, Evas_Object *obj,
+                   void *event_info EINA_UNUSED)
+{
+   Main_Content *mw = data;
+   char *query = elm_entry_markup_to_utf8(elm_object_text_get(obj));
+
+   playbacks_view_filter_set(mw->playbacks, query);
+   sinks_view_filter_set(mw->outputs, query);
+   sources_view_filter_set(mw->inputs, query);
+   cards_view_filter_set(mw->cards, query);
+   free(query);
+}
+#endif
+
 Evas_Object *
-main_window_add(void)
+main_window_content_add(Evas_Object *parent)
 {
-   Main_Window *mw;
-   Evas_Object *tmp, *box, *icon;
-   char buf[4096];
+   Main_Content *mw;
+   Evas_Object *tmp, *box;
 
-   elm_theme_extension_add(NULL, EPULSE_THEME);
-   mw = calloc(1, sizeof(Main_Window));
+   mw = calloc(1, sizeof(Main_Content));
    if (!mw)
      {
-        ERR("Could not allocate memmory to main window");
+        ERR("Could not allocate memmory to main content");
         return NULL;
      }
 
-   tmp = elm_win_add(NULL, PACKAGE_NAME, ELM_WIN_BASIC);
-   EINA_SAFETY_ON_NULL_GOTO(tmp, win_err);
-   evas_object_data_set(tmp, MAIN_WINDOW_DATA, mw);
-   evas_object_event_callback_add(tmp, EVAS_CALLBACK_DEL, _del_cb, mw);
-   elm_win_autodel_set(tmp, EINA_TRUE);
-   elm_win_title_set(tmp, _("Efl Volume Control"));
-   mw->win = tmp;
-
-   icon = evas_object_image_add(evas_object_evas_get(mw->win));
-   snprintf(buf, sizeof(buf), "%s/icons/terminology.png",
-            elm_app_data_dir_get());
-   evas_object_image_file_set(icon, buf, NULL);
-   elm_win_icon_object_set(mw->win, icon);
-   elm_win_icon_name_set(mw->win, "epulse");
-
-   tmp = elm_bg_add(mw->win);
-   evas_object_size_hint_weight_set(tmp, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
-   evas_object_size_hint_align_set(tmp, EVAS_HINT_FILL, EVAS_HINT_FILL);
-   elm_win_resize_object_add(mw->win, tmp);
-   evas_object_show(tmp);
-
-   box = elm_box_add(mw->win);
+   box = elm_box_add(parent);
+   EINA_SAFETY_ON_NULL_GOTO(box, box_err);
+   evas_object_data_set(box, MAIN_CONTENT_DATA, mw);
+   evas_object_event_callback_add(box, EVAS_CALLBACK_DEL, _del_cb, mw);
    evas_object_size_hint_weight_set(box, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
    elm_box_horizontal_set(box, EINA_FALSE);
-   elm_win_resize_object_add(mw->win, box);
-   evas_object_show(box);
+   mw->box = box;
 
-   tmp = elm_toolbar_add(mw->win);
+   tmp = elm_toolbar_add(box);
    evas_object_size_hint_weight_set(tmp, EVAS_HINT_EXPAND, 0);
    evas_object_size_hint_align_set(tmp, EVAS_HINT_FILL, EVAS_HINT_FILL);
    elm_toolbar_select_mode_set(tmp, ELM_OBJECT_SELECT_MODE_ALWAYS);
@@ -112,7 +129,21 @@ main_window_add(void)
    mw->toolbar = tmp;
    evas_object_show(tmp);
 
-   tmp = elm_naviframe_add(mw->win);
+#ifdef EPULSE_GENLIST_FILTER
+   tmp = elm_entry_add(box);
+   elm_entry_single_line_set(tmp, EINA_TRUE);
+   elm_entry_scrollable_set(tmp, EINA_TRUE);
+   elm_object_part_text_set(tmp, "guide", _("Search"));
+   evas_object_size_hint_weight_set(tmp, EVAS_HINT_EXPAND, 0);
+   evas_object_size_hint_align_set(tmp, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   evas_object_smart_callback_add(tmp, "changed,user", _search_changed_cb,
+                                  mw);
+   elm_box_pack_end(box, tmp);
+   mw->search = tmp;
+   evas_object_show(tmp);
+#endif
+
+   tmp = elm_naviframe_add(box);
    elm_object_style_set(tmp, "no_transition");
    elm_naviframe_prev_btn_auto_pushed_set(tmp, EINA_FALSE);
    evas_object_size_hint_weight_set(tmp, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
@@ -130,12 +161,12 @@ main_window_add(void)
    mw->toolbar_items[2] = elm_toolbar_item_append(mw->toolbar, NULL,
                                                   _("Inputs"),
                                                   _toolbar_item_cb, mw);
-
-   evas_object_smart_callback_add(mw->win, "delete,request",
-                                  _delete_request_cb, mw);
+   mw->toolbar_items[3] = elm_toolbar_item_append(mw->toolbar, NULL,
+                                                  _("Cards"),
+                                                  _toolbar_item_cb, mw);
 
    /* Creating the playbacks view */
-   mw->playbacks = playbacks_view_add(mw->win);
+   mw->playbacks = playbacks_view_add(box);
    evas_object_size_hint_weight_set(mw->playbacks, EVAS_HINT_EXPAND,
                                     EVAS_HINT_EXPAND);
    evas_object_size_hint_align_set(mw->playbacks, EVAS_HINT_FILL,
@@ -143,19 +174,28 @@ main_window_add(void)
    evas_object_show(mw->playbacks);
 
    /* Creating the outputs view */
-   mw->outputs = sinks_view_add(mw->win);
+   mw->outputs = sinks_view_add(box);
    evas_object_size_hint_weight_set(mw->outputs, EVAS_HINT_EXPAND,
                                     EVAS_HINT_EXPAND);
    evas_object_size_hint_align_set(mw->outputs, EVAS_HINT_FILL, EVAS_HINT_FILL);
    evas_object_show(mw->outputs);
 
    /* Creating the inputs view */
-   mw->inputs = sources_view_add(mw->win);
+   mw->inputs = sources_view_add(box);
    evas_object_size_hint_weight_set(mw->inputs, EVAS_HINT_EXPAND,
                                     EVAS_HINT_EXPAND);
    evas_object_size_hint_align_set(mw->inputs, EVAS_HINT_FILL, EVAS_HINT_FILL);
    evas_object_show(mw->inputs);
 
+   /* Creating the cards view */
+   mw->cards = cards_view_add(box);
+   evas_object_size_hint_weight_set(mw->cards, EVAS_HINT_EXPAND,
+                                    EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(mw->cards, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   evas_object_show(mw->cards);
+
+   mw->views[CARDS] = elm_naviframe_item_simple_push(mw->naviframe,
+                                                     mw->cards);
    mw->views[INPUTS] = elm_naviframe_item_simple_push(mw->naviframe,
                                                       mw->inputs);
    mw->views[OUTPUTS] = elm_naviframe_item_simple_push(mw->naviframe,
@@ -163,9 +203,75 @@ main_window_add(void)
    mw->views[PLAYBACKS] = elm_naviframe_item_simple_push(mw->naviframe,
                                                          mw->playbacks);
 
+   return box;
+
+ box_err:
+   free(mw);
+   return NULL;
+}
+
+Evas_Object *
+main_window_add(void)
+{
+   Main_Window *mw;
+   Evas_Object *tmp, *icon;
+   char buf[4096];
+
+   elm_theme_extension_add(NULL, EPULSE_THEME);
+   mw = calloc(1, sizeof(Main_Window));
+   if (!mw)
+     {
+        ERR("Could not allocate memmory to main window");
+        return NULL;
+     }
+
+   tmp = elm_win_add(NULL, PACKAGE_NAME, ELM_WIN_BASIC);
+   EINA_SAFETY_ON_NULL_GOTO(tmp, win_err);
+   evas_object_data_set(tmp, MAIN_WINDOW_DATA, mw);
+   evas_object_event_callback_add(tmp, EVAS_CALLBACK_DEL, _del_cb, mw);
+   elm_win_autodel_set(tmp, EINA_TRUE);
+   elm_win_title_set(tmp, _("Efl Volume Control"));
+   mw->win = tmp;
+
+   icon = evas_object_image_add(evas_object_evas_get(mw->win));
+   snprintf(buf, sizeof(buf), "%s/icons/terminology.png",
+            elm_app_data_dir_get());
+   evas_object_image_file_set(icon, buf, NULL);
+   elm_win_icon_object_set(mw->win, icon);
+   elm_win_icon_name_set(mw->win, "epulse");
+
+   tmp = elm_bg_add(mw->win);
+   evas_object_size_hint_weight_set(tmp, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(tmp, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   elm_win_resize_object_add(mw->win, tmp);
+   evas_object_show(tmp);
+
+   evas_object_smart_callback_add(mw->win, "delete,request",
+                                  _delete_request_cb, mw);
+
+   mw->content = main_window_content_add(mw->win);
+   EINA_SAFETY_ON_NULL_GOTO(mw->content, content_err);
+   elm_win_resize_object_add(mw->win, mw->content);
+   evas_object_show(mw->content);
+
    return mw->win;
 
+ content_err:
+   /* the window DEL callback frees mw */
+   evas_object_del(mw->win);
+   return NULL;
  win_err:
    free(mw);
    return NULL;
 }
+
+void
+main_window_resident_set(Evas_Object *win, Eina_Bool resident)
+{
+   Main_Window *mw = evas_object_data_get(win, MAIN_WINDOW_DATA);
+
+   EINA_SAFETY_ON_NULL_RETURN(mw);
+
+   mw->resident = !!resident;
+   elm_win_autodel_set(mw->win, !mw->resident);
+}
@@ -8,5 +8,7 @@
 #endif
 
 Evas_Object *main_window_add(void);
+Evas_Object *main_window_content_add(Evas_Object *parent);
+void main_window_resident_set(Evas_Object *win, Eina_Bool resident);
 
 #endif /* _MAIN_WINDOW_H_ */
@@ -0,0 +1,240 @@
+#include "monitor.h"
+
+#include "epulse.h"
+
+/*
+ * Prints every libepulse event as one JSON object per line on stdout,
+ * with the details already resolved, for scripts that would otherwise
+ * run "pactl subscribe" and a "pactl list" per event:
+ *
+ *   {"event":"sink-input-changed","index":12,"name":"Firefox",
+ *    "volume":40,"mute":false,"changed":["volume"],"cached":false,
+ *    "sink":0,"corked":false,"pid":4242,"icon":"firefox",
+ *    "app":"Firefox","binary":"firefox","role":null}
+ *
+ * Objects restored from the last session are "cached" until the server
+ * confirms them with a changed event, or removes them; their index may
+ * be another object's by then. Removed objects only carry their index,
+ * "connected" and "disconnected" no object at all.
+ *
+ * The monitor only watches: it does not serve epulse-ctl, so it never
+ * ducks streams nor applies the application rules.
+ */
+
+typedef enum _Monitor_Kind
+{
+   MONITOR_SINK,
+   MONITOR_SINK_INPUT,
+   MONITOR_SOURCE,
+   MONITOR_REMOVED,
+   MONITOR_STATE
+} Monitor_Kind;
+
+typedef struct _Monitor_Event Monitor_Event;
+struct _Monitor_Event
+{
+   const int *type;
+   const char *name;
+   Monitor_Kind kind;
+};
+
+static const Monitor_Event _events[] = {
+   { &CONNECTED, "connected", MONITOR_STATE },
+   { &DISCONNECTED, "disconnected", MONITOR_STATE },
+   { &SINK_ADDED, "sink-added", MONITOR_SINK },
+   { &SINK_CHANGED, "sink-changed", MONITOR_SINK },
+   { &SINK_DEFAULT, "sink-default", MONITOR_SINK },
+   { &SINK_REMOVED, "sink-removed", MONITOR_REMOVED },
+   { &SINK_INPUT_ADDED, "sink-input-added", MONITOR_SINK_INPUT },
+   { &SINK_INPUT_CHANGED, "sink-input-changed", MONITOR_SINK_INPUT },
+   { &SINK_INPUT_REMOVED, "sink-input-removed", MONITOR_REMOVED },
+   { &SOURCE_ADDED, "source-added", MONITOR_SOURCE },
+   { &SOURCE_CHANGED, "source-changed", MONITOR_SOURCE },
+   { &SOURCE_REMOVED, "source-removed", MONITOR_REMOVED },
+   { NULL, NULL, 0 }
+};
+
+static const struct {
+   Epulse_Change bit;
+   const char *name;
+} _changes[] = {
+   { EPULSE_CHANGE_VOLUME, "volume" },
+   { EPULSE_CHANGE_MUTE, "mute" },
+   { EPULSE_CHANGE_PORTS, "ports" },
+   { EPULSE_CHANGE_ACTIVE_PORT, "active-port" },
+   { EPULSE_CHANGE_NAME, "name" },
+   { EPULSE_CHANGE_ICON, "icon" },
+   { EPULSE_CHANGE_SINK, "sink" },
+   { EPULSE_CHANGE_CORKED, "corked" },
+   { EPULSE_CHANGE_APP, "app" },
+   { EPULSE_CHANGE_NONE, NULL }
+};
+
+static Eina_List *_handlers = NULL;
+static Eina_Strbuf *_line = NULL;
+
+static void
+_json_string(Eina_Strbuf *buf, const char *str)
+{
+   const unsigned char *p;
+
+   if (!str)
+     {
+        eina_strbuf_append(buf, "null");
+        return;
+     }
+
+   eina_strbuf_append_char(buf, '"');
+   for (p = (const unsigned char *)str; *p; p++)
+     {
+        if (*p == '"' || *p == '\\')
+           eina_strbuf_append_printf(buf, "\\%c", *p);
+        else if (*p < 0x20)
+           eina_strbuf_append_printf(buf, "\\u%04x", *p);
+        else
+           eina_strbuf_append_char(buf, *p);
+     }
+   eina_strbuf_append_char(buf, '"');
+}
+
+static const char *
+_json_bool(Eina_Bool value)
+{
+   return value ? "true" : "false";
+}
+
+static void
+_object_append(Eina_Strbuf *buf, const Epulse_Event *ev)
+{
+   unsigned int i;
+   Eina_Bool first = EINA_TRUE;
+
+   eina_strbuf_append_printf(buf, ",\"index\":%d,\"name\":", ev->index);
+   _json_string(buf, ev->name);
+   eina_strbuf_append_printf(buf, ",\"volume\":%d,\"mute\":%s,\"changed\":[",
+                             PA_VOLUME_TO_INT(pa_cvolume_avg(&ev->volume)),
+                             _json_bool(ev->mute));
+   for (i = 0; _changes[i].name; i++)
+     {
+        if (!(ev->changed & _changes[i].bit))
+           continue;
+        if (!first)
+           eina_strbuf_append_char(buf, ',');
+        _json_string(buf, _changes[i].name);
+        first = EINA_FALSE;
+     }
+   eina_strbuf_append_printf(buf, "],\"cached\":%s", _json_bool(ev->cached));
+}
+
+static void
+_ports_append(Eina_Strbuf *buf, const Eina_List *ports)
+{
+   const Eina_List *l;
+   const char *active = NULL;
+   Port *port;
+
+   eina_strbuf_append(buf, ",\"ports\":[");
+   EINA_LIST_FOREACH(ports, l, port)
+     {
+        if (l != ports)
+           eina_strbuf_append_char(buf, ',');
+        eina_strbuf_append(buf, "{\"name\":");
+        _json_string(buf, port->name);
+        eina_strbuf_append(buf, ",\"description\":");
+        _json_string(buf, port->description);
+        eina_strbuf_append_printf(buf, ",\"available\":%s}",
+                                  _json_bool(port->available));
+        if (port->active)
+           active = port->name;
+     }
+   eina_strbuf_append(buf, "],\"active_port\":");
+   _json_string(buf, active);
+}
+
+static Eina_Bool
+_event_cb(void *data, int type EINA_UNUSED, void *info)
+{
+   const Monitor_Event *me = data;
+   const Epulse_Event_Sink_Input *input;
+   const Epulse_Event_Sink *sink;
+   const Epulse_Event *ev = info;
+
+   eina_strbuf_reset(_line);
+   eina_strbuf_append(_line, "{\"event\":");
+   _json_string(_line, me->name);
+
+   switch (me->kind)
+     {
+      case MONITOR_SINK:
+         sink = info;
+         _object_append(_line, ev);
+         _ports_append(_line, sink->ports);
+         break;
+
+      case MONITOR_SINK_INPUT:
+         input = info;
+         _object_append(_line, ev);
+         eina_strbuf_append_printf(_line, ",\"sink\":%d,\"corked\":%s"
+                                   ",\"pid\":%d,\"icon\":", input->sink,
+                                   _json_bool(input->corked), input->pid);
+         _json_string(_line, input->icon);
+         eina_strbuf_append(_line, ",\"app\":");
+         _json_string(_line, input->app);
+         eina_strbuf_append(_line, ",\"binary\":");
+         _json_string(_line, input->binary);
+         eina_strbuf_append(_line, ",\"role\":");
+         _json_string(_line, input->role);
+         break;
+
+      case MONITOR_SOURCE:
+         _object_append(_line, ev);
+         break;
+
+      case MONITOR_REMOVED:
+         eina_strbuf_append_printf(_line, ",\"index\":%d", ev->index);
+         break;
+
+      case MONITOR_STATE:
+         break;
+     }
+
+   eina_strbuf_append(_line, "}\n");
+   fputs(eina_strbuf_string_get(_line), stdout);
+   /* consumers read line by line from a pipe */
+   fflush(stdout);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+Eina_Bool
+monitor_start(void)
+{
+   const Monitor_Event *me;
+
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(!_line, EINA_FALSE);
+
+   _line = eina_strbuf_new();
+   EINA_SAFETY_ON_NULL_RETURN_VAL(_line, EINA_FALSE);
+
+   for (me = _events; me->type; me++)
+      _handlers = eina_list_append(_handlers,
+                                   ecore_event_handler_add(*me->type,
+                                                           _event_cb, me));
+
+   return EINA_TRUE;
+}
+
+void
+monitor_stop(void)
+{
+   Ecore_Event_Handler *handler;
+
+   EINA_LIST_FREE(_handlers, handler)
+      ecore_event_handler_del(handler);
+
+   if (_line)
+     {
+        eina_strbuf_free(_line);
+        _line = NULL;
+     }
+}
@@ -0,0 +1,13 @@
+#ifndef _MONITOR_H_
+#define _MONITOR_H_
+
+#include "common.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+Eina_Bool monitor_start(void);
+void monitor_stop(void);
+
+#endif /* _MONITOR_H_ */
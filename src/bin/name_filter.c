@@ -0,0 +1,305 @@
+#include "name_filter.h"
+
+#include <wctype.h>
+
+/*
+ * Names are indexed folded to lower case, blanks squeezed, when a row
+ * is added or renamed, never while filtering. A query extending the
+ * previous one can only match rows that matched before, so typing only
+ * matches against the current matches; any other query looks at every
+ * row. Rows not matching are hidden by the genlist filter, not deleted.
+ *
+ * Elementary cannot hide a single item, so applying the filter still
+ * visits every row. It is only applied when some row changed between
+ * shown and hidden, which a longer query often does not do.
+ */
+
+#define NAME_FILTER_KEY "name_filter.key"
+
+typedef struct _Filter_Row Filter_Row;
+struct _Filter_Row
+{
+   const void *row;
+   char *key;
+   Eina_Bool match;
+};
+
+typedef struct _Name_Filter Name_Filter;
+struct _Name_Filter
+{
+   Evas_Object *genlist;
+   Eina_Hash *rows;    /* Filter_Row by row */
+   Eina_List *matches; /* Filter_Row, while there is a query */
+   const char *query;  /* normalized, NULL shows everything */
+};
+
+static char *
+_normalize(const char *text)
+{
+   Eina_Unicode *u, *src, *dst;
+   Eina_Bool blank = EINA_TRUE; /* drops the leading ones */
+   char *ret;
+
+   u = eina_unicode_utf8_to_unicode(text, NULL);
+   if (!u)
+      return NULL;
+
+   for (src = dst = u; *src; src++)
+     {
+        if (iswspace(*src))
+          {
+             if (!blank)
+                *dst++ = ' ';
+             blank = EINA_TRUE;
+             continue;
+          }
+        *dst++ = towlower(*src);
+        blank = EINA_FALSE;
+     }
+   if (dst > u && dst[-1] == ' ')
+      dst--;
+   *dst = 0;
+
+   ret = eina_unicode_unicode_to_utf8(u, NULL);
+   free(u);
+   return ret;
+}
+
+static Name_Filter *
+_filter_get(const Evas_Object *genlist)
+{
+   return evas_object_data_get(genlist, NAME_FILTER_KEY);
+}
+
+static void
+_refilter(Name_Filter *filter)
+{
+#ifdef EPULSE_GENLIST_FILTER
+   /* the item classes may hide rows for their own reasons, the filter
+    * stays on without a query */
+   elm_genlist_filter_set(filter->genlist,
+                          (void *)(filter->query ? filter->query : ""));
+#else
+   (void)filter;
+#endif
+}
+
+static void
+_row_free_cb(void *data)
+{
+   Filter_Row *fr = data;
+
+   free(fr->key);
+   free(fr);
+}
+
+static void
+_genlist_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *o EINA_UNUSED,
+                void *event_info EINA_UNUSED)
+{
+   Name_Filter *filter = data;
+
+   eina_list_free(filter->matches);
+   eina_hash_free(filter->rows);
+   eina_stringshare_del(filter->query);
+   free(filter);
+}
+
+void
+name_filter_add(Evas_Object *genlist)
+{
+   Name_Filter *filter;
+
+   EINA_SAFETY_ON_NULL_RETURN(genlist);
+
+   filter = calloc(1, sizeof(Name_Filter));
+   EINA_SAFETY_ON_NULL_RETURN(filter);
+
+   filter->genlist = genlist;
+   filter->rows = eina_hash_pointer_new(_row_free_cb);
+   evas_object_data_set(genlist, NAME_FILTER_KEY, filter);
+   evas_object_event_callback_add(genlist, EVAS_CALLBACK_DEL,
+                                  _genlist_del_cb, filter);
+}
+
+/*
+ * Indexes a new row or the new name of a known one.
+ */
+void
+name_filter_row_set(Evas_Object *genlist, const void *row, const char *name)
+{
+   Name_Filter *filter = _filter_get(genlist);
+   Filter_Row *fr;
+   Eina_Bool match, known = EINA_TRUE;
+
+   EINA_SAFETY_ON_NULL_RETURN(filter);
+
+   fr = eina_hash_find(filter->rows, &row);
+   if (!fr)
+     {
+        fr = calloc(1, sizeof(Filter_Row));
+        EINA_SAFETY_ON_NULL_RETURN(fr);
+        fr->row = row;
+        eina_hash_add(filter->rows, &row, fr);
+        known = EINA_FALSE;
+     }
+
+   free(fr->key);
+   fr->key = _normalize(name ? name : "");
+
+   if (!filter->query)
+      return;
+
+   match = fr->key && strstr(fr->key, filter->query);
+   if (match == fr->match)
+      return;
+
+   fr->match = match;
+   if (match)
+      filter->matches = eina_list_append(filter->matches, fr);
+   else
+      filter->matches = eina_list_remove(filter->matches, fr);
+
+   /* new items are filtered once the genlist gets to them */
+   if (known)
+      _refilter(filter);
+}
+
+void
+name_filter_row_del(Evas_Object *genlist, const void *row)
+{
+   Name_Filter *filter = _filter_get(genlist);
+   Filter_Row *fr;
+
+   EINA_SAFETY_ON_NULL_RETURN(filter);
+
+   fr = eina_hash_find(filter->rows, &row);
+   if (!fr)
+      return;
+
+   if (fr->match)
+      filter->matches = eina_list_remove(filter->matches, fr);
+   eina_hash_del_by_key(filter->rows, &row);
+}
+
+void
+name_filter_clear(Evas_Object *genlist)
+{
+   Name_Filter *filter = _filter_get(genlist);
+
+   EINA_SAFETY_ON_NULL_RETURN(filter);
+
+   filter->matches = eina_list_free(filter->matches);
+   eina_hash_free_buckets(filter->rows);
+}
+
+/*
+ * Shows only the rows whose name contains query, all of them for an
+ * empty one.
+ */
+void
+name_filter_query_set(Evas_Object *genlist, const char *query)
+{
+   Name_Filter *filter = _filter_get(genlist);
+   char *key = NULL;
+   Eina_List *candidates;
+   Eina_Iterator *it;
+   Filter_Row *fr;
+   unsigned int scanned = 0, changed = 0;
+   double start = ecore_time_get();
+   Eina_Bool shown;
+
+   EINA_SAFETY_ON_NULL_RETURN(filter);
+
+   if (query)
+      key = _normalize(query);
+   if (key && !key[0])
+     {
+        free(key);
+        key = NULL;
+     }
+
+   if ((!key && !filter->query) ||
+       (key && filter->query && !strcmp(key, filter->query)))
+     {
+        free(key);
+        return;
+     }
+
+   if (key && filter->query && strstr(key, filter->query))
+     {
+        /* narrowing down, only what matched can still match */
+        candidates = filter->matches;
+        filter->matches = NULL;
+        EINA_LIST_FREE(candidates, fr)
+          {
+             scanned++;
+             fr->match = !!strstr(fr->key, key);
+             if (fr->match)
+                filter->matches = eina_list_append(filter->matches, fr);
+             else
+                changed++;
+          }
+     }
+   else if (key)
+     {
+        filter->matches = eina_list_free(filter->matches);
+        it = eina_hash_iterator_data_new(filter->rows);
+        EINA_ITERATOR_FOREACH(it, fr)
+          {
+             scanned++;
+             shown = !filter->query || fr->match;
+             fr->match = fr->key && strstr(fr->key, key);
+             if (fr->match)
+                filter->matches = eina_list_append(filter->matches, fr);
+             if (shown != fr->match)
+                changed++;
+          }
+        eina_iterator_free(it);
+     }
+   else
+     {
+        /* everything is shown again, what did not match was hidden */
+        changed = eina_hash_population(filter->rows) -
+           eina_list_count(filter->matches);
+        filter->matches = eina_list_free(filter->matches);
+     }
+
+   eina_stringshare_del(filter->query);
+   filter->query = key ? eina_stringshare_add(key) : NULL;
+   free(key);
+
+   DBG("Filter '%s': %u matches, %u changed, %u rows looked at in %.3f ms",
+       filter->query ? filter->query : "", eina_list_count(filter->matches),
+       changed, scanned, (ecore_time_get() - start) * 1000.0);
+
+   if (changed)
+      _refilter(filter);
+}
+
+/*
+ * Filters the rows again, for the item classes whose filter also looks
+ * at something else than the name.
+ */
+void
+name_filter_refresh(Evas_Object *genlist)
+{
+   Name_Filter *filter = _filter_get(genlist);
+
+   EINA_SAFETY_ON_NULL_RETURN(filter);
+
+   _refilter(filter);
+}
+
+Eina_Bool
+name_filter_match(const Evas_Object *genlist, const void *row)
+{
+   Name_Filter *filter = _filter_get(genlist);
+   Filter_Row *fr;
+
+   if (!filter || !filter->query)
+      return EINA_TRUE;
+
+   fr = eina_hash_find(filter->rows, &row);
+   return fr && fr->match;
+}
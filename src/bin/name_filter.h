@@ -0,0 +1,24 @@
+#ifndef _NAME_FILTER_H_
+#define _NAME_FILTER_H_
+
+#include "common.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/*
+ * Search index of the rows of a genlist by their name, attached to the
+ * genlist and freed with it. Rows are the item data, the item classes
+ * answer filter_get with name_filter_match().
+ */
+void name_filter_add(Evas_Object *genlist);
+void name_filter_row_set(Evas_Object *genlist, const void *row,
+                         const char *name);
+void name_filter_row_del(Evas_Object *genlist, const void *row);
+void name_filter_clear(Evas_Object *genlist);
+void name_filter_query_set(Evas_Object *genlist, const char *query);
+void name_filter_refresh(Evas_Object *genlist);
+Eina_Bool name_filter_match(const Evas_Object *genlist, const void *row);
+
+#endif /* _NAME_FILTER_H_ */
@@ -1,8 +1,23 @@
 #include "playbacks_view.h"
 
 #include "epulse.h"
+#include "icon_cache.h"
+#include "name_filter.h"
 
 #define PLAYBACKS_KEY "playbacks.key"
+#define ICON_SIZE 40 /* the icon part of the row */
+
+/*
+ * Streams are shown grouped by application: one row per application
+ * whose volume, mute and sink apply to all of its streams at once, the
+ * streams themselves only get rows while the group is expanded
+ * (activate the row to toggle). A search matches a group by its name or
+ * by the name of any of its streams.
+ *
+ * Groups with a stream playing come first: a group moves to the top
+ * when one of its streams starts and to the bottom once all of them are
+ * corked. Idle groups and streams can also be hidden altogether.
+ */
 
 struct Sink
 {
@@ -15,9 +30,12 @@ struct Playbacks_View
    Evas_Object *self;
    Evas_Object *genlist;
    Elm_Genlist_Item_Class *itc;
+   Elm_Genlist_Item_Class *group_itc;
 
    Eina_List *inputs;
    Eina_List *sinks;
+   Eina_Hash *groups; /* App_Group by application name */
+   Eina_Bool hide_idle;
 
    Ecore_Event_Handler *disconnected;
    Ecore_Event_Handler *sink_input_added;
@@ -28,29 +46,281 @@ struct Playbacks_View
    Ecore_Event_Handler *sink_removed;
 };
 
+struct App_Group
+{
+   struct Playbacks_View *pv;
+
+   const char *name;
+   Eina_List *inputs;
+   pa_volume_t volume;
+   Eina_Bool mute;
+   Eina_Bool active; /* one of the streams is not corked */
+
+   Elm_Object_Item *item;
+   Eina_Bool moving;
+};
+
 struct Sink_Input
 {
    struct Playbacks_View *pv;
+   struct App_Group *group;
 
    int index;
    int sink_index;
    pa_cvolume volume;
    const char *name;
    const char *icon;
+   const char *app;
    Eina_Bool mute;
+   Eina_Bool corked;
 
+   /* only while the group is expanded */
    Elm_Object_Item *item;
 };
 
- static Eina_Bool
+static void
+_input_free(struct Sink_Input *input)
+{
+   epulse_slider_throttle_release(input);
+   name_filter_row_del(input->pv->genlist, input);
+   eina_stringshare_del(input->name);
+   eina_stringshare_del(input->icon);
+   eina_stringshare_del(input->app);
+   free(input);
+}
+
+static struct App_Group *
+_group_get(struct Playbacks_View *pv, const char *app)
+{
+   struct App_Group *group = eina_hash_find(pv->groups, app);
+
+   if (group)
+      return group;
+
+   group = calloc(1, sizeof(struct App_Group));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(group, NULL);
+
+   group->pv = pv;
+   group->name = eina_stringshare_add(app);
+   eina_hash_add(pv->groups, group->name, group);
+
+   return group;
+}
+
+/* active groups are put on top, idle ones at the bottom */
+static void
+_group_item_add(struct App_Group *group)
+{
+   struct Playbacks_View *pv = group->pv;
+
+   if (group->active)
+      group->item = elm_genlist_item_prepend(pv->genlist, pv->group_itc,
+                                             group, NULL,
+                                             ELM_GENLIST_ITEM_TREE, NULL,
+                                             NULL);
+   else
+      group->item = elm_genlist_item_append(pv->genlist, pv->group_itc,
+                                            group, NULL,
+                                            ELM_GENLIST_ITEM_TREE, NULL,
+                                            NULL);
+}
+
+/*
+ * Moves the group row when its activity changed, the row is created
+ * again at its new place and expanded again if it was.
+ */
+static void
+_group_activity_update(struct App_Group *group)
+{
+   struct Sink_Input *input;
+   Eina_Bool active = EINA_FALSE, expanded;
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(group->inputs, l, input)
+     {
+        if (!input->corked)
+          {
+             active = EINA_TRUE;
+             break;
+          }
+     }
+
+   if (group->active == active)
+      return;
+
+   group->active = active;
+   expanded = elm_genlist_item_expanded_get(group->item);
+
+   /* see _group_del */
+   group->moving = EINA_TRUE;
+   elm_object_item_del(group->item);
+   group->moving = EINA_FALSE;
+
+   _group_item_add(group);
+   if (expanded)
+      elm_genlist_item_expanded_set(group->item, EINA_TRUE);
+}
+
+/* the group shows the loudest stream and is muted when all of them are */
+static void
+_group_levels_update(struct App_Group *group)
+{
+   struct Sink_Input *input;
+   Evas_Object *item;
+   Eina_List *l;
+   pa_volume_t vol, max = PA_VOLUME_MUTED;
+   Eina_Bool mute = EINA_TRUE;
+
+   EINA_LIST_FOREACH(group->inputs, l, input)
+     {
+        vol = pa_cvolume_avg(&input->volume);
+        if (vol > max)
+           max = vol;
+        mute &= input->mute;
+     }
+
+   if (group->volume != max)
+     {
+        group->volume = max;
+        item = elm_object_item_part_content_get(group->item, "slider");
+        if (item && !epulse_slider_dragging_get(item))
+           elm_slider_value_set(item, PA_VOLUME_TO_INT(max));
+     }
+
+   if (group->mute != mute)
+     {
+        group->mute = mute;
+        item = elm_object_item_part_content_get(group->item, "mute");
+        if (item)
+           elm_check_state_set(item, mute);
+     }
+}
+
+/* a separator no query has, so none matches across two names */
+#define GROUP_INDEX_SEPARATOR '\x1f'
+
+static void
+_group_index(struct App_Group *group)
+{
+   Eina_Strbuf *buf = eina_strbuf_new();
+   struct Sink_Input *input;
+   Eina_List *l;
+
+   EINA_SAFETY_ON_NULL_RETURN(buf);
+
+   eina_strbuf_append(buf, group->name);
+   EINA_LIST_FOREACH(group->inputs, l, input)
+     {
+        eina_strbuf_append_char(buf, GROUP_INDEX_SEPARATOR);
+        eina_strbuf_append(buf, input->name);
+     }
+   name_filter_row_set(group->pv->genlist, group,
+                       eina_strbuf_string_get(buf));
+   eina_strbuf_free(buf);
+}
+
+/*
+ * The first stream lends the group its icon, sink and meter. Those are
+ * only recreated when first, the one before the change, is not it
+ * anymore; the meter would otherwise reconnect its stream every time.
+ */
+static void
+_group_members_update(struct App_Group *group,
+                      const struct Sink_Input *first)
+{
+   _group_levels_update(group);
+   _group_index(group);
+   elm_genlist_item_fields_update(group->item, "name",
+                                  ELM_GENLIST_ITEM_FIELD_TEXT);
+   if (eina_list_data_get(group->inputs) == first)
+      return;
+
+   elm_genlist_item_fields_update(group->item, "icon",
+                                  ELM_GENLIST_ITEM_FIELD_CONTENT);
+   elm_genlist_item_fields_update(group->item, "hover",
+                                  ELM_GENLIST_ITEM_FIELD_CONTENT);
+   elm_genlist_item_fields_update(group->item, "meter",
+                                  ELM_GENLIST_ITEM_FIELD_CONTENT);
+}
+
+/* the group row follows its first stream */
+static void
+_group_first_changed(struct App_Group *group, unsigned int changed)
+{
+   if (changed & EPULSE_CHANGE_ICON)
+      elm_genlist_item_fields_update(group->item, "icon",
+                                     ELM_GENLIST_ITEM_FIELD_CONTENT);
+   if (changed & EPULSE_CHANGE_SINK)
+     {
+        elm_genlist_item_fields_update(group->item, "hover",
+                                       ELM_GENLIST_ITEM_FIELD_CONTENT);
+        elm_genlist_item_fields_update(group->item, "meter",
+                                       ELM_GENLIST_ITEM_FIELD_CONTENT);
+     }
+}
+
+static void
+_input_attach(struct Sink_Input *input)
+{
+   struct Playbacks_View *pv = input->pv;
+   struct App_Group *group = _group_get(pv, input->app);
+   const struct Sink_Input *first;
+
+   EINA_SAFETY_ON_NULL_RETURN(group);
+
+   input->group = group;
+   first = eina_list_data_get(group->inputs);
+   group->inputs = eina_list_append(group->inputs, input);
+   if (!group->item)
+     {
+        /* the new row already shows this stream */
+        first = input;
+        group->active = !input->corked;
+        _group_item_add(group);
+     }
+   else if (elm_genlist_item_expanded_get(group->item))
+      input->item = elm_genlist_item_append(pv->genlist, pv->itc, input,
+                                            group->item,
+                                            ELM_GENLIST_ITEM_NONE, NULL,
+                                            NULL);
+   _group_members_update(group, first);
+}
+
+static void
+_input_detach(struct Sink_Input *input)
+{
+   struct App_Group *group = input->group;
+   const struct Sink_Input *first;
+
+   if (!group)
+      return;
+
+   first = eina_list_data_get(group->inputs);
+   input->group = NULL;
+   group->inputs = eina_list_remove(group->inputs, input);
+   if (input->item)
+      elm_object_item_del(input->item);
+
+   /* frees the group, see _group_del */
+   if (!group->inputs)
+      elm_object_item_del(group->item);
+   else
+     {
+        _group_members_update(group, first);
+        _group_activity_update(group);
+     }
+}
+
+static Eina_Bool
 _disconnected_cb(void *data, int type EINA_UNUSED, void *info EINA_UNUSED)
 {
    struct Playbacks_View *pv = data;
    struct Sink_Input *si;
    struct Sink *sink;
 
+   elm_genlist_clear(pv->genlist);
    EINA_LIST_FREE(pv->inputs, si)
-      elm_object_item_del(si->item);
+      _input_free(si);
 
    EINA_LIST_FREE(pv->sinks, sink)
      {
@@ -72,15 +342,19 @@ _sink_input_add_cb(void *data, int type EINA_UNUSED,
 
    input->name = eina_stringshare_add(ev->base.name);
    input->icon = eina_stringshare_add(ev->icon);
+   input->app = eina_stringshare_add(ev->app ? ev->app : ev->base.name);
    input->index = ev->base.index;
    input->sink_index = ev->sink;
    input->volume = ev->base.volume;
    input->mute = ev->base.mute;
+   input->corked = ev->corked;
    input->pv = pv;
 
    pv->inputs = eina_list_append(pv->inputs, input);
-   input->item = elm_genlist_item_append(pv->genlist, pv->itc, input, NULL,
-                                         ELM_GENLIST_ITEM_NONE, NULL, pv);
+   name_filter_row_set(pv->genlist, input, input->name);
+   _input_attach(input);
+   if (input->group)
+      _group_activity_update(input->group);
 
    return ECORE_CALLBACK_DONE;
 }
@@ -99,7 +373,8 @@ _sink_input_removed_cb(void *data, int type EINA_UNUSED,
         if (input->index == ev->base.index)
           {
              pv->inputs = eina_list_remove_list(pv->inputs, l);
-             elm_object_item_del(input->item);
+             _input_detach(input);
+             _input_free(input);
              break;
           }
      }
@@ -121,18 +396,88 @@ _sink_input_changed_cb(void *data, int type EINA_UNUSED,
      {
         if (input->index == ev->base.index)
           {
-             pa_volume_t vol = pa_cvolume_avg(&ev->base.volume);
+             if ((ev->base.changed & EPULSE_CHANGE_APP) && ev->app &&
+                 strcmp(ev->app, input->app))
+               {
+                  _input_detach(input);
+                  eina_stringshare_replace(&input->app, ev->app);
+                  _input_attach(input);
+                  /* the new group may now have a stream playing */
+                  if (input->group)
+                     _group_activity_update(input->group);
+               }
+
+             if (ev->base.changed & EPULSE_CHANGE_VOLUME)
+                input->volume = ev->base.volume;
+             if (ev->base.changed & EPULSE_CHANGE_MUTE)
+                input->mute = ev->base.mute;
+             if (ev->base.changed & EPULSE_CHANGE_NAME)
+               {
+                  eina_stringshare_replace(&input->name, ev->base.name);
+                  name_filter_row_set(pv->genlist, input, input->name);
+                  if (input->group)
+                     _group_index(input->group);
+               }
+             if (ev->base.changed & EPULSE_CHANGE_ICON)
+                eina_stringshare_replace(&input->icon, ev->icon);
+             if (ev->base.changed & EPULSE_CHANGE_SINK)
+                input->sink_index = ev->sink;
+             if (ev->base.changed & EPULSE_CHANGE_CORKED)
+                input->corked = ev->corked;
+
+             if (input->group)
+               {
+                  if (ev->base.changed &
+                      (EPULSE_CHANGE_VOLUME | EPULSE_CHANGE_MUTE))
+                     _group_levels_update(input->group);
+                  if (eina_list_data_get(input->group->inputs) == input)
+                     _group_first_changed(input->group, ev->base.changed);
+                  if (ev->base.changed & EPULSE_CHANGE_CORKED)
+                     _group_activity_update(input->group);
+               }
+
+             /* an expanded stream shows or hides with its state */
+             if ((ev->base.changed & EPULSE_CHANGE_CORKED) && input->item &&
+                 pv->hide_idle)
+                name_filter_refresh(pv->genlist);
+
+             /* collapsed, there is no row to update */
+             if (!input->item)
+                break;
+
+             if (ev->base.changed & EPULSE_CHANGE_VOLUME)
+               {
+                  pa_volume_t vol = pa_cvolume_avg(&ev->base.volume);
+
+                  item = elm_object_item_part_content_get(input->item,
+                                                          "slider");
+                  if (item && !epulse_slider_dragging_get(item))
+                     elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
+               }
+
+             if (ev->base.changed & EPULSE_CHANGE_MUTE)
+               {
+                  item = elm_object_item_part_content_get(input->item,
+                                                          "mute");
+                  if (item)
+                     elm_check_state_set(item, input->mute);
+               }
 
-             item = elm_object_item_part_content_get(input->item, "item");
-             input->volume = ev->base.volume;
-             if (item)
-                elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
+             if (ev->base.changed & EPULSE_CHANGE_NAME)
+                elm_genlist_item_fields_update(input->item, "name",
+                                               ELM_GENLIST_ITEM_FIELD_TEXT);
 
-             item = elm_object_item_part_content_get(input->item, "mute");
-             input->mute = ev->base.mute;
-             if (item)
+             if (ev->base.changed & EPULSE_CHANGE_ICON)
+                elm_genlist_item_fields_update(input->item, "icon",
+                                               ELM_GENLIST_ITEM_FIELD_CONTENT);
+
+             if (ev->base.changed & EPULSE_CHANGE_SINK)
                {
-                  elm_check_state_set(item, input->mute);
+                  elm_genlist_item_fields_update(input->item, "hover",
+                                                 ELM_GENLIST_ITEM_FIELD_CONTENT);
+                  /* the meter records from the old sink's monitor */
+                  elm_genlist_item_fields_update(input->item, "meter",
+                                                 ELM_GENLIST_ITEM_FIELD_CONTENT);
                }
              break;
           }
@@ -188,8 +533,15 @@ _del_cb(void *data,
         void *event_info EINA_UNUSED)
 {
    struct Playbacks_View *pv = data;
+   struct Sink_Input *input;
    struct Sink *sink;
-   eina_list_free(pv->inputs);
+
+   elm_genlist_clear(pv->genlist);
+   EINA_LIST_FREE(pv->inputs, input)
+      _input_free(input);
+   eina_hash_free(pv->groups);
+   elm_genlist_item_class_free(pv->itc);
+   elm_genlist_item_class_free(pv->group_itc);
 
    EINA_LIST_FREE(pv->sinks, sink)
      {
@@ -226,22 +578,19 @@ _item_text_get(void *data, Evas_Object *obj EINA_UNUSED, const char *part)
    return NULL;
 }
 
+/* the stream outlives its row, it is freed once removed */
 static void
 _item_del(void *data, Evas_Object *obj EINA_UNUSED)
 {
    struct Sink_Input *input = data;
 
-   eina_stringshare_del(input->name);
-   eina_stringshare_del(input->icon);
-   free(input);
+   input->item = NULL;
 }
 
 static void
-_volume_changed_cb(void *data, Evas_Object *o,
-                   void *event_info EINA_UNUSED)
+_volume_changed_cb(void *data, double val)
 {
    struct Sink_Input *input = data;
-   double val = elm_slider_value_get(o);
    pa_volume_t v = INT_TO_PA_VOLUME(val);
 
    pa_cvolume_set(&input->volume, input->volume.channels, v);
@@ -293,8 +642,11 @@ _item_content_get(void *data, Evas_Object *obj, const char *part)
         elm_slider_min_max_set(item, 0.0, 100.0);
         elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
 
-        evas_object_smart_callback_add(item, "delay,changed",
-                                       _volume_changed_cb, input);
+        epulse_slider_throttle_add(item, _volume_changed_cb, input);
+     }
+   else if (!strcmp(part, "meter"))
+     {
+        item = epulse_meter_widget_add(obj, EPULSE_METER_SINK_INPUT, input->index);
      }
    else if (!strcmp(part, "mute"))
      {
@@ -314,10 +666,7 @@ _item_content_get(void *data, Evas_Object *obj, const char *part)
      {
         EINA_SAFETY_ON_NULL_RETURN_VAL(input->icon, NULL);
 
-        item = elm_icon_add(obj);
-        EINA_SAFETY_ON_NULL_RETURN_VAL(item, NULL);
-
-        elm_icon_standard_set(item, input->icon);
+        item = icon_cache_icon_add(obj, input->icon, ICON_SIZE);
      }
    else if (!strcmp(part, "hover"))
      {
@@ -339,10 +688,337 @@ _item_content_get(void *data, Evas_Object *obj, const char *part)
    return item;
 }
 
+#ifdef EPULSE_GENLIST_REUSE
+/* the slider and the check of a row scrolled away serve the next one */
+static Evas_Object *
+_item_content_reuse(void *data, Evas_Object *obj EINA_UNUSED,
+                    const char *part, Evas_Object *old)
+{
+   struct Sink_Input *input = data;
+
+   if (!strcmp(part, "slider"))
+     {
+        pa_volume_t vol = pa_cvolume_avg(&input->volume);
+
+        epulse_slider_throttle_retarget(old, _volume_changed_cb, input);
+        elm_slider_value_set(old, PA_VOLUME_TO_INT(vol));
+        return old;
+     }
+   else if (!strcmp(part, "mute"))
+     {
+        evas_object_smart_callback_del(old, "changed", _mute_changed_cb);
+        elm_check_state_pointer_set(old, &input->mute);
+        evas_object_smart_callback_add(old, "changed", _mute_changed_cb,
+                                       input);
+        return old;
+     }
+
+   return NULL;
+}
+#endif
+
+#ifdef EPULSE_GENLIST_FILTER
+/* the streams of a matching application stay visible */
+static Eina_Bool
+_item_filter_get(void *data, Evas_Object *obj, void *key EINA_UNUSED)
+{
+   struct Sink_Input *input = data;
+
+   if (input->corked && input->pv->hide_idle)
+      return EINA_FALSE;
+
+   return name_filter_match(obj, input) ||
+          (input->group && name_filter_match(obj, input->group));
+}
+#endif
+
+static char *
+_group_text_get(void *data, Evas_Object *obj EINA_UNUSED, const char *part)
+{
+   struct App_Group *group = data;
+   unsigned int count = eina_list_count(group->inputs);
+   char buf[1024];
+
+   if (strcmp(part, "name"))
+      return NULL;
+
+   if (count < 2)
+      return strdup(group->name);
+
+   snprintf(buf, sizeof(buf), "%s (%u)", group->name, count);
+   return strdup(buf);
+}
+
+static void
+_group_del(void *data, Evas_Object *obj EINA_UNUSED)
+{
+   struct App_Group *group = data;
+   struct Sink_Input *input;
+
+   /* only the row goes away, it is put back elsewhere */
+   if (group->moving)
+      return;
+
+   epulse_slider_throttle_release(group);
+   EINA_LIST_FREE(group->inputs, input)
+      input->group = NULL;
+   name_filter_row_del(group->pv->genlist, group);
+   eina_hash_del_by_key(group->pv->groups, group->name);
+   eina_stringshare_del(group->name);
+   free(group);
+}
+
+/*
+ * Group changes are issued as one batch, each stream then reports a
+ * single CHANGED once all of them are done.
+ */
+static void
+_group_volume_changed_cb(void *data, double val)
+{
+   struct App_Group *group = data;
+   struct Sink_Input *input;
+   pa_volume_t v = INT_TO_PA_VOLUME(val);
+   Eina_Bool batch = epulse_batch_begin();
+   Eina_List *l;
+
+   group->volume = v;
+   EINA_LIST_FOREACH(group->inputs, l, input)
+     {
+        pa_cvolume_set(&input->volume, input->volume.channels, v);
+        epulse_sink_input_volume_set(input->index, input->volume);
+     }
+
+   if (batch)
+      epulse_batch_commit(NULL, NULL);
+}
+
+static void
+_group_mute_changed_cb(void *data, Evas_Object *o EINA_UNUSED,
+                       void *event_info EINA_UNUSED)
+{
+   struct App_Group *group = data;
+   struct Sink_Input *input;
+   Eina_Bool batch = epulse_batch_begin();
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(group->inputs, l, input)
+     {
+        if (input->mute != group->mute &&
+            epulse_sink_input_mute_set(input->index, group->mute))
+           input->mute = group->mute;
+     }
+
+   if (batch)
+      epulse_batch_commit(NULL, NULL);
+}
+
+static void
+_group_sink_selected(void *data, Evas_Object *obj, void *event_info)
+{
+   struct App_Group *group = data;
+   struct Sink *sink = elm_object_item_data_get(event_info);
+   struct Sink_Input *input;
+   Eina_Bool batch = epulse_batch_begin();
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(group->inputs, l, input)
+      if (input->sink_index != sink->index)
+         epulse_sink_input_move(input->index, sink->index);
+
+   if (batch)
+      epulse_batch_commit(NULL, NULL);
+   elm_object_text_set(obj, sink->name);
+}
+
+static Evas_Object *
+_group_content_get(void *data, Evas_Object *obj, const char *part)
+{
+   struct App_Group *group = data;
+   struct Sink_Input *first = eina_list_data_get(group->inputs);
+   Evas_Object *item = NULL;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(first, NULL);
+
+   if (!strcmp(part, "slider"))
+     {
+        item = elm_slider_add(obj);
+        EINA_SAFETY_ON_NULL_RETURN_VAL(item, NULL);
+
+        elm_slider_step_set(item, 1.0/BASE_VOLUME_STEP);
+        elm_slider_unit_format_set(item, "%1.0f");
+        elm_slider_indicator_format_set(item, "%1.0f");
+        elm_slider_span_size_set(item, 120);
+        elm_slider_min_max_set(item, 0.0, 100.0);
+        elm_slider_value_set(item, PA_VOLUME_TO_INT(group->volume));
+
+        epulse_slider_throttle_add(item, _group_volume_changed_cb, group);
+     }
+   else if (!strcmp(part, "meter"))
+     {
+        item = epulse_meter_widget_add(obj, EPULSE_METER_SINK_INPUT,
+                                       first->index);
+     }
+   else if (!strcmp(part, "mute"))
+     {
+        item = elm_check_add(obj);
+        EINA_SAFETY_ON_NULL_RETURN_VAL(item, NULL);
+
+        elm_object_style_set(item, "toggle");
+        elm_object_translatable_part_text_set(item, "off", N_("Mute"));
+        elm_object_translatable_part_text_set(item, "on", N_("Unmute"));
+
+        elm_check_state_set(item, group->mute);
+        elm_check_state_pointer_set(item, &group->mute);
+        evas_object_smart_callback_add(item, "changed",
+                                       _group_mute_changed_cb, group);
+     }
+   else if (!strcmp(part, "icon"))
+     {
+        EINA_SAFETY_ON_NULL_RETURN_VAL(first->icon, NULL);
+
+        item = icon_cache_icon_add(obj, first->icon, ICON_SIZE);
+     }
+   else if (!strcmp(part, "hover"))
+     {
+        Eina_List *l;
+        struct Sink *sink;
+        item = elm_hoversel_add(obj);
+
+        EINA_LIST_FOREACH(group->pv->sinks, l, sink)
+          {
+             if (sink->index == first->sink_index)
+                elm_object_text_set(item, sink->name);
+             elm_hoversel_item_add(item, sink->name, NULL,
+                                   ELM_ICON_NONE, NULL, sink);
+          }
+        evas_object_smart_callback_add(item, "selected",
+                                       _group_sink_selected, group);
+     }
+
+   return item;
+}
+
+#ifdef EPULSE_GENLIST_REUSE
+static Evas_Object *
+_group_content_reuse(void *data, Evas_Object *obj EINA_UNUSED,
+                     const char *part, Evas_Object *old)
+{
+   struct App_Group *group = data;
+
+   if (!strcmp(part, "slider"))
+     {
+        epulse_slider_throttle_retarget(old, _group_volume_changed_cb, group);
+        elm_slider_value_set(old, PA_VOLUME_TO_INT(group->volume));
+        return old;
+     }
+   else if (!strcmp(part, "mute"))
+     {
+        evas_object_smart_callback_del(old, "changed",
+                                       _group_mute_changed_cb);
+        elm_check_state_pointer_set(old, &group->mute);
+        evas_object_smart_callback_add(old, "changed",
+                                       _group_mute_changed_cb, group);
+        return old;
+     }
+
+   return NULL;
+}
+#endif
+
+#ifdef EPULSE_GENLIST_FILTER
+static Eina_Bool
+_group_filter_get(void *data, Evas_Object *obj, void *key EINA_UNUSED)
+{
+   struct App_Group *group = data;
+
+   if (!group->active && group->pv->hide_idle)
+      return EINA_FALSE;
+
+   return name_filter_match(obj, group);
+}
+
+static void
+_hide_idle_changed_cb(void *data, Evas_Object *obj,
+                      void *event_info EINA_UNUSED)
+{
+   struct Playbacks_View *pv = data;
+
+   pv->hide_idle = elm_check_state_get(obj);
+   name_filter_refresh(pv->genlist);
+}
+#endif
+
+static void
+_activated_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   struct Playbacks_View *pv = data;
+   Elm_Object_Item *item = event_info;
+
+   if (elm_genlist_item_item_class_get(item) != pv->group_itc)
+      return;
+
+   elm_genlist_item_expanded_set(item, !elm_genlist_item_expanded_get(item));
+}
+
+static void
+_expanded_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   struct Playbacks_View *pv = data;
+   Elm_Object_Item *item = event_info;
+   struct App_Group *group = elm_object_item_data_get(item);
+   struct Sink_Input *input;
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(group->inputs, l, input)
+      input->item = elm_genlist_item_append(pv->genlist, pv->itc, input,
+                                            item, ELM_GENLIST_ITEM_NONE,
+                                            NULL, NULL);
+}
+
+static void
+_contracted_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
+               void *event_info)
+{
+   elm_genlist_item_subitems_clear(event_info);
+}
+
+void
+playbacks_view_filter_set(Evas_Object *obj, const char *query)
+{
+   struct Playbacks_View *pv = evas_object_data_get(obj, PLAYBACKS_KEY);
+
+   EINA_SAFETY_ON_NULL_RETURN(pv);
+
+   name_filter_query_set(pv->genlist, query);
+}
+
+/*
+ * Rows recycle their contents where the genlist can, this turns it off
+ * for rows realized from now on. Only meant for measuring.
+ */
+void
+playbacks_view_content_reuse_set(Evas_Object *obj, Eina_Bool reuse)
+{
+   struct Playbacks_View *pv = evas_object_data_get(obj, PLAYBACKS_KEY);
+
+   EINA_SAFETY_ON_NULL_RETURN(pv);
+
+#ifdef EPULSE_GENLIST_REUSE
+   pv->itc->func.reusable_content_get = reuse ? _item_content_reuse : NULL;
+   pv->group_itc->func.reusable_content_get =
+      reuse ? _group_content_reuse : NULL;
+#else
+   (void)reuse;
+#endif
+}
+
 Evas_Object *
 playbacks_view_add(Evas_Object *parent)
 {
-   Evas_Object *layout;
+   Evas_Object *layout, *box;
+#ifdef EPULSE_GENLIST_FILTER
+   Evas_Object *check;
+#endif
    struct Playbacks_View *pv;
 
    pv = calloc(1, sizeof(struct Playbacks_View));
@@ -355,12 +1031,14 @@ playbacks_view_add(Evas_Object *parent)
 
    pv->genlist = elm_genlist_add(layout);
    EINA_SAFETY_ON_NULL_GOTO(pv->genlist, err_genlist);
+   epulse_genlist_large_set(pv->genlist, EINA_TRUE);
+   name_filter_add(pv->genlist);
 
    pv->disconnected = ecore_event_handler_add(DISCONNECTED,
                                               _disconnected_cb, pv);
    pv->sink_input_added = ecore_event_handler_add(SINK_INPUT_ADDED,
                                                   _sink_input_add_cb, pv);
-   pv->sink_input_added = ecore_event_handler_add(SINK_INPUT_CHANGED,
+   pv->sink_input_changed = ecore_event_handler_add(SINK_INPUT_CHANGED,
                                                   _sink_input_changed_cb, pv);
    pv->sink_input_removed = ecore_event_handler_add(SINK_INPUT_REMOVED,
                                                     _sink_input_removed_cb, pv);
@@ -374,15 +1052,57 @@ playbacks_view_add(Evas_Object *parent)
    pv->itc->item_style = "playbacks";
    pv->itc->func.text_get = _item_text_get;
    pv->itc->func.content_get = _item_content_get;
+#ifdef EPULSE_GENLIST_REUSE
+   pv->itc->func.reusable_content_get = _item_content_reuse;
+#endif
+#ifdef EPULSE_GENLIST_FILTER
+   pv->itc->func.filter_get = _item_filter_get;
+#endif
    pv->itc->func.del = _item_del;
 
+   pv->group_itc = elm_genlist_item_class_new();
+   EINA_SAFETY_ON_NULL_GOTO(pv->group_itc, err_genlist);
+   pv->group_itc->item_style = "playbacks";
+   pv->group_itc->func.text_get = _group_text_get;
+   pv->group_itc->func.content_get = _group_content_get;
+#ifdef EPULSE_GENLIST_REUSE
+   pv->group_itc->func.reusable_content_get = _group_content_reuse;
+#endif
+#ifdef EPULSE_GENLIST_FILTER
+   pv->group_itc->func.filter_get = _group_filter_get;
+#endif
+   pv->group_itc->func.del = _group_del;
+
+   pv->groups = eina_hash_string_superfast_new(NULL);
+   evas_object_smart_callback_add(pv->genlist, "activated", _activated_cb,
+                                  pv);
+   evas_object_smart_callback_add(pv->genlist, "expanded", _expanded_cb, pv);
+   evas_object_smart_callback_add(pv->genlist, "contracted",
+                                  _contracted_cb, pv);
+
    evas_object_data_set(layout, PLAYBACKS_KEY, pv);
-   elm_layout_content_set(layout, "list", pv->genlist);
+
+   box = elm_box_add(layout);
+   evas_object_size_hint_weight_set(box, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(box, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   elm_layout_content_set(layout, "list", box);
 
    evas_object_size_hint_weight_set(pv->genlist, EVAS_HINT_EXPAND,
                                     EVAS_HINT_EXPAND);
    evas_object_size_hint_align_set(pv->genlist, EVAS_HINT_FILL,
                                    EVAS_HINT_FILL);
+   elm_box_pack_end(box, pv->genlist);
+   evas_object_show(pv->genlist);
+
+#ifdef EPULSE_GENLIST_FILTER
+   check = elm_check_add(box);
+   elm_object_text_set(check, _("Hide paused streams"));
+   evas_object_size_hint_align_set(check, 0.0, 0.5);
+   evas_object_smart_callback_add(check, "changed", _hide_idle_changed_cb,
+                                  pv);
+   elm_box_pack_end(box, check);
+   evas_object_show(check);
+#endif
 
    return layout;
 
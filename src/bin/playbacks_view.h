@@ -8,5 +8,7 @@
 #endif
 
 Evas_Object *playbacks_view_add(Evas_Object *parent);
+void playbacks_view_filter_set(Evas_Object *obj, const char *query);
+void playbacks_view_content_reuse_set(Evas_Object *obj, Eina_Bool reuse);
 
 #endif /* _PLAYBACKS_VIEW_H_ */
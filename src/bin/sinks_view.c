@@ -1,6 +1,7 @@
 #include "sinks_view.h"
 
 #include "epulse.h"
+#include "name_filter.h"
 
 #define SINKS_KEY "sinks.key"
 
@@ -44,27 +45,26 @@ _disconnected_cb(void *data, int type EINA_UNUSED, void *info EINA_UNUSED)
 
    EINA_LIST_FREE(sv->sinks, sink)
       elm_object_item_del(sink->item);
+   name_filter_clear(sv->genlist);
 
    return ECORE_CALLBACK_PASS_ON;
 }
 
-static Eina_Bool
-_sink_add_cb(void *data, int type EINA_UNUSED, void *info)
+static void
+_sink_ports_set(struct Sink *sink, const Eina_List *ports)
 {
-   struct Sinks_View *sv = data;
    struct Sink_Port *sp;
-   Epulse_Event_Sink *ev = info;
+   const Eina_List *l;
    Port *port;
-   Eina_List *l;
-   struct Sink *sink = calloc(1, sizeof(struct Sink));
-   EINA_SAFETY_ON_NULL_RETURN_VAL(sink, ECORE_CALLBACK_PASS_ON);
 
-   sink->name = eina_stringshare_add(ev->base.name);
-   sink->index = ev->base.index;
-   sink->volume = ev->base.volume;
-   sink->mute = ev->base.mute;
+   EINA_LIST_FREE(sink->ports, sp)
+     {
+        free(sp->name);
+        free(sp->description);
+        free(sp);
+     }
 
-   EINA_LIST_FOREACH(ev->ports, l, port)
+   EINA_LIST_FOREACH(ports, l, port)
      {
         sp = calloc(1, sizeof(struct Sink_Port));
         sp->name = strdup(port->name);
@@ -73,8 +73,24 @@ _sink_add_cb(void *data, int type EINA_UNUSED, void *info)
            sp->active = EINA_TRUE;
         sink->ports = eina_list_append(sink->ports, sp);
      }
+}
+
+static Eina_Bool
+_sink_add_cb(void *data, int type EINA_UNUSED, void *info)
+{
+   struct Sinks_View *sv = data;
+   Epulse_Event_Sink *ev = info;
+   struct Sink *sink = calloc(1, sizeof(struct Sink));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(sink, ECORE_CALLBACK_PASS_ON);
+
+   sink->name = eina_stringshare_add(ev->base.name);
+   sink->index = ev->base.index;
+   sink->volume = ev->base.volume;
+   sink->mute = ev->base.mute;
+   _sink_ports_set(sink, ev->ports);
 
    sv->sinks = eina_list_append(sv->sinks, sink);
+   name_filter_row_set(sv->genlist, sink, sink->name);
    sink->item = elm_genlist_item_append(sv->genlist, sv->itc, sink, NULL,
                                         ELM_GENLIST_ITEM_NONE, NULL, sv);
 
@@ -94,6 +110,7 @@ _sink_removed_cb(void *data, int type EINA_UNUSED, void *info)
         if (sink->index == ev->base.index)
           {
              sv->sinks = eina_list_remove_list(sv->sinks, l);
+             name_filter_row_del(sv->genlist, sink);
              elm_object_item_del(sink->item);
              break;
           }
@@ -115,17 +132,40 @@ _sink_changed_cb(void *data, int type EINA_UNUSED, void *info)
      {
         if (sink->index == ev->base.index)
           {
-             pa_volume_t vol = pa_cvolume_avg(&ev->base.volume);
-
-             item = elm_object_item_part_content_get(sink->item, "slider");
-             sink->volume = ev->base.volume;
-             if (item)
-                elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
-
-             item = elm_object_item_part_content_get(sink->item, "mute");
-             sink->mute = ev->base.mute;
-             if (item)
-                elm_check_state_set(item, sink->mute);
+             if (ev->base.changed & EPULSE_CHANGE_VOLUME)
+               {
+                  pa_volume_t vol = pa_cvolume_avg(&ev->base.volume);
+
+                  item = elm_object_item_part_content_get(sink->item,
+                                                          "slider");
+                  sink->volume = ev->base.volume;
+                  if (item && !epulse_slider_dragging_get(item))
+                     elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
+               }
+
+             if (ev->base.changed & EPULSE_CHANGE_MUTE)
+               {
+                  item = elm_object_item_part_content_get(sink->item, "mute");
+                  sink->mute = ev->base.mute;
+                  if (item)
+                     elm_check_state_set(item, sink->mute);
+               }
+
+             if (ev->base.changed & EPULSE_CHANGE_NAME)
+               {
+                  eina_stringshare_replace(&sink->name, ev->base.name);
+                  name_filter_row_set(sv->genlist, sink, sink->name);
+                  elm_genlist_item_fields_update(sink->item, "name",
+                                                 ELM_GENLIST_ITEM_FIELD_TEXT);
+               }
+
+             if (ev->base.changed &
+                 (EPULSE_CHANGE_PORTS | EPULSE_CHANGE_ACTIVE_PORT))
+               {
+                  _sink_ports_set(sink, ev->ports);
+                  elm_genlist_item_fields_update(sink->item, "hover",
+                                                 ELM_GENLIST_ITEM_FIELD_CONTENT);
+               }
 
              break;
           }
@@ -182,6 +222,7 @@ _item_del(void *data, Evas_Object *obj EINA_UNUSED)
    struct Sink *sink = data;
    struct Sink_Port *port;
 
+   epulse_slider_throttle_release(sink);
    eina_stringshare_del(sink->name);
    EINA_LIST_FREE(sink->ports, port)
      {
@@ -193,11 +234,9 @@ _item_del(void *data, Evas_Object *obj EINA_UNUSED)
 }
 
 static void
-_volume_changed_cb(void *data, Evas_Object *o,
-                   void *event_info EINA_UNUSED)
+_volume_changed_cb(void *data, double val)
 {
    struct Sink *sink = data;
-   double val = elm_slider_value_get(o);
    pa_volume_t v = INT_TO_PA_VOLUME(val);
 
    pa_cvolume_set(&sink->volume, sink->volume.channels, v);
@@ -251,8 +290,11 @@ _item_content_get(void *data, Evas_Object *obj, const char *part)
         elm_slider_span_size_set(item, 120);
         elm_slider_min_max_set(item, 0.0, 100.0);
         elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
-        evas_object_smart_callback_add(item, "delay,changed",
-                                       _volume_changed_cb, sink);
+        epulse_slider_throttle_add(item, _volume_changed_cb, sink);
+     }
+   else if (!strcmp(part, "meter"))
+     {
+        item = epulse_meter_widget_add(obj, EPULSE_METER_SINK, sink->index);
      }
    else if (!strcmp(part, "mute"))
      {
@@ -290,6 +332,51 @@ _item_content_get(void *data, Evas_Object *obj, const char *part)
    return item;
 }
 
+#ifdef EPULSE_GENLIST_REUSE
+/* the slider and the check of a row scrolled away serve the next one */
+static Evas_Object *
+_item_content_reuse(void *data, Evas_Object *obj EINA_UNUSED,
+                    const char *part, Evas_Object *old)
+{
+   struct Sink *sink = data;
+
+   if (!strcmp(part, "slider"))
+     {
+        pa_volume_t vol = pa_cvolume_avg(&sink->volume);
+
+        epulse_slider_throttle_retarget(old, _volume_changed_cb, sink);
+        elm_slider_value_set(old, PA_VOLUME_TO_INT(vol));
+        return old;
+     }
+   else if (!strcmp(part, "mute"))
+     {
+        evas_object_smart_callback_del(old, "changed", _mute_changed_cb);
+        elm_check_state_pointer_set(old, &sink->mute);
+        evas_object_smart_callback_add(old, "changed", _mute_changed_cb, sink);
+        return old;
+     }
+
+   return NULL;
+}
+#endif
+
+#ifdef EPULSE_GENLIST_FILTER
+static Eina_Bool
+_item_filter_get(void *data, Evas_Object *obj, void *key EINA_UNUSED)
+{
+   return name_filter_match(obj, data);
+}
+#endif
+
+void
+sinks_view_filter_set(Evas_Object *obj, const char *query)
+{
+   struct Sinks_View *sv = evas_object_data_get(obj, SINKS_KEY);
+
+   EINA_SAFETY_ON_NULL_RETURN(sv);
+
+   name_filter_query_set(sv->genlist, query);
+}
 
 Evas_Object *
 sinks_view_add(Evas_Object *parent)
@@ -307,11 +394,14 @@ sinks_view_add(Evas_Object *parent)
 
    sv->genlist = elm_genlist_add(layout);
    EINA_SAFETY_ON_NULL_GOTO(sv->genlist, err_genlist);
+   epulse_genlist_large_set(sv->genlist, EINA_TRUE);
+   name_filter_add(sv->genlist);
 
    sv->disconnected = ecore_event_handler_add(DISCONNECTED,
                                               _disconnected_cb, sv);
    sv->sink_added = ecore_event_handler_add(SINK_ADDED, _sink_add_cb, sv);
-   sv->sink_added = ecore_event_handler_add(SINK_CHANGED, _sink_changed_cb, sv);
+   sv->sink_changed = ecore_event_handler_add(SINK_CHANGED,
+                                              _sink_changed_cb, sv);
    sv->sink_removed = ecore_event_handler_add(SINK_REMOVED,
                                               _sink_removed_cb, sv);
 
@@ -320,6 +410,12 @@ sinks_view_add(Evas_Object *parent)
    sv->itc->item_style = "sinks";
    sv->itc->func.text_get = _item_text_get;
    sv->itc->func.content_get = _item_content_get;
+#ifdef EPULSE_GENLIST_REUSE
+   sv->itc->func.reusable_content_get = _item_content_reuse;
+#endif
+#ifdef EPULSE_GENLIST_FILTER
+   sv->itc->func.filter_get = _item_filter_get;
+#endif
    sv->itc->func.del = _item_del;
 
    evas_object_data_set(layout, SINKS_KEY, sv);
@@ -8,6 +8,7 @@
 #endif
 
 Evas_Object *sinks_view_add(Evas_Object *parent);
+void sinks_view_filter_set(Evas_Object *obj, const char *query);
 
 
 #endif /* _SINKS_VIEW_H_ */
@@ -1,6 +1,8 @@
 #include "sources_view.h"
 
 #include "epulse.h"
+#include "name_filter.h"
+#include "spectrum.h"
 
 #define SOURCES_KEY "sources.key"
 
@@ -18,6 +20,7 @@ struct Sources_View
 {
    Evas_Object *self;
    Evas_Object *genlist;
+   Evas_Object *spectrum;
    Elm_Genlist_Item_Class *itc;
 
    Eina_List *sources;
@@ -35,6 +38,7 @@ _disconnected_cb(void *data, int type EINA_UNUSED, void *info EINA_UNUSED)
 
    EINA_LIST_FREE(sv->sources, source)
       elm_object_item_del(source->item);
+   name_filter_clear(sv->genlist);
 
    return ECORE_CALLBACK_PASS_ON;
 }
@@ -53,6 +57,7 @@ _source_add_cb(void *data, int type EINA_UNUSED, void *info)
    source->mute = ev->mute;
 
    sv->sources = eina_list_append(sv->sources, source);
+   name_filter_row_set(sv->genlist, source, source->name);
    source->item = elm_genlist_item_append(sv->genlist, sv->itc, source, NULL,
                                           ELM_GENLIST_ITEM_NONE, NULL, sv);
 
@@ -72,6 +77,9 @@ _source_removed_cb(void *data, int type EINA_UNUSED, void *info)
         if (source->index == ev->index)
           {
              sv->sources = eina_list_remove_list(sv->sources, l);
+             if (elm_genlist_selected_item_get(sv->genlist) == source->item)
+                spectrum_source_set(sv->spectrum, -1);
+             name_filter_row_del(sv->genlist, source);
              elm_object_item_del(source->item);
              break;
           }
@@ -93,18 +101,32 @@ _source_changed_cb(void *data, int type EINA_UNUSED, void *info)
      {
         if (source->index == ev->index)
           {
-             pa_volume_t vol = pa_cvolume_avg(&ev->volume);
+             if (ev->changed & EPULSE_CHANGE_VOLUME)
+               {
+                  pa_volume_t vol = pa_cvolume_avg(&ev->volume);
+
+                  item = elm_object_item_part_content_get(source->item,
+                                                          "slider");
+                  source->volume = ev->volume;
+                  if (item && !epulse_slider_dragging_get(item))
+                     elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
+               }
 
-             item = elm_object_item_part_content_get(source->item, "slider");
-             source->volume = ev->volume;
-             if (item)
-                elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
+             if (ev->changed & EPULSE_CHANGE_MUTE)
+               {
+                  item = elm_object_item_part_content_get(source->item,
+                                                          "mute");
+                  source->mute = ev->mute;
+                  if (item)
+                     elm_check_state_set(item, source->mute);
+               }
 
-             item = elm_object_item_part_content_get(source->item, "mute");
-             source->mute = ev->mute;
-             if (item)
+             if (ev->changed & EPULSE_CHANGE_NAME)
                {
-                  elm_check_state_set(item, source->mute);
+                  eina_stringshare_replace(&source->name, ev->name);
+                  name_filter_row_set(sv->genlist, source, source->name);
+                  elm_genlist_item_fields_update(source->item, "name",
+                                                 ELM_GENLIST_ITEM_FIELD_TEXT);
                }
              break;
           }
@@ -160,16 +182,15 @@ _item_del(void *data, Evas_Object *obj EINA_UNUSED)
 {
    struct Source *source = data;
 
+   epulse_slider_throttle_release(source);
    eina_stringshare_del(source->name);
    free(source);
 }
 
 static void
-_volume_changed_cb(void *data, Evas_Object *o,
-                   void *event_info EINA_UNUSED)
+_volume_changed_cb(void *data, double val)
 {
    struct Source *source = data;
-   double val = elm_slider_value_get(o);
    pa_volume_t v = INT_TO_PA_VOLUME(val);
 
    pa_cvolume_set(&source->volume, source->volume.channels, v);
@@ -209,8 +230,11 @@ _item_content_get(void *data, Evas_Object *obj, const char *part)
         elm_slider_span_size_set(item, 120);
         elm_slider_min_max_set(item, 0.0, 100.0);
         elm_slider_value_set(item, PA_VOLUME_TO_INT(vol));
-        evas_object_smart_callback_add(item, "delay,changed",
-                                       _volume_changed_cb, source);
+        epulse_slider_throttle_add(item, _volume_changed_cb, source);
+     }
+   else if (!strcmp(part, "meter"))
+     {
+        item = epulse_meter_widget_add(obj, EPULSE_METER_SOURCE, source->index);
      }
    else if (!strcmp(part, "mute"))
      {
@@ -230,10 +254,74 @@ _item_content_get(void *data, Evas_Object *obj, const char *part)
    return item;
 }
 
+#ifdef EPULSE_GENLIST_REUSE
+/* the slider and the check of a row scrolled away serve the next one */
+static Evas_Object *
+_item_content_reuse(void *data, Evas_Object *obj EINA_UNUSED,
+                    const char *part, Evas_Object *old)
+{
+   struct Source *source = data;
+
+   if (!strcmp(part, "slider"))
+     {
+        pa_volume_t vol = pa_cvolume_avg(&source->volume);
+
+        epulse_slider_throttle_retarget(old, _volume_changed_cb, source);
+        elm_slider_value_set(old, PA_VOLUME_TO_INT(vol));
+        return old;
+     }
+   else if (!strcmp(part, "mute"))
+     {
+        evas_object_smart_callback_del(old, "changed", _mute_changed_cb);
+        elm_check_state_pointer_set(old, &source->mute);
+        evas_object_smart_callback_add(old, "changed", _mute_changed_cb,
+                                       source);
+        return old;
+     }
+
+   return NULL;
+}
+#endif
+
+#ifdef EPULSE_GENLIST_FILTER
+static Eina_Bool
+_item_filter_get(void *data, Evas_Object *obj, void *key EINA_UNUSED)
+{
+   return name_filter_match(obj, data);
+}
+#endif
+
+static void
+_selected_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info)
+{
+   struct Sources_View *sv = data;
+   struct Source *source = elm_object_item_data_get(event_info);
+
+   spectrum_source_set(sv->spectrum, source->index);
+}
+
+static void
+_spectrum_toggle_cb(void *data, Evas_Object *obj,
+                    void *event_info EINA_UNUSED)
+{
+   struct Sources_View *sv = data;
+
+   spectrum_enabled_set(sv->spectrum, elm_check_state_get(obj));
+}
+void
+sources_view_filter_set(Evas_Object *obj, const char *query)
+{
+   struct Sources_View *sv = evas_object_data_get(obj, SOURCES_KEY);
+
+   EINA_SAFETY_ON_NULL_RETURN(sv);
+
+   name_filter_query_set(sv->genlist, query);
+}
+
 Evas_Object *
 sources_view_add(Evas_Object *parent)
 {
-   Evas_Object *layout;
+   Evas_Object *layout, *box, *check;
    struct Sources_View *sv;
 
    sv = calloc(1, sizeof(struct Sources_View));
@@ -246,6 +334,8 @@ sources_view_add(Evas_Object *parent)
 
    sv->genlist = elm_genlist_add(layout);
    EINA_SAFETY_ON_NULL_GOTO(sv->genlist, err_genlist);
+   epulse_genlist_large_set(sv->genlist, EINA_TRUE);
+   name_filter_add(sv->genlist);
 
    sv->disconnected = ecore_event_handler_add(DISCONNECTED,
                                               _disconnected_cb, sv);
@@ -260,15 +350,40 @@ sources_view_add(Evas_Object *parent)
    sv->itc->item_style = "sources";
    sv->itc->func.text_get = _item_text_get;
    sv->itc->func.content_get = _item_content_get;
+#ifdef EPULSE_GENLIST_REUSE
+   sv->itc->func.reusable_content_get = _item_content_reuse;
+#endif
+#ifdef EPULSE_GENLIST_FILTER
+   sv->itc->func.filter_get = _item_filter_get;
+#endif
    sv->itc->func.del = _item_del;
 
    evas_object_data_set(layout, SOURCES_KEY, sv);
-   elm_layout_content_set(layout, "list", sv->genlist);
+   evas_object_smart_callback_add(sv->genlist, "selected", _selected_cb, sv);
+
+   box = elm_box_add(layout);
+   evas_object_size_hint_weight_set(box, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   evas_object_size_hint_align_set(box, EVAS_HINT_FILL, EVAS_HINT_FILL);
+   elm_layout_content_set(layout, "list", box);
 
    evas_object_size_hint_weight_set(sv->genlist, EVAS_HINT_EXPAND,
                                     EVAS_HINT_EXPAND);
    evas_object_size_hint_align_set(sv->genlist, EVAS_HINT_FILL,
                                    EVAS_HINT_FILL);
+   elm_box_pack_end(box, sv->genlist);
+   evas_object_show(sv->genlist);
+
+   /* Optional spectrum of the selected source, hidden until enabled */
+   check = elm_check_add(box);
+   elm_object_text_set(check, _("Spectrum"));
+   evas_object_size_hint_align_set(check, 0.0, 0.5);
+   evas_object_smart_callback_add(check, "changed", _spectrum_toggle_cb, sv);
+   elm_box_pack_end(box, check);
+   evas_object_show(check);
+
+   sv->spectrum = spectrum_add(box);
+   if (sv->spectrum)
+      elm_box_pack_end(box, sv->spectrum);
 
    return layout;
 
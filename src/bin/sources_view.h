@@ -8,6 +8,7 @@
 #endif
 
 Evas_Object *sources_view_add(Evas_Object *parent);
+void sources_view_filter_set(Evas_Object *obj, const char *query);
 
 
 #endif /* _SOURCES_VIEW_H_ */
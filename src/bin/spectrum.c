@@ -0,0 +1,262 @@
+#include "spectrum.h"
+
+#include "epulse.h"
+
+#define SPECTRUM_KEY "spectrum.key"
+#define SPECTRUM_FFT_SIZE 2048
+#define SPECTRUM_BANDS 64
+#define SPECTRUM_WIDTH (SPECTRUM_BANDS * 4)
+#define SPECTRUM_HEIGHT 96
+#define SPECTRUM_DECAY 0.85f
+
+struct Spectrum
+{
+   Evas_Object *image;
+   Ecore_Animator *animator;
+   Epulse_Spectrum *analyzer;
+   /* the image and its smart parents, any of them hides the spectrum */
+   Eina_List *watched;
+   Eina_Bool frozen;
+
+   int index;
+   Eina_Bool enabled;
+
+   float bands[SPECTRUM_BANDS];
+   float shown[SPECTRUM_BANDS];
+};
+
+static Eina_Bool
+_visible_get(Evas_Object *obj)
+{
+   /* the naviframe hides the page, not our image, so walk up the tree */
+   for (; obj; obj = evas_object_smart_parent_get(obj))
+      if (!evas_object_visible_get(obj))
+         return EINA_FALSE;
+
+   return EINA_TRUE;
+}
+
+static void
+_draw(struct Spectrum *sp)
+{
+   unsigned int *pixels;
+   int stride, b, x, y, h;
+
+   pixels = evas_object_image_data_get(sp->image, EINA_TRUE);
+   EINA_SAFETY_ON_NULL_RETURN(pixels);
+   stride = evas_object_image_stride_get(sp->image) / 4;
+
+   for (y = 0; y < SPECTRUM_HEIGHT; y++)
+      memset(pixels + y * stride, 0, SPECTRUM_WIDTH * 4);
+
+   for (b = 0; b < SPECTRUM_BANDS; b++)
+     {
+        h = sp->shown[b] * SPECTRUM_HEIGHT;
+        for (y = SPECTRUM_HEIGHT - h; y < SPECTRUM_HEIGHT; y++)
+           for (x = b * 4; x < b * 4 + 3; x++)
+              pixels[y * stride + x] = 0xff3399ff;
+     }
+
+   evas_object_image_data_set(sp->image, pixels);
+   evas_object_image_data_update_add(sp->image, 0, 0, SPECTRUM_WIDTH,
+                                     SPECTRUM_HEIGHT);
+}
+
+/* no frames and no capture while the page or the window is hidden */
+static void
+_visibility_update(struct Spectrum *sp)
+{
+   Eina_Bool visible;
+
+   if (!sp->animator)
+      return;
+
+   visible = _visible_get(sp->image);
+   if (visible && sp->frozen)
+      ecore_animator_thaw(sp->animator);
+   else if (!visible && !sp->frozen)
+      ecore_animator_freeze(sp->animator);
+   sp->frozen = !visible;
+
+   if (sp->analyzer)
+      epulse_spectrum_pause_set(sp->analyzer, !visible);
+}
+
+static void _watch_set(struct Spectrum *sp, Eina_Bool watch);
+
+static void
+_watched_visibility_cb(void *data, Evas *e EINA_UNUSED,
+                       Evas_Object *o EINA_UNUSED,
+                       void *event_info EINA_UNUSED)
+{
+   _visibility_update(data);
+}
+
+static void
+_watched_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *o EINA_UNUSED,
+                void *event_info EINA_UNUSED)
+{
+   _watch_set(data, EINA_FALSE);
+}
+
+static void
+_watch_set(struct Spectrum *sp, Eina_Bool watch)
+{
+   Evas_Object *obj;
+
+   EINA_LIST_FREE(sp->watched, obj)
+     {
+        evas_object_event_callback_del_full(obj, EVAS_CALLBACK_SHOW,
+                                            _watched_visibility_cb, sp);
+        evas_object_event_callback_del_full(obj, EVAS_CALLBACK_HIDE,
+                                            _watched_visibility_cb, sp);
+        evas_object_event_callback_del_full(obj, EVAS_CALLBACK_DEL,
+                                            _watched_del_cb, sp);
+     }
+
+   if (!watch)
+      return;
+
+   for (obj = sp->image; obj; obj = evas_object_smart_parent_get(obj))
+     {
+        evas_object_event_callback_add(obj, EVAS_CALLBACK_SHOW,
+                                       _watched_visibility_cb, sp);
+        evas_object_event_callback_add(obj, EVAS_CALLBACK_HIDE,
+                                       _watched_visibility_cb, sp);
+        if (obj != sp->image)
+           evas_object_event_callback_add(obj, EVAS_CALLBACK_DEL,
+                                          _watched_del_cb, sp);
+        sp->watched = eina_list_append(sp->watched, obj);
+     }
+}
+
+static Eina_Bool
+_animator_cb(void *data)
+{
+   struct Spectrum *sp = data;
+   Eina_Bool falling = EINA_FALSE;
+   int b;
+
+   if (!sp->analyzer && sp->index >= 0)
+      sp->analyzer = epulse_spectrum_add(EPULSE_METER_SOURCE, sp->index,
+                                         SPECTRUM_FFT_SIZE);
+   if (!sp->analyzer)
+      return ECORE_CALLBACK_RENEW;
+
+   /* let stale bands fall off when the source stops sending */
+   if (!epulse_spectrum_bands_get(sp->analyzer, sp->bands, SPECTRUM_BANDS))
+     for (b = 0; b < SPECTRUM_BANDS; b++)
+        sp->bands[b] *= SPECTRUM_DECAY;
+
+   for (b = 0; b < SPECTRUM_BANDS; b++)
+     {
+        float v = sp->shown[b] * SPECTRUM_DECAY;
+
+        if (sp->bands[b] > v)
+           v = sp->bands[b];
+        if (v != sp->shown[b])
+           falling = EINA_TRUE;
+        sp->shown[b] = v;
+     }
+
+   if (falling)
+      _draw(sp);
+
+   return ECORE_CALLBACK_RENEW;
+}
+
+static void
+_analyzer_reset(struct Spectrum *sp)
+{
+   epulse_spectrum_del(sp->analyzer);
+   sp->analyzer = NULL;
+   memset(sp->shown, 0, sizeof(sp->shown));
+   _draw(sp);
+}
+
+static void
+_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *o EINA_UNUSED,
+        void *event_info EINA_UNUSED)
+{
+   struct Spectrum *sp = data;
+
+   _watch_set(sp, EINA_FALSE);
+   if (sp->animator)
+      ecore_animator_del(sp->animator);
+   epulse_spectrum_del(sp->analyzer);
+   free(sp);
+}
+
+void
+spectrum_source_set(Evas_Object *obj, int index)
+{
+   struct Spectrum *sp = evas_object_data_get(obj, SPECTRUM_KEY);
+   EINA_SAFETY_ON_NULL_RETURN(sp);
+
+   if (sp->index == index)
+      return;
+
+   sp->index = index;
+   _analyzer_reset(sp);
+}
+
+void
+spectrum_enabled_set(Evas_Object *obj, Eina_Bool enabled)
+{
+   struct Spectrum *sp = evas_object_data_get(obj, SPECTRUM_KEY);
+   EINA_SAFETY_ON_NULL_RETURN(sp);
+
+   if (sp->enabled == !!enabled)
+      return;
+
+   sp->enabled = !!enabled;
+   if (sp->enabled)
+     {
+        sp->animator = ecore_animator_add(_animator_cb, sp);
+        sp->frozen = EINA_FALSE;
+        evas_object_show(obj);
+        _watch_set(sp, EINA_TRUE);
+        _visibility_update(sp);
+     }
+   else
+     {
+        _watch_set(sp, EINA_FALSE);
+        ecore_animator_del(sp->animator);
+        sp->animator = NULL;
+        _analyzer_reset(sp);
+        evas_object_hide(obj);
+     }
+}
+
+Evas_Object *
+spectrum_add(Evas_Object *parent)
+{
+   struct Spectrum *sp;
+   Evas_Object *img;
+
+   sp = calloc(1, sizeof(struct Spectrum));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(sp, NULL);
+   sp->index = -1;
+
+   img = evas_object_image_filled_add(evas_object_evas_get(parent));
+   EINA_SAFETY_ON_NULL_GOTO(img, err);
+
+   evas_object_image_colorspace_set(img, EVAS_COLORSPACE_ARGB8888);
+   evas_object_image_alpha_set(img, EINA_TRUE);
+   evas_object_image_size_set(img, SPECTRUM_WIDTH, SPECTRUM_HEIGHT);
+   evas_object_image_smooth_scale_set(img, EINA_FALSE);
+   evas_object_size_hint_min_set(img, SPECTRUM_WIDTH, SPECTRUM_HEIGHT);
+   evas_object_size_hint_weight_set(img, EVAS_HINT_EXPAND, 0.0);
+   evas_object_size_hint_align_set(img, EVAS_HINT_FILL, EVAS_HINT_FILL);
+
+   sp->image = img;
+   evas_object_data_set(img, SPECTRUM_KEY, sp);
+   evas_object_event_callback_add(img, EVAS_CALLBACK_DEL, _del_cb, sp);
+   _draw(sp);
+
+   return img;
+
+ err:
+   free(sp);
+   return NULL;
+}
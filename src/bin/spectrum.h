@@ -0,0 +1,14 @@
+#ifndef _SPECTRUM_H_
+#define _SPECTRUM_H_
+
+#include "common.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+Evas_Object *spectrum_add(Evas_Object *parent);
+void spectrum_source_set(Evas_Object *obj, int index);
+void spectrum_enabled_set(Evas_Object *obj, Eina_Bool enabled);
+
+#endif /* _SPECTRUM_H_ */
@@ -1,6 +1,25 @@
 #include "common.h"
 
+#define THROTTLE_KEY "epulse.throttle"
+
 int _log_domain = -1;
+static double _volume_rate = EPULSE_VOLUME_RATE;
+static Eina_List *_slider_throttles = NULL;
+
+struct _Epulse_Throttle
+{
+   Epulse_Throttle_Cb cb;
+   const void *data;
+   double interval;
+   Ecore_Timer *timer;
+
+   double pending;
+   double last;
+   Eina_Bool has_pending;
+
+   unsigned int pushed;
+   unsigned int sent;
+};
 
 Eina_Bool
 epulse_common_init(const char *domain)
@@ -25,6 +44,9 @@ epulse_common_init(const char *domain)
         goto err_ecore;
      }
 
+   if (getenv("EPULSE_VOLUME_RATE"))
+      epulse_volume_rate_set(atof(getenv("EPULSE_VOLUME_RATE")));
+
    return EINA_TRUE;
 
  err_ecore:
@@ -62,3 +84,257 @@ Evas_Object *epulse_layout_add(Evas_Object *parent, const char *group,
 
    return layout;
 }
+
+void
+epulse_volume_rate_set(double rate)
+{
+   if (rate < 0.0)
+      rate = 0.0;
+
+   _volume_rate = rate;
+}
+
+double
+epulse_volume_rate_get(void)
+{
+   return _volume_rate;
+}
+
+static void
+_throttle_send(Epulse_Throttle *throttle, double value)
+{
+   throttle->has_pending = EINA_FALSE;
+   /* released, its row is gone */
+   if (!throttle->cb)
+      return;
+   if (throttle->sent > 0 && throttle->last == value)
+      return;
+
+   throttle->last = value;
+   throttle->sent++;
+   throttle->cb((void *)throttle->data, value);
+}
+
+static void
+_throttle_burst_end(Epulse_Throttle *throttle)
+{
+   if (throttle->pushed)
+      DBG("Volume burst: %u messages sent for %u updates",
+          throttle->sent, throttle->pushed);
+
+   throttle->pushed = 0;
+   throttle->sent = 0;
+}
+
+static Eina_Bool
+_throttle_timer_cb(void *data)
+{
+   Epulse_Throttle *throttle = data;
+
+   if (throttle->has_pending)
+     {
+        _throttle_send(throttle, throttle->pending);
+        return ECORE_CALLBACK_RENEW;
+     }
+
+   _throttle_burst_end(throttle);
+   throttle->timer = NULL;
+   return ECORE_CALLBACK_CANCEL;
+}
+
+Epulse_Throttle *
+epulse_throttle_new(double rate, Epulse_Throttle_Cb cb, const void *data)
+{
+   Epulse_Throttle *throttle;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(cb, NULL);
+
+   throttle = calloc(1, sizeof(Epulse_Throttle));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(throttle, NULL);
+
+   throttle->cb = cb;
+   throttle->data = data;
+   throttle->interval = (rate > 0.0) ? 1.0 / rate : 0.0;
+
+   return throttle;
+}
+
+void
+epulse_throttle_push(Epulse_Throttle *throttle, double value)
+{
+   EINA_SAFETY_ON_NULL_RETURN(throttle);
+
+   throttle->pushed++;
+   if (throttle->interval <= 0.0)
+     {
+        _throttle_send(throttle, value);
+        return;
+     }
+
+   if (throttle->timer)
+     {
+        throttle->pending = value;
+        throttle->has_pending = EINA_TRUE;
+        return;
+     }
+
+   _throttle_send(throttle, value);
+   throttle->timer = ecore_timer_add(throttle->interval, _throttle_timer_cb,
+                                     throttle);
+}
+
+void
+epulse_throttle_flush(Epulse_Throttle *throttle)
+{
+   EINA_SAFETY_ON_NULL_RETURN(throttle);
+
+   if (throttle->has_pending)
+      _throttle_send(throttle, throttle->pending);
+
+   if (throttle->timer)
+     {
+        ecore_timer_del(throttle->timer);
+        throttle->timer = NULL;
+     }
+
+   _throttle_burst_end(throttle);
+}
+
+Eina_Bool
+epulse_throttle_busy_get(const Epulse_Throttle *throttle)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(throttle, EINA_FALSE);
+
+   return !!throttle->timer;
+}
+
+void
+epulse_throttle_del(Epulse_Throttle *throttle)
+{
+   if (!throttle)
+      return;
+
+   if (throttle->timer)
+      ecore_timer_del(throttle->timer);
+
+   free(throttle);
+}
+
+static void
+_slider_changed_cb(void *data, Evas_Object *obj, void *event_info EINA_UNUSED)
+{
+   epulse_throttle_push(data, elm_slider_value_get(obj));
+}
+
+static void
+_slider_drag_stop_cb(void *data, Evas_Object *obj EINA_UNUSED,
+                     void *event_info EINA_UNUSED)
+{
+   epulse_throttle_flush(data);
+}
+
+static void
+_slider_del_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
+               void *event_info EINA_UNUSED)
+{
+   /* the end of a drag cut short still goes out */
+   epulse_throttle_flush(data);
+   _slider_throttles = eina_list_remove(_slider_throttles, data);
+   epulse_throttle_del(data);
+}
+
+void
+epulse_slider_throttle_add(Evas_Object *slider, Epulse_Throttle_Cb cb,
+                           const void *data)
+{
+   Epulse_Throttle *throttle;
+
+   EINA_SAFETY_ON_NULL_RETURN(slider);
+
+   throttle = epulse_throttle_new(_volume_rate, cb, data);
+   EINA_SAFETY_ON_NULL_RETURN(throttle);
+
+   evas_object_data_set(slider, THROTTLE_KEY, throttle);
+   _slider_throttles = eina_list_append(_slider_throttles, throttle);
+   evas_object_smart_callback_add(slider, "changed", _slider_changed_cb,
+                                  throttle);
+   evas_object_smart_callback_add(slider, "slider,drag,stop",
+                                  _slider_drag_stop_cb, throttle);
+   evas_object_event_callback_add(slider, EVAS_CALLBACK_DEL, _slider_del_cb,
+                                  throttle);
+}
+
+/*
+ * To be called before the row data given to slider throttles is freed:
+ * their pending value is sent while the row is still there, and they
+ * send nothing more until retargeted. Genlists may delete or cache the
+ * slider of a row after the row itself is gone.
+ */
+void
+epulse_slider_throttle_release(const void *data)
+{
+   Epulse_Throttle *throttle;
+   const Eina_List *l;
+
+   EINA_LIST_FOREACH(_slider_throttles, l, throttle)
+     {
+        if (throttle->data != data || !throttle->cb)
+           continue;
+
+        epulse_throttle_flush(throttle);
+        throttle->cb = NULL;
+        throttle->data = NULL;
+     }
+}
+
+/*
+ * Points the throttle of a recycled slider to its new row. What the old
+ * row still had pending goes to it first, unless the row was released.
+ */
+void
+epulse_slider_throttle_retarget(Evas_Object *slider, Epulse_Throttle_Cb cb,
+                                const void *data)
+{
+   Epulse_Throttle *throttle;
+
+   EINA_SAFETY_ON_NULL_RETURN(slider);
+   EINA_SAFETY_ON_NULL_RETURN(cb);
+
+   throttle = evas_object_data_get(slider, THROTTLE_KEY);
+   if (!throttle)
+     {
+        epulse_slider_throttle_add(slider, cb, data);
+        return;
+     }
+
+   epulse_throttle_flush(throttle);
+
+   throttle->cb = cb;
+   throttle->data = data;
+}
+
+Eina_Bool
+epulse_slider_dragging_get(const Evas_Object *slider)
+{
+   Epulse_Throttle *throttle;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(slider, EINA_FALSE);
+
+   throttle = evas_object_data_get(slider, THROTTLE_KEY);
+   if (!throttle)
+      return EINA_FALSE;
+
+   return epulse_throttle_busy_get(throttle);
+}
+
+void
+epulse_genlist_large_set(Evas_Object *genlist, Eina_Bool large)
+{
+   EINA_SAFETY_ON_NULL_RETURN(genlist);
+
+   elm_genlist_homogeneous_set(genlist, large);
+   elm_genlist_mode_set(genlist, large ? ELM_LIST_COMPRESS : ELM_LIST_SCROLL);
+   /* 32 is the genlist default */
+   elm_genlist_block_count_set(genlist,
+                               large ? EPULSE_GENLIST_BLOCK_COUNT : 32);
+}
@@ -17,6 +17,7 @@
 
 #define EPULSE_THEME PACKAGE_DATA_DIR"/data/themes/default.edj"
 #define BASE_VOLUME_STEP 10
+#define EPULSE_VOLUME_RATE 30.0 /* max volume writes per second while dragging */
 
 EAPI extern int _log_domain;
 
@@ -31,4 +32,68 @@ EAPI void epulse_common_shutdown(void);
 EAPI Evas_Object *epulse_layout_add(Evas_Object *parent, const char *group,
                                     const char *style);
 
+/*
+ * Rate limiter for volume writes. Values pushed faster than the configured
+ * rate are coalesced and only the latest one is sent when the interval
+ * expires, so the last value of a burst always reaches the server.
+ */
+typedef struct _Epulse_Throttle Epulse_Throttle;
+typedef void (*Epulse_Throttle_Cb)(void *data, double value);
+
+EAPI void epulse_volume_rate_set(double rate);
+EAPI double epulse_volume_rate_get(void);
+EAPI Epulse_Throttle *epulse_throttle_new(double rate, Epulse_Throttle_Cb cb,
+                                          const void *data);
+EAPI void epulse_throttle_push(Epulse_Throttle *throttle, double value);
+EAPI void epulse_throttle_flush(Epulse_Throttle *throttle);
+EAPI Eina_Bool epulse_throttle_busy_get(const Epulse_Throttle *throttle);
+EAPI void epulse_throttle_del(Epulse_Throttle *throttle);
+
+EAPI void epulse_slider_throttle_add(Evas_Object *slider,
+                                     Epulse_Throttle_Cb cb, const void *data);
+EAPI void epulse_slider_throttle_release(const void *data);
+EAPI void epulse_slider_throttle_retarget(Evas_Object *slider,
+                                          Epulse_Throttle_Cb cb,
+                                          const void *data);
+EAPI Eina_Bool epulse_slider_dragging_get(const Evas_Object *slider);
+
+/*
+ * Genlist settings for hundreds of rows: every row is sized from the
+ * first one realized, as wide as the list, and realized in small blocks.
+ * Row contents are recycled and rows filtered where the genlist supports
+ * it.
+ */
+#define EPULSE_GENLIST_BLOCK_COUNT 16
+#if ELM_VERSION_MAJOR > 1 || ELM_VERSION_MINOR >= 18
+# define EPULSE_GENLIST_REUSE 1
+# define EPULSE_GENLIST_FILTER 1
+#endif
+
+EAPI void epulse_genlist_large_set(Evas_Object *genlist, Eina_Bool large);
+
+/*
+ * Single instance command channel. The running mixer owns the socket and
+ * receives one command per line ("show", "hide", "toggle", "quit").
+ */
+#define EPULSE_IPC_NAME "epulse"
+
+typedef struct _Epulse_Ipc Epulse_Ipc;
+typedef struct _Epulse_Ipc_Client Epulse_Ipc_Client;
+typedef void (*Epulse_Ipc_Cb)(void *data, Epulse_Ipc_Client *client,
+                              const char *command);
+typedef void (*Epulse_Ipc_Done_Cb)(void *data, Eina_Bool delivered);
+/* returns EINA_FALSE once the last line of the reply was seen */
+typedef Eina_Bool (*Epulse_Ipc_Reply_Cb)(void *data, const char *line);
+
+EAPI Epulse_Ipc *epulse_ipc_server_add(const char *name, Epulse_Ipc_Cb cb,
+                                       const void *data);
+EAPI void epulse_ipc_server_del(Epulse_Ipc *ipc);
+EAPI void epulse_ipc_reply(Epulse_Ipc_Client *client, const char *fmt, ...)
+   EINA_PRINTF(2, 3);
+EAPI void epulse_ipc_request(const char *name, const char *command,
+                             Epulse_Ipc_Reply_Cb reply,
+                             Epulse_Ipc_Done_Cb cb, const void *data);
+EAPI void epulse_ipc_send(const char *command, Epulse_Ipc_Done_Cb cb,
+                          const void *data);
+
 #endif /* __COMMON_H__ */
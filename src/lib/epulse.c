@@ -1,17 +1,37 @@
-#include "epulse.h"
+#include "epulse_private.h"
 
 typedef struct _Epulse_Context Epulse_Context;
 struct _Epulse_Context {
    pa_mainloop_api api;
    pa_context *context;
    pa_context_state_t state;
+   pa_context_flags_t flags;
    void *data;
+
+   /* Last known state of every object, used to compute change masks */
+   Eina_Hash *sinks;
+   Eina_Hash *sink_inputs;
+   Eina_Hash *sources;
+
+   /* index of the default sink, kept for the state cache */
+   int default_sink;
+   /* server name of the default source, NULL until the server told */
+   char *default_source;
+   /* initial list requests still running after connecting */
+   unsigned int pending_lists;
+   /* the object hashes reflect the server and can be saved */
+   Eina_Bool synced;
+   /* rules and ducking run in this process, see epulse_ctl_server_add() */
+   Eina_Bool policies;
 };
 
 static unsigned int _init_count = 0;
 static Epulse_Context *ctx = NULL;
 extern pa_mainloop_api functable;
 
+/* userdata of the list requests sent on connection */
+static int _initial_list;
+
 int SINK_ADDED = 0;
 int SINK_CHANGED = 0;
 int SINK_DEFAULT = 0;
@@ -24,8 +44,220 @@ int SOURCE_CHANGED = 0;
 int SOURCE_REMOVED = 0;
 int SOURCE_INPUT_ADDED = 0;
 int SOURCE_INPUT_REMOVED = 0;
+int CONNECTED = 0;
 int DISCONNECTED = 0;
 
+static void
+_port_free(Port *port)
+{
+   free(port->name);
+   free(port->description);
+   free(port);
+}
+
+static Port *
+_port_dup(const Port *port)
+{
+   Port *dup = calloc(1, sizeof(Port));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(dup, NULL);
+
+   dup->active = port->active;
+   dup->available = port->available;
+   dup->priority = port->priority;
+   dup->name = port->name ? strdup(port->name) : NULL;
+   dup->description = port->description ? strdup(port->description) : NULL;
+
+   return dup;
+}
+
+static Eina_Bool
+_str_equal(const char *a, const char *b)
+{
+   if (!a || !b)
+      return a == b;
+
+   return !strcmp(a, b);
+}
+
+static const char *
+_ports_active_get(const Eina_List *ports)
+{
+   const Eina_List *l;
+   Port *port;
+
+   EINA_LIST_FOREACH(ports, l, port)
+      if (port->active)
+         return port->name;
+
+   return NULL;
+}
+
+static Eina_Bool
+_ports_equal(const Eina_List *a, const Eina_List *b)
+{
+   Port *pa, *pb;
+
+   if (eina_list_count(a) != eina_list_count(b))
+      return EINA_FALSE;
+
+   for (; a && b; a = eina_list_next(a), b = eina_list_next(b))
+     {
+        pa = eina_list_data_get(a);
+        pb = eina_list_data_get(b);
+        if (pa->available != pb->available ||
+            pa->priority != pb->priority ||
+            !_str_equal(pa->name, pb->name) ||
+            !_str_equal(pa->description, pb->description))
+           return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+static void
+_object_free_cb(void *data)
+{
+   Epulse_Object *obj = data;
+   Port *port;
+
+   free(obj->name);
+   free(obj->key);
+   free(obj->icon);
+   free(obj->binary);
+   free(obj->role);
+   EINA_LIST_FREE(obj->ports, port)
+      _port_free(port);
+   free(obj);
+}
+
+/*
+ * Objects loaded from the state cache were already announced with an
+ * ADDED event, so their first live info must be reported as a change.
+ */
+static Eina_Bool
+_object_stale_take(Eina_Hash *hash, int index)
+{
+   Epulse_Object *obj = eina_hash_find(hash, &index);
+
+   if (!obj || !obj->stale)
+      return EINA_FALSE;
+
+   obj->stale = EINA_FALSE;
+   return EINA_TRUE;
+}
+
+/*
+ * Indexes change when the server restarts, one only known from the
+ * cache may be another object by now. Setters refuse those.
+ */
+static Eina_Bool
+_object_stale_get(Eina_Hash *hash, int index)
+{
+   Epulse_Object *obj = eina_hash_find(hash, &index);
+
+   if (!obj || !obj->stale)
+      return EINA_FALSE;
+
+   WRN("Object %d is not confirmed by the server yet", index);
+   return EINA_TRUE;
+}
+
+/*
+ * Compares the event against the cached object with the same index,
+ * refreshes the cache and returns which fields differ. Objects seen
+ * for the first time report every field as changed.
+ */
+static unsigned int
+_object_cache_update(Eina_Hash *hash, const Epulse_Event *ev,
+                     const char *key, const Eina_List *ports,
+                     const char *icon, const Epulse_Event_Sink_Input *input)
+{
+   Epulse_Object *obj;
+   const Eina_List *l;
+   Port *port;
+   unsigned int changed = EPULSE_CHANGE_NONE;
+
+   obj = eina_hash_find(hash, &ev->index);
+   if (!obj)
+     {
+        obj = calloc(1, sizeof(Epulse_Object));
+        EINA_SAFETY_ON_NULL_RETURN_VAL(obj, EPULSE_CHANGE_ALL);
+        obj->index = ev->index;
+        obj->pid = -1;
+        eina_hash_add(hash, &obj->index, obj);
+        changed = EPULSE_CHANGE_ALL;
+     }
+
+   if (!pa_cvolume_equal(&obj->volume, &ev->volume))
+      changed |= EPULSE_CHANGE_VOLUME;
+   obj->volume = ev->volume;
+
+   if (obj->mute != ev->mute)
+      changed |= EPULSE_CHANGE_MUTE;
+   obj->mute = ev->mute;
+
+   if (!_str_equal(obj->name, ev->name))
+     {
+        changed |= EPULSE_CHANGE_NAME;
+        free(obj->name);
+        obj->name = ev->name ? strdup(ev->name) : NULL;
+     }
+
+   /* only reported for streams, consumers identify devices by index */
+   if (!_str_equal(obj->key, key))
+     {
+        if (input)
+           changed |= EPULSE_CHANGE_APP;
+        free(obj->key);
+        obj->key = key ? strdup(key) : NULL;
+     }
+
+   if (!_str_equal(obj->icon, icon))
+     {
+        changed |= EPULSE_CHANGE_ICON;
+        free(obj->icon);
+        obj->icon = icon ? strdup(icon) : NULL;
+     }
+
+   if (input)
+     {
+        if (obj->sink != input->sink)
+           changed |= EPULSE_CHANGE_SINK;
+        obj->sink = input->sink;
+
+        if (obj->corked != input->corked)
+           changed |= EPULSE_CHANGE_CORKED;
+        obj->corked = input->corked;
+
+        if (obj->pid != input->pid || !_str_equal(obj->binary, input->binary) ||
+            !_str_equal(obj->role, input->role))
+          {
+             changed |= EPULSE_CHANGE_APP;
+             free(obj->binary);
+             obj->binary = input->binary ? strdup(input->binary) : NULL;
+             free(obj->role);
+             obj->role = input->role ? strdup(input->role) : NULL;
+             obj->pid = input->pid;
+          }
+     }
+
+   if (!_str_equal(_ports_active_get(obj->ports), _ports_active_get(ports)))
+      changed |= EPULSE_CHANGE_ACTIVE_PORT;
+
+   if (!_ports_equal(obj->ports, ports))
+      changed |= EPULSE_CHANGE_PORTS;
+
+   if (changed & (EPULSE_CHANGE_PORTS | EPULSE_CHANGE_ACTIVE_PORT))
+     {
+        EINA_LIST_FREE(obj->ports, port)
+           _port_free(port);
+        EINA_LIST_FOREACH(ports, l, port)
+           obj->ports = eina_list_append(obj->ports, _port_dup(port));
+     }
+
+   return changed;
+}
+
 static void
 _event_free_cb(void *user_data EINA_UNUSED, void *func_data)
 {
@@ -45,8 +277,10 @@ _event_sink_input_free_cb(void *user_data EINA_UNUSED, void *func_data)
    if (ev->base.name)
       free(ev->base.name);
 
-   if (ev->icon)
-      free(ev->icon);
+   free(ev->icon);
+   free(ev->app);
+   free(ev->binary);
+   free(ev->role);
 
    free(ev);
 }
@@ -61,43 +295,26 @@ _event_sink_free_cb(void *user_data EINA_UNUSED, void *func_data)
       free(ev->base.name);
 
    EINA_LIST_FREE(ev->ports, port)
-     {
-        free(port->name);
-        free(port->description);
-        free(port);
-     }
+      _port_free(port);
 
    free(ev);
 }
 
-static void
-_sink_cb(pa_context *c EINA_UNUSED, const pa_sink_info *info, int eol,
-         void *userdata EINA_UNUSED)
+static Epulse_Event_Sink *
+_sink_event_new(const pa_sink_info *info)
 {
    Epulse_Event_Sink *ev;
    Port *port;
    uint32_t i;
 
-   if (eol < 0)
-     {
-        if (pa_context_errno(c) == PA_ERR_NOENTITY)
-           return;
-
-        ERR("Sink callback failure");
-        return;
-     }
-
-   if (eol > 0)
-      return;
-
-   DBG("sink index: %d\nsink name: %s", info->index,
-       info->name);
-
    ev = calloc(1, sizeof(Epulse_Event_Sink));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ev, NULL);
+
    ev->base.index = info->index;
    ev->base.name = strdup(info->description);
    ev->base.volume = info->volume;
    ev->base.mute = !!info->mute;
+   ev->base.changed = EPULSE_CHANGE_ALL;
 
    for (i = 0; i < info->n_ports; i++)
      {
@@ -107,26 +324,89 @@ _sink_cb(pa_context *c EINA_UNUSED, const pa_sink_info *info, int eol,
         port->available = !!info->ports[i]->available;
         port->priority = info->ports[i]->priority;
         port->name = strdup(info->ports[i]->name);
-        port->description =  strdup(info->ports[i]->description);
+        port->description = strdup(info->ports[i]->description ?:
+                                   info->ports[i]->name);
         ev->ports = eina_list_append(ev->ports, port);
-        if (info->ports[i]->name == info->active_port->name)
+        if (info->active_port &&
+            info->ports[i]->name == info->active_port->name)
            port->active = EINA_TRUE;
      }
 
-   ecore_event_add(SINK_ADDED, ev, _event_sink_free_cb, NULL);
-   return;
+   return ev;
 
  error:
    _event_sink_free_cb(NULL, ev);
+   return NULL;
+}
+
+static void
+_sink_monitor_set(const pa_sink_info *info)
+{
+   int index = info->index;
+   Epulse_Object *obj = eina_hash_find(ctx->sinks, &index);
+
+   if (obj)
+      obj->monitor = info->monitor_source;
+}
+
+static void _initial_list_done(void);
+
+static void
+_sink_cb(pa_context *c EINA_UNUSED, const pa_sink_info *info, int eol,
+         void *userdata)
+{
+   Epulse_Event_Sink *ev;
+   Eina_Bool stale;
+
+   if (eol < 0)
+     {
+        /* a failed listing still ends the initial one */
+        if (userdata == &_initial_list)
+           _initial_list_done();
+        if (pa_context_errno(c) == PA_ERR_NOENTITY)
+           return;
+
+        ERR("Sink callback failure");
+        return;
+     }
+
+   if (eol > 0)
+     {
+        if (userdata == &_initial_list)
+           _initial_list_done();
+        return;
+     }
+
+   DBG("sink index: %d\nsink name: %s", info->index,
+       info->name);
+
+   ev = _sink_event_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(ev);
+
+   stale = _object_stale_take(ctx->sinks, ev->base.index);
+   ev->base.changed = _object_cache_update(ctx->sinks, &ev->base, info->name,
+                                           ev->ports, NULL, NULL);
+   _sink_monitor_set(info);
+   if (!stale)
+      ev->base.changed = EPULSE_CHANGE_ALL;
+   else if (!ev->base.changed)
+     {
+        _event_sink_free_cb(NULL, ev);
+        return;
+     }
+
+   ecore_event_add(stale ? SINK_CHANGED : SINK_ADDED, ev,
+                   _event_sink_free_cb, NULL);
 }
 
 static void
 _sink_changed_cb(pa_context *c EINA_UNUSED, const pa_sink_info *info, int eol,
-                 void *userdata EINA_UNUSED)
+                 void *userdata)
 {
    Epulse_Event_Sink *ev;
-   Port *port;
-   uint32_t i;
+
+   if (eol != 0)
+      _epulse_batch_refresh_done(userdata);
 
    if (eol < 0)
      {
@@ -143,31 +423,21 @@ _sink_changed_cb(pa_context *c EINA_UNUSED, const pa_sink_info *info, int eol,
    DBG("sink index: %d\nsink name: %s", info->index,
        info->name);
 
-   ev = calloc(1, sizeof(Epulse_Event_Sink));
-   ev->base.index = info->index;
-   ev->base.name = strdup(info->name);
-   ev->base.volume = info->volume;
-   ev->base.mute = !!info->mute;
+   ev = _sink_event_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(ev);
 
-   for (i = 0; i < info->n_ports; i++)
+   ev->base.changed = _object_cache_update(ctx->sinks, &ev->base, info->name,
+                                           ev->ports, NULL, NULL);
+   _sink_monitor_set(info);
+   if (!ev->base.changed ||
+       _epulse_batch_changed(EPULSE_METER_SINK, ev->base.index,
+                             ev->base.changed))
      {
-        port = calloc(1, sizeof(Port));
-        EINA_SAFETY_ON_NULL_GOTO(port, error);
-
-        port->priority = info->ports[i]->priority;
-        port->available = !!info->ports[i]->available;
-        port->name = strdup(info->ports[i]->description ?:
-                            info->ports[i]->name);
-        ev->ports = eina_list_append(ev->ports, port);
-        if (info->ports[i]->name == info->active_port->name)
-           port->active = EINA_TRUE;
+        _event_sink_free_cb(NULL, ev);
+        return;
      }
 
    ecore_event_add(SINK_CHANGED, ev, _event_sink_free_cb, NULL);
-   return;
-
- error:
-   _event_sink_free_cb(NULL, ev);
 }
 
 static void
@@ -176,6 +446,8 @@ _sink_remove_cb(int index, void *data EINA_UNUSED)
    Epulse_Event_Sink *ev;
    DBG("Removing sink: %d", index);
 
+   eina_hash_del_by_key(ctx->sinks, &index);
+
    ev = calloc(1, sizeof(Epulse_Event_Sink));
    ev->base.index = index;
 
@@ -183,7 +455,7 @@ _sink_remove_cb(int index, void *data EINA_UNUSED)
 }
 
 static const char *
-_icon_from_properties(pa_proplist *l)
+_icon_from_properties(pa_proplist *l, const char *role)
 {
    const char *t;
 
@@ -196,34 +468,83 @@ _icon_from_properties(pa_proplist *l)
    if ((t = pa_proplist_gets(l, PA_PROP_APPLICATION_ICON_NAME)))
       return t;
 
-   if ((t = pa_proplist_gets(l, PA_PROP_MEDIA_ROLE)))
+   if (role)
      {
 
-        if (strcmp(t, "video") == 0 ||
-            strcmp(t, "phone") == 0)
-           return t;
+        if (strcmp(role, "video") == 0 ||
+            strcmp(role, "phone") == 0)
+           return role;
 
-        if (strcmp(t, "music") == 0)
+        if (strcmp(role, "music") == 0)
            return "audio";
 
-        if (strcmp(t, "game") == 0)
+        if (strcmp(role, "game") == 0)
            return "applications-games";
 
-        if (strcmp(t, "event") == 0)
+        if (strcmp(role, "event") == 0)
            return "dialog-information";
      }
 
    return "audio-card";
 }
 
+/*
+ * Reads who plays the stream, each property is looked up only once per
+ * info and the results are kept in the event.
+ */
+static void
+_app_from_properties(Epulse_Event_Sink_Input *ev,
+                     const pa_sink_input_info *info)
+{
+   pa_proplist *l = info->proplist;
+   const char *t, *role;
+
+   role = pa_proplist_gets(l, PA_PROP_MEDIA_ROLE);
+   ev->role = role ? strdup(role) : NULL;
+   ev->icon = strdup(_icon_from_properties(l, role));
+
+   t = pa_proplist_gets(l, PA_PROP_APPLICATION_NAME);
+   ev->app = strdup(t ? t : info->name);
+
+   t = pa_proplist_gets(l, PA_PROP_APPLICATION_PROCESS_BINARY);
+   ev->binary = t ? strdup(t) : NULL;
+
+   t = pa_proplist_gets(l, PA_PROP_APPLICATION_PROCESS_ID);
+   ev->pid = t ? atoi(t) : -1;
+}
+
+static Epulse_Event_Sink_Input *
+_sink_input_event_new(const pa_sink_input_info *info)
+{
+   Epulse_Event_Sink_Input *ev;
+
+   ev = calloc(1, sizeof(Epulse_Event_Sink_Input));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ev, NULL);
+
+   ev->base.index = info->index;
+   ev->base.name = strdup(info->name);
+   ev->base.volume = info->volume;
+   ev->base.mute = !!info->mute;
+   ev->base.changed = EPULSE_CHANGE_ALL;
+   ev->sink = info->sink;
+   ev->corked = !!info->corked;
+   _app_from_properties(ev, info);
+
+   return ev;
+}
+
 static void
 _sink_input_cb(pa_context *c EINA_UNUSED, const pa_sink_input_info *info,
-               int eol, void *userdata EINA_UNUSED)
+               int eol, void *userdata)
 {
    Epulse_Event_Sink_Input *ev;
+   Eina_Bool stale;
 
    if (eol < 0)
      {
+        /* a failed listing still ends the initial one */
+        if (userdata == &_initial_list)
+           _initial_list_done();
         if (pa_context_errno(c) == PA_ERR_NOENTITY)
            return;
 
@@ -232,29 +553,50 @@ _sink_input_cb(pa_context *c EINA_UNUSED, const pa_sink_input_info *info,
      }
 
    if (eol > 0)
-      return;
+     {
+        if (userdata == &_initial_list)
+           _initial_list_done();
+        return;
+     }
 
    DBG("sink input index: %d\nsink input name: %s", info->index,
        info->name);
 
-   ev = calloc(1, sizeof(Epulse_Event_Sink_Input));
-   ev->base.index = info->index;
-   ev->base.name = strdup(info->name);
-   ev->base.volume = info->volume;
-   ev->base.mute = !!info->mute;
-   ev->sink = info->sink;
-   ev->icon = strdup(_icon_from_properties(info->proplist));
+   ev = _sink_input_event_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(ev);
 
-   ecore_event_add(SINK_INPUT_ADDED, ev, _event_sink_input_free_cb, NULL);
+   stale = _object_stale_take(ctx->sink_inputs, ev->base.index);
+   /* a new stream, not one listed at connection time */
+   if (!stale && userdata != &_initial_list)
+      _epulse_rules_apply(ev);
+   ev->base.changed = _object_cache_update(ctx->sink_inputs, &ev->base,
+                                           ev->app, NULL, ev->icon, ev);
+   if (!stale)
+     {
+        ev->base.changed = EPULSE_CHANGE_ALL;
+        if (userdata != &_initial_list)
+           _epulse_duck_stream_added(ev);
+     }
+   else if (!ev->base.changed)
+     {
+        _event_sink_input_free_cb(NULL, ev);
+        return;
+     }
+
+   ecore_event_add(stale ? SINK_INPUT_CHANGED : SINK_INPUT_ADDED, ev,
+                   _event_sink_input_free_cb, NULL);
 }
 
 static void
 _sink_input_changed_cb(pa_context *c EINA_UNUSED,
                        const pa_sink_input_info *info, int eol,
-                       void *userdata EINA_UNUSED)
+                       void *userdata)
 {
    Epulse_Event_Sink_Input *ev;
 
+   if (eol != 0)
+      _epulse_batch_refresh_done(userdata);
+
    if (eol < 0)
      {
         if (pa_context_errno(c) == PA_ERR_NOENTITY)
@@ -269,10 +611,20 @@ _sink_input_changed_cb(pa_context *c EINA_UNUSED,
 
    DBG("sink input changed index: %d\n", info->index);
 
-   ev = calloc(1, sizeof(Epulse_Event_Sink_Input));
-   ev->base.index = info->index;
-   ev->base.volume = info->volume;
-   ev->base.mute = !!info->mute;
+   ev = _sink_input_event_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(ev);
+
+   ev->base.changed = _object_cache_update(ctx->sink_inputs, &ev->base,
+                                           ev->app, NULL, ev->icon, ev);
+   _epulse_rules_update(ev);
+   _epulse_duck_stream_changed(ev);
+   if (!ev->base.changed ||
+       _epulse_batch_changed(EPULSE_METER_SINK_INPUT, ev->base.index,
+                             ev->base.changed))
+     {
+        _event_sink_input_free_cb(NULL, ev);
+        return;
+     }
 
    ecore_event_add(SINK_INPUT_CHANGED, ev, _event_sink_input_free_cb,
                    NULL);
@@ -285,20 +637,44 @@ _sink_input_remove_cb(int index, void *data EINA_UNUSED)
 
    DBG("Removing sink input: %d", index);
 
+   eina_hash_del_by_key(ctx->sink_inputs, &index);
+   _epulse_duck_stream_removed(index);
+
    ev = calloc(1, sizeof(Epulse_Event_Sink_Input));
    ev->base.index = index;
 
    ecore_event_add(SINK_INPUT_REMOVED, ev, _event_sink_input_free_cb, NULL);
 }
 
+static Epulse_Event *
+_source_event_new(const pa_source_info *info)
+{
+   Epulse_Event *ev;
+
+   ev = calloc(1, sizeof(Epulse_Event));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ev, NULL);
+
+   ev->index = info->index;
+   ev->name = strdup(info->name);
+   ev->volume = info->volume;
+   ev->mute = !!info->mute;
+   ev->changed = EPULSE_CHANGE_ALL;
+
+   return ev;
+}
+
 static void
 _source_cb(pa_context *c EINA_UNUSED, const pa_source_info *info,
-           int eol, void *userdata EINA_UNUSED)
+           int eol, void *userdata)
 {
    Epulse_Event *ev;
+   Eina_Bool stale;
 
    if (eol < 0)
      {
+        /* a failed listing still ends the initial one */
+        if (userdata == &_initial_list)
+           _initial_list_done();
         if (pa_context_errno(c) == PA_ERR_NOENTITY)
            return;
 
@@ -307,24 +683,40 @@ _source_cb(pa_context *c EINA_UNUSED, const pa_source_info *info,
      }
 
    if (eol > 0)
-      return;
+     {
+        if (userdata == &_initial_list)
+           _initial_list_done();
+        return;
+     }
 
-   ev = calloc(1, sizeof(Epulse_Event));
-   ev->index = info->index;
-   ev->name = strdup(info->name);
-   ev->volume = info->volume;
-   ev->mute = !!info->mute;
+   ev = _source_event_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(ev);
+
+   stale = _object_stale_take(ctx->sources, ev->index);
+   ev->changed = _object_cache_update(ctx->sources, ev, info->name, NULL,
+                                      NULL, NULL);
+   if (!stale)
+      ev->changed = EPULSE_CHANGE_ALL;
+   else if (!ev->changed)
+     {
+        _event_free_cb(NULL, ev);
+        return;
+     }
 
-   ecore_event_add(SOURCE_ADDED, ev, _event_free_cb, NULL);
+   ecore_event_add(stale ? SOURCE_CHANGED : SOURCE_ADDED, ev,
+                   _event_free_cb, NULL);
 }
 
 static void
 _source_changed_cb(pa_context *c EINA_UNUSED,
                        const pa_source_info *info, int eol,
-                       void *userdata EINA_UNUSED)
+                       void *userdata)
 {
    Epulse_Event *ev;
 
+   if (eol != 0)
+      _epulse_batch_refresh_done(userdata);
+
    if (eol < 0)
      {
         if (pa_context_errno(c) == PA_ERR_NOENTITY)
@@ -339,10 +731,17 @@ _source_changed_cb(pa_context *c EINA_UNUSED,
 
    DBG("source changed index: %d\n", info->index);
 
-   ev = calloc(1, sizeof(Epulse_Event));
-   ev->index = info->index;
-   ev->volume = info->volume;
-   ev->mute = !!info->mute;
+   ev = _source_event_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(ev);
+
+   ev->changed = _object_cache_update(ctx->sources, ev, info->name, NULL,
+                                      NULL, NULL);
+   if (!ev->changed ||
+       _epulse_batch_changed(EPULSE_METER_SOURCE, ev->index, ev->changed))
+     {
+        _event_free_cb(NULL, ev);
+        return;
+     }
 
    ecore_event_add(SOURCE_CHANGED, ev, _event_free_cb,
                    NULL);
@@ -355,6 +754,8 @@ _source_remove_cb(int index, void *data EINA_UNUSED)
 
    DBG("Removing source: %d", index);
 
+   eina_hash_del_by_key(ctx->sources, &index);
+
    ev = calloc(1, sizeof(Epulse_Event));
    ev->index = index;
 
@@ -363,7 +764,7 @@ _source_remove_cb(int index, void *data EINA_UNUSED)
 
 static void
 _sink_default_cb(pa_context *c EINA_UNUSED, const pa_sink_info *info, int eol,
-                 void *userdata EINA_UNUSED)
+                 void *userdata)
 {
    Epulse_Event_Sink *ev;
 
@@ -379,15 +780,17 @@ _sink_default_cb(pa_context *c EINA_UNUSED, const pa_sink_info *info, int eol,
    if (eol > 0)
       return;
 
+   /* server changes other than the default sink are not reported */
+   if (!userdata && info->index == ctx->default_sink)
+      return;
+
    DBG("sink index: %d\nsink name: %s", info->index,
        info->name);
 
-   ev = calloc(1, sizeof(Epulse_Event_Sink));
-   ev->base.index = info->index;
-   ev->base.name = strdup(info->description);
-   ev->base.volume = info->volume;
-   ev->base.mute = !!info->mute;
+   ev = _sink_event_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(ev);
 
+   ctx->default_sink = info->index;
    ecore_event_add(SINK_DEFAULT, ev, _event_sink_free_cb, NULL);
 }
 
@@ -397,6 +800,10 @@ _server_info_cb(pa_context *c, const pa_server_info *info,
 {
    pa_operation *o;
 
+   free(ctx->default_source);
+   ctx->default_source = info->default_source_name ?
+      strdup(info->default_source_name) : NULL;
+
    if (!(o = pa_context_get_sink_info_by_name(c, info->default_sink_name,
                                               _sink_default_cb, userdata)))
      {
@@ -406,6 +813,259 @@ _server_info_cb(pa_context *c, const pa_server_info *info,
    pa_operation_unref(o);
 }
 
+static Eina_List *
+_stale_list(Eina_Hash *hash)
+{
+   Eina_Iterator *it;
+   Eina_List *indexes = NULL;
+   Epulse_Object *obj;
+
+   it = eina_hash_iterator_data_new(hash);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (obj->stale)
+           indexes = eina_list_append(indexes, (void *)(intptr_t)obj->index);
+     }
+   eina_iterator_free(it);
+
+   return indexes;
+}
+
+static void _sink_remove_cb(int index, void *data);
+static void _sink_input_remove_cb(int index, void *data);
+static void _source_remove_cb(int index, void *data);
+
+/*
+ * Called once the sink, sink input and source lists requested on
+ * connection are complete: whatever came from the state cache and was
+ * not confirmed by the server is gone, and the fresh state is saved.
+ */
+static void
+_initial_list_done(void)
+{
+   Eina_List *indexes;
+   void *index;
+
+   if (!ctx->pending_lists || --ctx->pending_lists)
+      return;
+
+   indexes = _stale_list(ctx->sink_inputs);
+   EINA_LIST_FREE(indexes, index)
+      _sink_input_remove_cb((intptr_t)index, NULL);
+
+   indexes = _stale_list(ctx->sinks);
+   EINA_LIST_FREE(indexes, index)
+      _sink_remove_cb((intptr_t)index, NULL);
+
+   indexes = _stale_list(ctx->sources);
+   EINA_LIST_FREE(indexes, index)
+      _source_remove_cb((intptr_t)index, NULL);
+
+   ctx->synced = EINA_TRUE;
+   _epulse_meters_start();
+   /* calls already going on when we connected */
+   _epulse_ducking_update();
+   _epulse_cache_save(ctx->sinks, ctx->sink_inputs, ctx->sources,
+                      ctx->default_sink);
+}
+
+static Epulse_Event_Sink *
+_sink_event_from_object(const Epulse_Object *obj)
+{
+   Epulse_Event_Sink *ev;
+   const Eina_List *l;
+   Port *port;
+
+   ev = calloc(1, sizeof(Epulse_Event_Sink));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ev, NULL);
+
+   ev->base.index = obj->index;
+   ev->base.name = obj->name ? strdup(obj->name) : NULL;
+   ev->base.volume = obj->volume;
+   ev->base.mute = obj->mute;
+   ev->base.changed = EPULSE_CHANGE_ALL;
+   ev->base.cached = obj->stale;
+   EINA_LIST_FOREACH(obj->ports, l, port)
+      ev->ports = eina_list_append(ev->ports, _port_dup(port));
+
+   return ev;
+}
+
+static Epulse_Event_Sink_Input *
+_sink_input_event_from_object(const Epulse_Object *obj)
+{
+   Epulse_Event_Sink_Input *ev;
+
+   ev = calloc(1, sizeof(Epulse_Event_Sink_Input));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ev, NULL);
+
+   ev->base.index = obj->index;
+   ev->base.name = obj->name ? strdup(obj->name) : NULL;
+   ev->base.volume = obj->volume;
+   ev->base.mute = obj->mute;
+   ev->base.changed = EPULSE_CHANGE_ALL;
+   ev->base.cached = obj->stale;
+   ev->sink = obj->sink;
+   ev->corked = obj->corked;
+   ev->icon = obj->icon ? strdup(obj->icon) : NULL;
+   ev->app = obj->key ? strdup(obj->key) : NULL;
+   ev->binary = obj->binary ? strdup(obj->binary) : NULL;
+   ev->role = obj->role ? strdup(obj->role) : NULL;
+   ev->pid = obj->pid;
+
+   return ev;
+}
+
+static Epulse_Event *
+_source_event_from_object(const Epulse_Object *obj)
+{
+   Epulse_Event *ev;
+
+   ev = calloc(1, sizeof(Epulse_Event));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ev, NULL);
+
+   ev->index = obj->index;
+   ev->name = obj->name ? strdup(obj->name) : NULL;
+   ev->volume = obj->volume;
+   ev->mute = obj->mute;
+   ev->changed = EPULSE_CHANGE_ALL;
+   ev->cached = obj->stale;
+
+   return ev;
+}
+
+/*
+ * Emits ADDED events (and SINK_DEFAULT) for every known object, so a
+ * consumer created after the connection, or before it with the state
+ * cache loaded, can populate itself without a new server round trip.
+ */
+void
+epulse_replay(void)
+{
+   Eina_Iterator *it;
+   Epulse_Object *obj;
+   Epulse_Event_Sink *sink_ev;
+   Epulse_Event_Sink_Input *input_ev;
+   Epulse_Event *ev;
+
+   EINA_SAFETY_ON_NULL_RETURN(ctx);
+
+   it = eina_hash_iterator_data_new(ctx->sinks);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if ((sink_ev = _sink_event_from_object(obj)))
+           ecore_event_add(SINK_ADDED, sink_ev, _event_sink_free_cb, NULL);
+     }
+   eina_iterator_free(it);
+
+   obj = eina_hash_find(ctx->sinks, &ctx->default_sink);
+   if (obj && (sink_ev = _sink_event_from_object(obj)))
+      ecore_event_add(SINK_DEFAULT, sink_ev, _event_sink_free_cb, NULL);
+
+   it = eina_hash_iterator_data_new(ctx->sink_inputs);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (!(input_ev = _sink_input_event_from_object(obj)))
+           break;
+        ecore_event_add(SINK_INPUT_ADDED, input_ev,
+                        _event_sink_input_free_cb, NULL);
+     }
+   eina_iterator_free(it);
+
+   it = eina_hash_iterator_data_new(ctx->sources);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (!(ev = _source_event_from_object(obj)))
+           break;
+        ecore_event_add(SOURCE_ADDED, ev, _event_free_cb, NULL);
+     }
+   eina_iterator_free(it);
+
+   _epulse_card_replay();
+}
+
+/*
+ * Emits one CHANGED event for an object from its cached state, used to
+ * report the merged changes of a batch once it completed.
+ */
+void
+_epulse_object_changed_emit(Epulse_Meter_Type type, int index,
+                            unsigned int changed)
+{
+   Epulse_Event_Sink_Input *input_ev;
+   Epulse_Event_Sink *sink_ev;
+   Epulse_Object *obj;
+   Epulse_Event *ev;
+
+   obj = eina_hash_find(_epulse_objects_get(type), &index);
+   if (!obj)
+      return;
+
+   switch (type)
+     {
+      case EPULSE_METER_SINK:
+         if (!(sink_ev = _sink_event_from_object(obj)))
+            return;
+         sink_ev->base.changed = changed;
+         ecore_event_add(SINK_CHANGED, sink_ev, _event_sink_free_cb, NULL);
+         break;
+
+      case EPULSE_METER_SINK_INPUT:
+         if (!(input_ev = _sink_input_event_from_object(obj)))
+            return;
+         input_ev->base.changed = changed;
+         ecore_event_add(SINK_INPUT_CHANGED, input_ev,
+                         _event_sink_input_free_cb, NULL);
+         break;
+
+      case EPULSE_METER_SOURCE:
+         if (!(ev = _source_event_from_object(obj)))
+            return;
+         ev->changed = changed;
+         ecore_event_add(SOURCE_CHANGED, ev, _event_free_cb, NULL);
+         break;
+     }
+}
+
+/*
+ * Asks the server for the current state of an object. The reply goes
+ * through the usual change detection and _epulse_batch_refresh_done()
+ * is called with batch once it is complete.
+ */
+Eina_Bool
+_epulse_object_refresh(Epulse_Meter_Type type, int index, void *batch)
+{
+   pa_context *c = _epulse_pa_context_get();
+   pa_operation *o = NULL;
+
+   if (!c)
+      return EINA_FALSE;
+
+   switch (type)
+     {
+      case EPULSE_METER_SINK:
+         o = pa_context_get_sink_info_by_index(c, index, _sink_changed_cb,
+                                               batch);
+         break;
+
+      case EPULSE_METER_SINK_INPUT:
+         o = pa_context_get_sink_input_info(c, index, _sink_input_changed_cb,
+                                            batch);
+         break;
+
+      case EPULSE_METER_SOURCE:
+         o = pa_context_get_source_info_by_index(c, index,
+                                                 _source_changed_cb, batch);
+         break;
+     }
+
+   if (!o)
+      return EINA_FALSE;
+
+   pa_operation_unref(o);
+   return EINA_TRUE;
+}
+
 static void
 _subscribe_cb(pa_context *c, pa_subscription_event_type_t t,
               uint32_t index, void *data)
@@ -432,7 +1092,7 @@ _subscribe_cb(pa_context *c, pa_subscription_event_type_t t,
          {
             if (!(o = pa_context_get_sink_info_by_index(c, index,
                                                         _sink_changed_cb,
-                                                        data)))
+                                                        NULL)))
               {
                  ERR("pa_context_get_sink_info_by_index() failed");
                  return;
@@ -460,7 +1120,7 @@ _subscribe_cb(pa_context *c, pa_subscription_event_type_t t,
          {
             if (!(o = pa_context_get_sink_input_info(c, index,
                                                      _sink_input_changed_cb,
-                                                     data)))
+                                                     NULL)))
               {
                  ERR("pa_context_get_sink_input_info() failed");
                  return;
@@ -488,7 +1148,7 @@ _subscribe_cb(pa_context *c, pa_subscription_event_type_t t,
          {
             if (!(o = pa_context_get_source_info_by_index(c, index,
                                                           _source_changed_cb,
-                                                          data)))
+                                                          NULL)))
               {
                  ERR("pa_context_get_source_info() failed");
                  return;
@@ -497,6 +1157,20 @@ _subscribe_cb(pa_context *c, pa_subscription_event_type_t t,
          }
        break;
 
+    case PA_SUBSCRIPTION_EVENT_SERVER:
+       /* the default sink may have changed */
+       if (!(o = pa_context_get_server_info(c, _server_info_cb, NULL)))
+         {
+            ERR("pa_context_get_server_info() failed");
+            return;
+         }
+       pa_operation_unref(o);
+       break;
+
+    case PA_SUBSCRIPTION_EVENT_CARD:
+       _epulse_card_event(c, t, index);
+       break;
+
     default:
        WRN("Event not handled");
        break;
@@ -520,6 +1194,7 @@ _epulse_pa_state_cb(pa_context *context, void *data)
 
       case PA_CONTEXT_READY:
          {
+            ecore_event_add(CONNECTED, NULL, NULL, NULL);
             pa_context_set_subscribe_callback(context, _subscribe_cb, ctx);
             if (!(o = pa_context_subscribe(context, (pa_subscription_mask_t)
                                            (PA_SUBSCRIPTION_MASK_SINK|
@@ -536,29 +1211,34 @@ _epulse_pa_state_cb(pa_context *context, void *data)
               }
             pa_operation_unref(o);
 
-            if (!(o = pa_context_get_sink_info_list(context, _sink_cb, ctx)))
+            ctx->pending_lists = 3;
+            if (!(o = pa_context_get_sink_info_list(context, _sink_cb,
+                                                    &_initial_list)))
               {
                  ERR("pa_context_get_sink_info_list() failed");
-                 return;
+                 _initial_list_done();
               }
-            pa_operation_unref(o);
+            else
+               pa_operation_unref(o);
 
             if (!(o = pa_context_get_sink_input_info_list(context,
                                                           _sink_input_cb,
-                                                          ctx)))
+                                                          &_initial_list)))
               {
                  ERR("pa_context_get_sink_input_info_list() failed");
-                 return;
+                 _initial_list_done();
               }
-            pa_operation_unref(o);
+            else
+               pa_operation_unref(o);
 
             if (!(o = pa_context_get_source_info_list(context, _source_cb,
-                                                      ctx)))
+                                                      &_initial_list)))
               {
                  ERR("pa_context_get_source_info_list() failed");
-                 return;
+                 _initial_list_done();
               }
-            pa_operation_unref(o);
+            else
+               pa_operation_unref(o);
 
             if (!(o = pa_context_get_server_info(context, _server_info_cb,
                                                  ctx)))
@@ -567,11 +1247,23 @@ _epulse_pa_state_cb(pa_context *context, void *data)
                  return;
               }
             pa_operation_unref(o);
+
+            /* not cached, so not part of the initial lists */
+            _epulse_cards_list(context);
             break;
          }
 
       case PA_CONTEXT_FAILED:
          WRN("PA_CONTEXT_FAILED");
+         _epulse_batch_cancel();
+         ctx->synced = EINA_FALSE;
+         ctx->pending_lists = 0;
+         eina_hash_free_buckets(ctx->sinks);
+         eina_hash_free_buckets(ctx->sink_inputs);
+         eina_hash_free_buckets(ctx->sources);
+         free(ctx->default_source);
+         ctx->default_source = NULL;
+         _epulse_cards_clear();
          ecore_event_add(DISCONNECTED, NULL, NULL, NULL);
          _epulse_connect(data);
          return;
@@ -603,7 +1295,7 @@ _epulse_connect(void *data)
      }
 
    pa_context_set_state_callback(c->context, _epulse_pa_state_cb, c);
-   if (pa_context_connect(c->context, NULL, PA_CONTEXT_NOFLAGS, NULL) < 0)
+   if (pa_context_connect(c->context, NULL, c->flags, NULL) < 0)
      {
         WRN("Could not connect to pulse");
         goto err;
@@ -613,12 +1305,17 @@ _epulse_connect(void *data)
    return ECORE_CALLBACK_DONE;
 
  err:
+   if (c->context)
+     {
+        pa_context_unref(c->context);
+        c->context = NULL;
+     }
    pa_proplist_free(proplist);
    return ECORE_CALLBACK_RENEW;
 }
 
-int
-epulse_init(void)
+static int
+_epulse_init(Eina_Bool connect)
 {
    if (_init_count > 0)
       goto end;
@@ -630,6 +1327,7 @@ epulse_init(void)
         return 0;
      }
 
+   CONNECTED = ecore_event_type_new();
    DISCONNECTED = ecore_event_type_new();
    SINK_ADDED = ecore_event_type_new();
    SINK_CHANGED = ecore_event_type_new();
@@ -644,8 +1342,23 @@ epulse_init(void)
    SOURCE_INPUT_ADDED = ecore_event_type_new();
    SOURCE_INPUT_REMOVED = ecore_event_type_new();
 
+   ctx->sinks = eina_hash_int32_new(_object_free_cb);
+   ctx->sink_inputs = eina_hash_int32_new(_object_free_cb);
+   ctx->sources = eina_hash_int32_new(_object_free_cb);
+   _epulse_card_init();
+   _epulse_scene_init();
+
+   ctx->default_sink = -1;
+   if (_epulse_cache_load(ctx->sinks, ctx->sink_inputs, ctx->sources,
+                          &ctx->default_sink))
+      epulse_replay();
+
    ctx->api = functable;
    ctx->api.userdata = ctx;
+   ctx->flags = PA_CONTEXT_NOFLAGS;
+
+   if (!connect)
+      goto end;
 
    /* The reason of compares with EINA_TRUE is because ECORE_CALLBACK_RENEW 
       is EINA_TRUE. The function _epulse_connect returns ECORE_CALLBACK_RENEW
@@ -659,10 +1372,58 @@ epulse_init(void)
    return _init_count;
 
  err:
+   _epulse_scene_shutdown();
+   _epulse_card_shutdown();
+   eina_hash_free(ctx->sinks);
+   eina_hash_free(ctx->sink_inputs);
+   eina_hash_free(ctx->sources);
    free(ctx);
+   ctx = NULL;
    return 0;
 }
 
+int
+epulse_init(void)
+{
+   return _epulse_init(EINA_TRUE);
+}
+
+/*
+ * Sets up the library and its events without talking to the server,
+ * for hosts that must not block while starting (like the E module).
+ * The connection is made later with epulse_connect().
+ */
+int
+epulse_init_deferred(void)
+{
+   return _epulse_init(EINA_FALSE);
+}
+
+/*
+ * Connects without autospawning a daemon, which could fork and block
+ * the caller, and keeps waiting instead of failing when no server is
+ * running yet. CONNECTED is emitted once the context is ready.
+ */
+Eina_Bool
+epulse_connect(void)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ctx, EINA_FALSE);
+
+   if (ctx->context)
+      return EINA_TRUE;
+
+   ctx->flags = (pa_context_flags_t)
+      (PA_CONTEXT_NOAUTOSPAWN | PA_CONTEXT_NOFAIL);
+
+   return _epulse_connect(ctx) == ECORE_CALLBACK_DONE;
+}
+
+Eina_Bool
+epulse_connected_get(void)
+{
+   return !!_epulse_pa_context_get();
+}
+
 void
 epulse_shutdown(void)
 {
@@ -673,23 +1434,139 @@ epulse_shutdown(void)
    if (_init_count > 0)
       return;
 
-   pa_context_unref(ctx->context);
+   _epulse_batch_cancel();
+   _epulse_rules_shutdown();
+   _epulse_fade_shutdown();
+   _epulse_meter_shutdown();
+   if (ctx->synced)
+      _epulse_cache_save(ctx->sinks, ctx->sink_inputs, ctx->sources,
+                         ctx->default_sink);
+
+   if (ctx->context)
+      pa_context_unref(ctx->context);
+   _epulse_scene_shutdown();
+   _epulse_card_shutdown();
+   eina_hash_free(ctx->sinks);
+   eina_hash_free(ctx->sink_inputs);
+   eina_hash_free(ctx->sources);
+   free(ctx->default_source);
    free(ctx);
    ctx = NULL;
 }
 
+pa_context *
+_epulse_pa_context_get(void)
+{
+   if (!ctx || !ctx->context ||
+       pa_context_get_state(ctx->context) != PA_CONTEXT_READY)
+      return NULL;
+
+   return ctx->context;
+}
+
+int
+_epulse_monitor_source_get(Epulse_Meter_Type type, int index)
+{
+   Epulse_Object *obj;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ctx, -1);
+
+   switch (type)
+     {
+      case EPULSE_METER_SOURCE:
+         return index;
+
+      case EPULSE_METER_SINK_INPUT:
+         obj = eina_hash_find(ctx->sink_inputs, &index);
+         if (!obj)
+            return -1;
+         index = obj->sink;
+         /* fall through */
+      case EPULSE_METER_SINK:
+         obj = eina_hash_find(ctx->sinks, &index);
+         return obj ? obj->monitor : -1;
+     }
+
+   return -1;
+}
+
+Eina_Hash *
+_epulse_objects_get(Epulse_Meter_Type type)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ctx, NULL);
+
+   switch (type)
+     {
+      case EPULSE_METER_SINK:
+         return ctx->sinks;
+      case EPULSE_METER_SOURCE:
+         return ctx->sources;
+      case EPULSE_METER_SINK_INPUT:
+         return ctx->sink_inputs;
+     }
+
+   return NULL;
+}
+
+int
+_epulse_default_sink_get(void)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ctx, -1);
+
+   return ctx->default_sink;
+}
+
+Eina_Bool
+_epulse_synced_get(void)
+{
+   return ctx && ctx->synced;
+}
+
+Eina_Bool
+_epulse_policies_get(void)
+{
+   return ctx && ctx->policies;
+}
+
+void
+_epulse_policies_set(Eina_Bool policies)
+{
+   EINA_SAFETY_ON_NULL_RETURN(ctx);
+
+   ctx->policies = policies;
+   /* streams already there may need ducking, or letting go */
+   if (ctx->synced)
+      _epulse_ducking_update();
+}
+
+const char *
+_epulse_default_source_get(void)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ctx, NULL);
+
+   return ctx->default_source;
+}
+
 Eina_Bool
 epulse_source_volume_set(int index, pa_cvolume volume)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sources, index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SOURCE, index);
    if (!(o = pa_context_set_source_volume_by_index(ctx->context,
-                                                   index, &volume, NULL, NULL)))
+                                                   index, &volume,
+                                                   _epulse_batch_op_cb, op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_set_source_volume_by_index() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
@@ -698,14 +1575,22 @@ Eina_Bool
 epulse_source_mute_set(int index, Eina_Bool mute)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sources, index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SOURCE, index);
    if (!(o = pa_context_set_source_mute_by_index(ctx->context,
-                                                 index, mute, NULL, NULL)))
+                                                 index, mute,
+                                                 _epulse_batch_op_cb, op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_set_source_mute() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
@@ -714,14 +1599,22 @@ Eina_Bool
 epulse_sink_volume_set(int index, pa_cvolume volume)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sinks, index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SINK, index);
    if (!(o = pa_context_set_sink_volume_by_index(ctx->context,
-                                                 index, &volume, NULL, NULL)))
+                                                 index, &volume,
+                                                 _epulse_batch_op_cb, op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_set_sink_volume_by_index() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
@@ -730,14 +1623,22 @@ Eina_Bool
 epulse_sink_mute_set(int index, Eina_Bool mute)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sinks, index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SINK, index);
    if (!(o = pa_context_set_sink_mute_by_index(ctx->context,
-                                               index, mute, NULL, NULL)))
+                                               index, mute,
+                                               _epulse_batch_op_cb, op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_set_sink_mute() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
@@ -746,14 +1647,22 @@ Eina_Bool
 epulse_sink_input_volume_set(int index, pa_cvolume volume)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sink_inputs, index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SINK_INPUT, index);
    if (!(o = pa_context_set_sink_input_volume(ctx->context,
-                                              index, &volume, NULL, NULL)))
+                                              index, &volume,
+                                              _epulse_batch_op_cb, op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_set_sink_input_volume_by_index() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
@@ -762,31 +1671,58 @@ Eina_Bool
 epulse_sink_input_mute_set(int index, Eina_Bool mute)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sink_inputs, index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SINK_INPUT, index);
    if (!(o = pa_context_set_sink_input_mute(ctx->context,
-                                            index, mute, NULL, NULL)))
+                                            index, mute,
+                                            _epulse_batch_op_cb, op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_set_sink_input_mute() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
 
+/* a move the user asked for, the application rules learn it */
 Eina_Bool
 epulse_sink_input_move(int index, int sink_index)
+{
+   if (!_epulse_sink_input_move(index, sink_index))
+      return EINA_FALSE;
+
+   _epulse_rules_user_move(index);
+   return EINA_TRUE;
+}
+
+Eina_Bool
+_epulse_sink_input_move(int index, int sink_index)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sink_inputs, index) ||
+       _object_stale_get(ctx->sinks, sink_index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SINK_INPUT, index);
    if (!(o = pa_context_move_sink_input_by_index(ctx->context,
-                                                 index, sink_index, NULL,
-                                                 NULL)))
+                                                 index, sink_index,
+                                                 _epulse_batch_op_cb, op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_move_sink_input_by_index() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
@@ -795,15 +1731,150 @@ Eina_Bool
 epulse_sink_port_set(int index, const char *port)
 {
    pa_operation* o;
+   void *op;
    EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
 
+   if (_object_stale_get(ctx->sinks, index))
+      return EINA_FALSE;
+
+   op = _epulse_batch_op_add(EPULSE_METER_SINK, index);
    if (!(o = pa_context_set_sink_port_by_index(ctx->context,
-                                               index, port, NULL,
-                                               NULL)))
+                                               index, port, _epulse_batch_op_cb,
+                                               op)))
      {
+        _epulse_batch_op_done(op, EINA_FALSE);
         ERR("pa_context_set_source_port_by_index() failed");
         return EINA_FALSE;
      }
+   pa_operation_unref(o);
+
+   return EINA_TRUE;
+}
+
+static void
+_sink_default_set_cb(pa_context *c, const pa_sink_info *info, int eol,
+                     void *userdata)
+{
+   pa_operation *o;
+
+   if (eol < 0)
+     {
+        _epulse_batch_op_done(userdata, EINA_FALSE);
+        ERR("Could not find the sink to make default");
+        return;
+     }
+
+   if (eol > 0)
+      return;
+
+   if (!(o = pa_context_set_default_sink(c, info->name, _epulse_batch_op_cb,
+                                         userdata)))
+     {
+        _epulse_batch_op_done(userdata, EINA_FALSE);
+        ERR("pa_context_set_default_sink() failed");
+        return;
+     }
+   pa_operation_unref(o);
+}
+
+/*
+ * The server takes sink names. The one of a known sink is used right
+ * away, otherwise it is looked up first. The change comes back as a
+ * SINK_DEFAULT event.
+ */
+Eina_Bool
+epulse_sink_default_set(int index)
+{
+   const Epulse_Object *sink;
+   pa_operation* o;
+   void *op;
+   EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
+
+   /* not an object change, nothing to hold back */
+   op = _epulse_batch_op_add(EPULSE_METER_SINK, -1);
+   sink = eina_hash_find(ctx->sinks, &index);
+   if (sink && sink->key && !sink->stale)
+      o = pa_context_set_default_sink(ctx->context, sink->key,
+                                      _epulse_batch_op_cb, op);
+   else
+      o = pa_context_get_sink_info_by_index(ctx->context, index,
+                                            _sink_default_set_cb, op);
+   if (!o)
+     {
+        _epulse_batch_op_done(op, EINA_FALSE);
+        ERR("Could not make sink %d the default", index);
+        return EINA_FALSE;
+     }
+   pa_operation_unref(o);
 
    return EINA_TRUE;
 }
+
+/*
+ * Like epulse_sink_default_set() for sources. Only known sources can be
+ * made the default, the server takes their name.
+ */
+Eina_Bool
+epulse_source_default_set(int index)
+{
+   const Epulse_Object *source;
+   pa_operation* o;
+   void *op;
+   EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
+
+   source = eina_hash_find(ctx->sources, &index);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(source && source->key && !source->stale,
+                                   EINA_FALSE);
+
+   /* not an object change, nothing to hold back */
+   op = _epulse_batch_op_add(EPULSE_METER_SOURCE, -1);
+   if (!(o = pa_context_set_default_source(ctx->context, source->key,
+                                           _epulse_batch_op_cb, op)))
+     {
+        _epulse_batch_op_done(op, EINA_FALSE);
+        ERR("Could not make source %d the default", index);
+        return EINA_FALSE;
+     }
+   pa_operation_unref(o);
+
+   /* there is no SOURCE_DEFAULT event, remember it right away */
+   free(ctx->default_source);
+   ctx->default_source = strdup(source->key);
+
+   return EINA_TRUE;
+}
+
+/*
+ * Makes the sink the default and moves every stream to it, all in one
+ * batch: cb is called once, after the last move completed.
+ */
+Eina_Bool
+epulse_output_switch(int index, Epulse_Batch_Cb cb, const void *data)
+{
+   Eina_Iterator *it;
+   Epulse_Object *obj;
+   unsigned int moved = 0;
+
+   EINA_SAFETY_ON_FALSE_RETURN_VAL((ctx && ctx->context), EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(eina_hash_find(ctx->sinks, &index),
+                                  EINA_FALSE);
+
+   if (!epulse_batch_begin())
+      return EINA_FALSE;
+
+   epulse_sink_default_set(index);
+
+   it = eina_hash_iterator_data_new(ctx->sink_inputs);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (obj->stale || obj->sink == index)
+           continue;
+
+        _epulse_sink_input_move(obj->index, index);
+        moved++;
+     }
+   eina_iterator_free(it);
+
+   DBG("Switching output to sink %d, moving %u streams", index, moved);
+   return epulse_batch_commit(cb, data);
+}
@@ -16,6 +16,24 @@ struct _Port {
    char *description;
 };
 
+/* Fields that differ from the previous event for the same object */
+typedef enum _Epulse_Change
+{
+   EPULSE_CHANGE_NONE           = 0,
+   EPULSE_CHANGE_VOLUME         = 1 << 0,
+   EPULSE_CHANGE_MUTE           = 1 << 1,
+   EPULSE_CHANGE_PORTS          = 1 << 2,
+   EPULSE_CHANGE_ACTIVE_PORT    = 1 << 3,
+   EPULSE_CHANGE_NAME           = 1 << 4,
+   EPULSE_CHANGE_ICON           = 1 << 5,
+   EPULSE_CHANGE_SINK           = 1 << 6,
+   EPULSE_CHANGE_CORKED         = 1 << 7,
+   EPULSE_CHANGE_APP            = 1 << 8,
+   EPULSE_CHANGE_PROFILES       = 1 << 9,
+   EPULSE_CHANGE_ACTIVE_PROFILE = 1 << 10,
+   EPULSE_CHANGE_ALL            = 0x7ff
+} Epulse_Change;
+
 typedef struct _Epulse_Event Epulse_Event;
 struct _Epulse_Event
 {
@@ -23,6 +41,8 @@ struct _Epulse_Event
    char *name;
    pa_cvolume volume;
    Eina_Bool mute;
+   unsigned int changed; /* Epulse_Change mask, all bits set on ADDED */
+   Eina_Bool cached; /* from the last session, not confirmed by the server */
 };
 
 typedef struct _Epulse_Event_Sink Epulse_Event_Sink;
@@ -36,8 +56,71 @@ struct _Epulse_Event_Sink_Input {
    Epulse_Event base;
    int sink;
    char *icon;
+   Eina_Bool corked;
+   /* who plays it, from the stream properties */
+   char *app;    /* application name, the stream name when not given */
+   char *binary; /* process binary, NULL when unknown */
+   char *role;   /* media role, NULL when unknown */
+   int pid;      /* -1 when unknown */
 };
 
+/* Names and descriptions are stringshares */
+typedef struct _Epulse_Card_Profile Epulse_Card_Profile;
+struct _Epulse_Card_Profile {
+   const char *name;
+   const char *description;
+   unsigned int priority;
+   Eina_Bool available;
+};
+
+typedef struct _Epulse_Event_Card Epulse_Event_Card;
+struct _Epulse_Event_Card {
+   int index;
+   char *name;
+   char *icon;
+   /* highest priority first, owned by the event */
+   Epulse_Card_Profile *profiles;
+   unsigned int profile_count;
+   int active; /* position in profiles, -1 when none */
+   unsigned int changed; /* Epulse_Change mask, all bits set on ADDED */
+};
+
+typedef enum _Epulse_Meter_Type
+{
+   EPULSE_METER_SINK,
+   EPULSE_METER_SOURCE,
+   EPULSE_METER_SINK_INPUT
+} Epulse_Meter_Type;
+
+#define EPULSE_METER_RATE 20 /* level updates per second */
+
+typedef struct _Epulse_Meter Epulse_Meter;
+/* peak is the highest absolute sample since the last call, 1.0 being 0 dB */
+typedef void (*Epulse_Meter_Cb)(void *data, float peak);
+
+#define EPULSE_SPECTRUM_RATE 48000
+#define EPULSE_SPECTRUM_DECIMATION 2
+#define EPULSE_SPECTRUM_FLOOR_DB -80.0f
+
+/* progress of a fade to its volume, t going from 0 to 1 */
+typedef enum _Epulse_Fade_Curve
+{
+   EPULSE_FADE_LINEAR,
+   EPULSE_FADE_EASE_IN,  /* t^2, slow start */
+   EPULSE_FADE_EASE_OUT, /* slow end */
+   EPULSE_FADE_SMOOTH    /* slow start and end */
+} Epulse_Fade_Curve;
+
+#define EPULSE_DUCKING_DURATION 300 /* ms */
+
+/* status[i] is the result of the i-th operation issued in the batch */
+typedef void (*Epulse_Batch_Cb)(void *data, const Eina_Bool *status,
+                                unsigned int count);
+
+typedef struct _Epulse_Fft Epulse_Fft;
+typedef struct _Epulse_Spectrum Epulse_Spectrum;
+
+EAPI extern int CONNECTED;
 EAPI extern int DISCONNECTED;
 EAPI extern int SINK_ADDED;
 EAPI extern int SINK_CHANGED;
@@ -51,8 +134,14 @@ EAPI extern int SOURCE_CHANGED;
 EAPI extern int SOURCE_REMOVED;
 EAPI extern int SOURCE_INPUT_ADDED;
 EAPI extern int SOURCE_INPUT_REMOVED;
+EAPI extern int CARD_ADDED;
+EAPI extern int CARD_CHANGED;
+EAPI extern int CARD_REMOVED;
 
 EAPI int epulse_init(void);
+EAPI int epulse_init_deferred(void);
+EAPI Eina_Bool epulse_connect(void);
+EAPI Eina_Bool epulse_connected_get(void);
 EAPI Eina_Bool epulse_source_volume_set(int index, pa_cvolume volume);
 EAPI Eina_Bool epulse_source_mute_set(int index, Eina_Bool mute);
 EAPI Eina_Bool epulse_sink_volume_set(int index, pa_cvolume volume);
@@ -61,4 +150,52 @@ EAPI Eina_Bool epulse_sink_port_set(int index, const char *port);
 EAPI Eina_Bool epulse_sink_input_volume_set(int index, pa_cvolume volume);
 EAPI Eina_Bool epulse_sink_input_mute_set(int index, Eina_Bool mute);
 EAPI Eina_Bool epulse_sink_input_move(int index, int sink_index);
+EAPI Eina_Bool epulse_sink_default_set(int index);
+EAPI Eina_Bool epulse_source_default_set(int index);
+EAPI Eina_Bool epulse_card_profile_set(int index, const char *profile);
+EAPI Eina_Bool epulse_output_switch(int index, Epulse_Batch_Cb cb,
+                                    const void *data);
 EAPI void epulse_shutdown(void);
+EAPI void epulse_replay(void);
+EAPI Eina_Bool epulse_batch_begin(void);
+EAPI Eina_Bool epulse_batch_commit(Epulse_Batch_Cb cb, const void *data);
+EAPI Eina_Bool epulse_scene_save(const char *name);
+EAPI Eina_Bool epulse_scene_apply(const char *name, Epulse_Batch_Cb cb,
+                                  const void *data);
+EAPI Eina_Bool epulse_scene_del(const char *name);
+EAPI Eina_List *epulse_scene_list(void);
+EAPI Eina_Bool epulse_fade_start(Epulse_Meter_Type type, int index,
+                                 pa_volume_t target, unsigned int ms,
+                                 Epulse_Fade_Curve curve);
+EAPI void epulse_fade_cancel(Epulse_Meter_Type type, int index);
+EAPI void epulse_ducking_set(unsigned int percent, unsigned int ms);
+
+/* Scripting interface for epulse-ctl, free with epulse_ipc_server_del() */
+#define EPULSE_CTL_NAME "epulse-ctl"
+
+EAPI Epulse_Ipc *epulse_ctl_server_add(void);
+
+EAPI void epulse_meter_rate_set(unsigned int rate);
+EAPI unsigned int epulse_meter_rate_get(void);
+EAPI Epulse_Meter *epulse_meter_add(Epulse_Meter_Type type, int index,
+                                    Epulse_Meter_Cb cb, const void *data);
+EAPI void epulse_meter_del(Epulse_Meter *meter);
+EAPI Evas_Object *epulse_meter_widget_add(Evas_Object *parent,
+                                          Epulse_Meter_Type type, int index);
+EAPI float epulse_peak_compute(const float *samples, size_t count);
+
+EAPI Epulse_Fft *epulse_fft_new(unsigned int size);
+EAPI void epulse_fft_free(Epulse_Fft *fft);
+EAPI unsigned int epulse_fft_size_get(const Epulse_Fft *fft);
+EAPI void epulse_fft_power(Epulse_Fft *fft, const float *samples,
+                           float *power);
+EAPI void epulse_fft_bands(const Epulse_Fft *fft, const float *power,
+                           float rate, float *bands, unsigned int nbands);
+
+EAPI Epulse_Spectrum *epulse_spectrum_add(Epulse_Meter_Type type, int index,
+                                          unsigned int fft_size);
+EAPI void epulse_spectrum_del(Epulse_Spectrum *spectrum);
+EAPI void epulse_spectrum_pause_set(Epulse_Spectrum *spectrum,
+                                    Eina_Bool pause);
+EAPI Eina_Bool epulse_spectrum_bands_get(Epulse_Spectrum *spectrum,
+                                         float *bands, unsigned int nbands);
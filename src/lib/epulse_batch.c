@@ -0,0 +1,292 @@
+#include "epulse_private.h"
+
+/*
+ * Groups setter calls so a multi-object change is reported once.
+ *
+ * Between epulse_batch_begin() and epulse_batch_commit() every setter is
+ * still sent right away, pipelined on the connection, but its result is
+ * recorded in the batch. CHANGED events for the objects it touches are
+ * held back. Once every operation has completed, those objects are read
+ * back in one go and a single CHANGED carrying the merged change mask is
+ * emitted for each, then the completion callback gets the status of
+ * every operation in the order they were issued.
+ */
+
+typedef struct _Batch_Object Batch_Object;
+struct _Batch_Object
+{
+   Epulse_Meter_Type type;
+   int index;
+   unsigned int changed;
+};
+
+typedef struct _Epulse_Batch Epulse_Batch;
+struct _Epulse_Batch
+{
+   Eina_Inarray *status;  /* Eina_Bool per operation */
+   Eina_Inarray *objects; /* Batch_Object */
+   Eina_List *ops;
+   /* operations, then read backs, still running */
+   unsigned int pending;
+   Eina_Bool committed;
+   Eina_Bool refreshing;
+
+   Epulse_Batch_Cb cb;
+   const void *data;
+   double start;
+};
+
+typedef struct _Batch_Op Batch_Op;
+struct _Batch_Op
+{
+   Epulse_Batch *batch;
+   unsigned int n;
+   Eina_Bool done;
+};
+
+/* the batch setters currently report to */
+static Epulse_Batch *_open = NULL;
+/* committed batches waiting for their operations */
+static Eina_List *_running = NULL;
+
+static Batch_Object *
+_batch_object_find(Epulse_Batch *batch, Epulse_Meter_Type type, int index)
+{
+   Batch_Object *obj;
+
+   EINA_INARRAY_FOREACH(batch->objects, obj)
+      if (obj->type == type && obj->index == index)
+         return obj;
+
+   return NULL;
+}
+
+static void
+_batch_free(Epulse_Batch *batch)
+{
+   Batch_Op *op;
+
+   EINA_LIST_FREE(batch->ops, op)
+      free(op);
+   if (batch->status)
+      eina_inarray_free(batch->status);
+   if (batch->objects)
+      eina_inarray_free(batch->objects);
+   free(batch);
+}
+
+static void
+_batch_finish(Epulse_Batch *batch)
+{
+   unsigned int count = eina_inarray_count(batch->status);
+   Batch_Object *obj;
+
+   _running = eina_list_remove(_running, batch);
+
+   EINA_INARRAY_FOREACH(batch->objects, obj)
+      if (obj->changed)
+         _epulse_object_changed_emit(obj->type, obj->index, obj->changed);
+
+   DBG("Batch of %u operations done in %.2f ms", count,
+       (ecore_time_get() - batch->start) * 1000.0);
+
+   if (batch->cb)
+      batch->cb((void *)batch->data,
+                count ? eina_inarray_nth(batch->status, 0) : NULL, count);
+   _batch_free(batch);
+}
+
+static void
+_batch_check(Epulse_Batch *batch)
+{
+   Batch_Object *obj;
+
+   if (!batch->committed || batch->pending)
+      return;
+
+   if (!batch->refreshing)
+     {
+        /* the echoes may still be on their way, ask for the final state */
+        batch->refreshing = EINA_TRUE;
+        EINA_INARRAY_FOREACH(batch->objects, obj)
+           if (_epulse_object_refresh(obj->type, obj->index, batch))
+              batch->pending++;
+
+        if (batch->pending)
+           return;
+     }
+
+   _batch_finish(batch);
+}
+
+void *
+_epulse_batch_op_add(Epulse_Meter_Type type, int index)
+{
+   Batch_Object obj = { type, index, EPULSE_CHANGE_NONE };
+   Eina_Bool status = EINA_FALSE;
+   Batch_Op *op;
+   int n;
+
+   if (!_open)
+      return NULL;
+
+   n = eina_inarray_push(_open->status, &status);
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(n >= 0, NULL);
+
+   op = calloc(1, sizeof(Batch_Op));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(op, NULL);
+
+   op->batch = _open;
+   op->n = n;
+   _open->ops = eina_list_append(_open->ops, op);
+   _open->pending++;
+
+   /* a negative index is an operation without an object to watch */
+   if (index >= 0 && !_batch_object_find(_open, type, index))
+      eina_inarray_push(_open->objects, &obj);
+
+   return op;
+}
+
+void
+_epulse_batch_op_done(void *data, Eina_Bool success)
+{
+   Batch_Op *op = data;
+   Eina_Bool *status;
+
+   if (!op || op->done)
+      return;
+
+   op->done = EINA_TRUE;
+   status = eina_inarray_nth(op->batch->status, op->n);
+   if (status)
+      *status = success;
+
+   op->batch->pending--;
+   _batch_check(op->batch);
+}
+
+void
+_epulse_batch_op_cb(pa_context *c EINA_UNUSED, int success, void *userdata)
+{
+   _epulse_batch_op_done(userdata, !!success);
+}
+
+/*
+ * Called for every CHANGED about to be emitted. Returns EINA_TRUE when
+ * the object belongs to a batch, which then reports the change itself.
+ */
+Eina_Bool
+_epulse_batch_changed(Epulse_Meter_Type type, int index, unsigned int changed)
+{
+   Epulse_Batch *batch;
+   Batch_Object *obj;
+   Eina_List *l;
+
+   if (_open && (obj = _batch_object_find(_open, type, index)))
+     {
+        obj->changed |= changed;
+        return EINA_TRUE;
+     }
+
+   EINA_LIST_FOREACH(_running, l, batch)
+     {
+        if ((obj = _batch_object_find(batch, type, index)))
+          {
+             obj->changed |= changed;
+             return EINA_TRUE;
+          }
+     }
+
+   return EINA_FALSE;
+}
+
+void
+_epulse_batch_refresh_done(void *data)
+{
+   Epulse_Batch *batch = data;
+
+   if (!batch)
+      return;
+
+   batch->pending--;
+   _batch_check(batch);
+}
+
+/*
+ * The operations of a failed context are dropped without calling back,
+ * so every batch ends here with whatever did not complete as failed.
+ */
+void
+_epulse_batch_cancel(void)
+{
+   Epulse_Batch *batch;
+   unsigned int count;
+
+   if (_open)
+     {
+        _batch_free(_open);
+        _open = NULL;
+     }
+
+   EINA_LIST_FREE(_running, batch)
+     {
+        count = eina_inarray_count(batch->status);
+        WRN("Batch of %u operations interrupted", count);
+        if (batch->cb)
+           batch->cb((void *)batch->data,
+                     count ? eina_inarray_nth(batch->status, 0) : NULL,
+                     count);
+        _batch_free(batch);
+     }
+}
+
+/*
+ * Starts recording setter calls. Fails when not connected or when a
+ * batch is already open, batches do not nest.
+ */
+Eina_Bool
+epulse_batch_begin(void)
+{
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(!_open, EINA_FALSE);
+
+   if (!_epulse_pa_context_get())
+      return EINA_FALSE;
+
+   _open = calloc(1, sizeof(Epulse_Batch));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(_open, EINA_FALSE);
+
+   _open->status = eina_inarray_new(sizeof(Eina_Bool), 8);
+   _open->objects = eina_inarray_new(sizeof(Batch_Object), 8);
+   if (!_open->status || !_open->objects)
+     {
+        _batch_free(_open);
+        _open = NULL;
+        return EINA_FALSE;
+     }
+
+   _open->start = ecore_time_get();
+   return EINA_TRUE;
+}
+
+/*
+ * Closes the open batch. cb is called once every operation completed
+ * and the merged CHANGED events were queued, right away for an empty
+ * batch, and also if the connection is lost on the way.
+ */
+Eina_Bool
+epulse_batch_commit(Epulse_Batch_Cb cb, const void *data)
+{
+   Epulse_Batch *batch = _open;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(batch, EINA_FALSE);
+
+   _open = NULL;
+   batch->cb = cb;
+   batch->data = data;
+   batch->committed = EINA_TRUE;
+   _running = eina_list_append(_running, batch);
+   _batch_check(batch);
+
+   return EINA_TRUE;
+}
@@ -0,0 +1,401 @@
+#include "epulse_private.h"
+
+#include <Ecore_File.h>
+
+/*
+ * On-disk copy of the object model so a new process can show the last
+ * known sinks, sources and streams before the server answers.
+ *
+ * Layout, all fields in host byte order and 4-byte aligned so the file
+ * can be used directly from a read-only mapping:
+ *
+ *   Cache_Header
+ *   Cache_Object[n_objects]
+ *   Cache_Port[n_ports]
+ *   uint32_t volumes[n_volumes]
+ *   char strings[strings_size]   (NUL terminated, referenced by offset)
+ */
+
+#define CACHE_MAGIC "EPSC"
+#define CACHE_VERSION 2
+#define CACHE_FILE "state.cache"
+#define CACHE_NO_STRING 0xffffffff
+
+enum {
+   CACHE_SINK,
+   CACHE_SINK_INPUT,
+   CACHE_SOURCE
+};
+
+typedef struct _Cache_Header Cache_Header;
+struct _Cache_Header {
+   char magic[4];
+   uint32_t version;
+   int32_t default_sink;
+   uint32_t n_objects;
+   uint32_t n_ports;
+   uint32_t n_volumes;
+   uint32_t strings_size;
+};
+
+typedef struct _Cache_Object Cache_Object;
+struct _Cache_Object {
+   uint8_t type;
+   uint8_t mute;
+   uint8_t corked;
+   uint8_t channels;
+   int32_t index;
+   int32_t sink;
+   int32_t monitor;
+   uint32_t name;
+   uint32_t key;
+   uint32_t icon;
+   uint32_t volumes;
+   uint32_t ports;
+   uint32_t n_ports;
+};
+
+typedef struct _Cache_Port Cache_Port;
+struct _Cache_Port {
+   uint32_t name;
+   uint32_t description;
+   int32_t priority;
+   uint8_t active;
+   uint8_t available;
+   uint8_t padding[2];
+};
+
+typedef struct _Cache_Writer Cache_Writer;
+struct _Cache_Writer {
+   Eina_Binbuf *objects;
+   Eina_Binbuf *ports;
+   Eina_Binbuf *volumes;
+   Eina_Binbuf *strings;
+   uint32_t n_objects;
+   uint32_t n_ports;
+   uint32_t n_volumes;
+};
+
+static Eina_Bool
+_cache_path_get(char *buf, size_t size, Eina_Bool mkdir)
+{
+   const char *base = getenv("XDG_CACHE_HOME");
+   char dir[PATH_MAX];
+
+   if (base && base[0])
+      snprintf(dir, sizeof(dir), "%s/epulse", base);
+   else if (getenv("HOME"))
+      snprintf(dir, sizeof(dir), "%s/.cache/epulse", getenv("HOME"));
+   else
+      return EINA_FALSE;
+
+   if (mkdir && !ecore_file_is_dir(dir) && !ecore_file_mkpath(dir))
+     {
+        WRN("Could not create the cache directory %s", dir);
+        return EINA_FALSE;
+     }
+
+   snprintf(buf, size, "%s/" CACHE_FILE, dir);
+   return EINA_TRUE;
+}
+
+static uint32_t
+_writer_string(Cache_Writer *w, const char *str)
+{
+   uint32_t off;
+
+   if (!str)
+      return CACHE_NO_STRING;
+
+   off = eina_binbuf_length_get(w->strings);
+   eina_binbuf_append_length(w->strings, (const unsigned char *)str,
+                             strlen(str) + 1);
+   return off;
+}
+
+static void
+_writer_object(Cache_Writer *w, const Epulse_Object *obj, uint8_t type)
+{
+   Cache_Object co;
+   Cache_Port cp;
+   const Eina_List *l;
+   Port *port;
+   uint8_t i;
+
+   memset(&co, 0, sizeof(co));
+   co.type = type;
+   co.mute = obj->mute;
+   co.corked = obj->corked;
+   co.channels = obj->volume.channels;
+   co.index = obj->index;
+   co.sink = obj->sink;
+   co.monitor = obj->monitor;
+   co.name = _writer_string(w, obj->name);
+   co.key = _writer_string(w, obj->key);
+   co.icon = _writer_string(w, obj->icon);
+
+   co.volumes = w->n_volumes;
+   for (i = 0; i < obj->volume.channels; i++)
+     {
+        uint32_t v = obj->volume.values[i];
+
+        eina_binbuf_append_length(w->volumes, (unsigned char *)&v, sizeof(v));
+        w->n_volumes++;
+     }
+
+   co.ports = w->n_ports;
+   EINA_LIST_FOREACH(obj->ports, l, port)
+     {
+        memset(&cp, 0, sizeof(cp));
+        cp.name = _writer_string(w, port->name);
+        cp.description = _writer_string(w, port->description);
+        cp.priority = port->priority;
+        cp.active = port->active;
+        cp.available = port->available;
+        eina_binbuf_append_length(w->ports, (unsigned char *)&cp, sizeof(cp));
+        w->n_ports++;
+        co.n_ports++;
+     }
+
+   eina_binbuf_append_length(w->objects, (unsigned char *)&co, sizeof(co));
+   w->n_objects++;
+}
+
+static void
+_writer_hash(Cache_Writer *w, const Eina_Hash *hash, uint8_t type)
+{
+   Eina_Iterator *it;
+   Epulse_Object *obj;
+
+   it = eina_hash_iterator_data_new(hash);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (!obj->stale)
+           _writer_object(w, obj, type);
+     }
+   eina_iterator_free(it);
+}
+
+Eina_Bool
+_epulse_cache_save(const Eina_Hash *sinks, const Eina_Hash *sink_inputs,
+                   const Eina_Hash *sources, int default_sink)
+{
+   Cache_Writer w;
+   Cache_Header header;
+   char path[PATH_MAX], tmp[PATH_MAX];
+   Eina_Bool ret = EINA_FALSE;
+   FILE *f;
+
+   if (!_cache_path_get(path, sizeof(path), EINA_TRUE))
+      return EINA_FALSE;
+
+   memset(&w, 0, sizeof(w));
+   w.objects = eina_binbuf_new();
+   w.ports = eina_binbuf_new();
+   w.volumes = eina_binbuf_new();
+   w.strings = eina_binbuf_new();
+
+   _writer_hash(&w, sinks, CACHE_SINK);
+   _writer_hash(&w, sink_inputs, CACHE_SINK_INPUT);
+   _writer_hash(&w, sources, CACHE_SOURCE);
+
+   /* keep the mapped string table 4-byte aligned at the end too */
+   while (eina_binbuf_length_get(w.strings) % 4)
+      eina_binbuf_append_char(w.strings, 0);
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+   header.version = CACHE_VERSION;
+   header.default_sink = default_sink;
+   header.n_objects = w.n_objects;
+   header.n_ports = w.n_ports;
+   header.n_volumes = w.n_volumes;
+   header.strings_size = eina_binbuf_length_get(w.strings);
+
+   /* write to a temporary file and rename so readers never see half */
+   snprintf(tmp, sizeof(tmp), "%s.%d", path, getpid());
+   f = fopen(tmp, "wb");
+   if (!f)
+     {
+        WRN("Could not write the state cache %s", tmp);
+        goto end;
+     }
+
+   if (fwrite(&header, sizeof(header), 1, f) != 1 ||
+       fwrite(eina_binbuf_string_get(w.objects), 1,
+              eina_binbuf_length_get(w.objects), f) !=
+       eina_binbuf_length_get(w.objects) ||
+       fwrite(eina_binbuf_string_get(w.ports), 1,
+              eina_binbuf_length_get(w.ports), f) !=
+       eina_binbuf_length_get(w.ports) ||
+       fwrite(eina_binbuf_string_get(w.volumes), 1,
+              eina_binbuf_length_get(w.volumes), f) !=
+       eina_binbuf_length_get(w.volumes) ||
+       fwrite(eina_binbuf_string_get(w.strings), 1,
+              eina_binbuf_length_get(w.strings), f) !=
+       eina_binbuf_length_get(w.strings))
+     {
+        WRN("Could not write the state cache %s", tmp);
+        fclose(f);
+        ecore_file_unlink(tmp);
+        goto end;
+     }
+
+   fclose(f);
+   if (rename(tmp, path) < 0)
+     {
+        WRN("Could not move the state cache to %s", path);
+        ecore_file_unlink(tmp);
+        goto end;
+     }
+
+   DBG("State cache saved: %u objects", w.n_objects);
+   ret = EINA_TRUE;
+
+ end:
+   eina_binbuf_free(w.objects);
+   eina_binbuf_free(w.ports);
+   eina_binbuf_free(w.volumes);
+   eina_binbuf_free(w.strings);
+   return ret;
+}
+
+static char *
+_reader_string(const char *strings, uint32_t size, uint32_t off)
+{
+   if (off == CACHE_NO_STRING || off >= size)
+      return NULL;
+
+   if (!memchr(strings + off, '\0', size - off))
+      return NULL;
+
+   return strdup(strings + off);
+}
+
+Eina_Bool
+_epulse_cache_load(Eina_Hash *sinks, Eina_Hash *sink_inputs,
+                   Eina_Hash *sources, int *default_sink)
+{
+   const Cache_Header *header;
+   const Cache_Object *objects;
+   const Cache_Port *ports;
+   const uint32_t *volumes;
+   const char *strings;
+   char path[PATH_MAX];
+   Eina_File *file;
+   const char *map;
+   size_t size, expected;
+   uint32_t i, j;
+
+   if (!_cache_path_get(path, sizeof(path), EINA_FALSE))
+      return EINA_FALSE;
+
+   file = eina_file_open(path, EINA_FALSE);
+   if (!file)
+      return EINA_FALSE;
+
+   size = eina_file_size_get(file);
+   map = eina_file_map_all(file, EINA_FILE_SEQUENTIAL);
+   if (!map || size < sizeof(Cache_Header))
+      goto err;
+
+   header = (const Cache_Header *)map;
+   if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) ||
+       header->version != CACHE_VERSION)
+     {
+        INF("Ignoring state cache with unknown format");
+        goto err;
+     }
+
+   expected = sizeof(Cache_Header) +
+      (size_t)header->n_objects * sizeof(Cache_Object) +
+      (size_t)header->n_ports * sizeof(Cache_Port) +
+      (size_t)header->n_volumes * sizeof(uint32_t) +
+      header->strings_size;
+   if (expected != size)
+     {
+        WRN("Ignoring truncated state cache %s", path);
+        goto err;
+     }
+
+   objects = (const Cache_Object *)(header + 1);
+   ports = (const Cache_Port *)(objects + header->n_objects);
+   volumes = (const uint32_t *)(ports + header->n_ports);
+   strings = (const char *)(volumes + header->n_volumes);
+
+   for (i = 0; i < header->n_objects; i++)
+     {
+        const Cache_Object *co = objects + i;
+        Epulse_Object *obj;
+        Eina_Hash *hash;
+
+        if (co->channels > PA_CHANNELS_MAX ||
+            co->volumes + co->channels > header->n_volumes ||
+            co->ports + co->n_ports > header->n_ports)
+           continue;
+
+        if (co->type == CACHE_SINK)
+           hash = sinks;
+        else if (co->type == CACHE_SINK_INPUT)
+           hash = sink_inputs;
+        else if (co->type == CACHE_SOURCE)
+           hash = sources;
+        else
+           continue;
+
+        if (eina_hash_find(hash, &co->index))
+           continue;
+
+        obj = calloc(1, sizeof(Epulse_Object));
+        if (!obj)
+           break;
+
+        obj->index = co->index;
+        obj->mute = co->mute;
+        obj->corked = co->corked;
+        obj->sink = co->sink;
+        obj->monitor = co->monitor;
+        /* the process is not cached, it is known once the server answers */
+        obj->pid = -1;
+        obj->name = _reader_string(strings, header->strings_size, co->name);
+        obj->key = _reader_string(strings, header->strings_size, co->key);
+        obj->icon = _reader_string(strings, header->strings_size, co->icon);
+        obj->volume.channels = co->channels;
+        for (j = 0; j < co->channels; j++)
+           obj->volume.values[j] = volumes[co->volumes + j];
+
+        for (j = 0; j < co->n_ports; j++)
+          {
+             const Cache_Port *cp = ports + co->ports + j;
+             Port *port = calloc(1, sizeof(Port));
+
+             if (!port)
+                break;
+             port->name = _reader_string(strings, header->strings_size,
+                                         cp->name);
+             port->description = _reader_string(strings,
+                                                header->strings_size,
+                                                cp->description);
+             port->priority = cp->priority;
+             port->active = cp->active;
+             port->available = cp->available;
+             obj->ports = eina_list_append(obj->ports, port);
+          }
+
+        obj->stale = EINA_TRUE;
+        eina_hash_add(hash, &obj->index, obj);
+     }
+
+   if (default_sink)
+      *default_sink = header->default_sink;
+
+   eina_file_map_free(file, (void *)map);
+   eina_file_close(file);
+   return EINA_TRUE;
+
+ err:
+   if (map)
+      eina_file_map_free(file, (void *)map);
+   eina_file_close(file);
+   return EINA_FALSE;
+}
@@ -0,0 +1,402 @@
+#include "epulse_private.h"
+
+/*
+ * Sound cards and their profiles.
+ *
+ * Cards are cached by index like the other objects. Profiles are kept in
+ * one array per card, sorted by priority, with stringshared names: the
+ * change mask of an update is found comparing pointers, and an event
+ * gets its copy of the table with one allocation. Server events only
+ * fetch the card they are about, never the whole list.
+ */
+
+int CARD_ADDED = 0;
+int CARD_CHANGED = 0;
+int CARD_REMOVED = 0;
+
+static Eina_Hash *_cards = NULL;
+
+static void
+_profiles_free(Epulse_Card_Profile *profiles, unsigned int count)
+{
+   unsigned int i;
+
+   for (i = 0; i < count; i++)
+     {
+        eina_stringshare_del(profiles[i].name);
+        eina_stringshare_del(profiles[i].description);
+     }
+   free(profiles);
+}
+
+static Epulse_Card_Profile *
+_profiles_dup(const Epulse_Card_Profile *profiles, unsigned int count)
+{
+   Epulse_Card_Profile *dup;
+   unsigned int i;
+
+   if (!count)
+      return NULL;
+
+   dup = malloc(count * sizeof(Epulse_Card_Profile));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(dup, NULL);
+
+   memcpy(dup, profiles, count * sizeof(Epulse_Card_Profile));
+   for (i = 0; i < count; i++)
+     {
+        eina_stringshare_ref(dup[i].name);
+        eina_stringshare_ref(dup[i].description);
+     }
+
+   return dup;
+}
+
+static void
+_card_free(Epulse_Event_Card *card)
+{
+   free(card->name);
+   free(card->icon);
+   _profiles_free(card->profiles, card->profile_count);
+   free(card);
+}
+
+static void
+_card_free_cb(void *data)
+{
+   _card_free(data);
+}
+
+static void
+_event_card_free_cb(void *user_data EINA_UNUSED, void *func_data)
+{
+   _card_free(func_data);
+}
+
+static Epulse_Event_Card *
+_card_dup(const Epulse_Event_Card *card)
+{
+   Epulse_Event_Card *dup;
+
+   dup = calloc(1, sizeof(Epulse_Event_Card));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(dup, NULL);
+
+   dup->index = card->index;
+   dup->name = card->name ? strdup(card->name) : NULL;
+   dup->icon = card->icon ? strdup(card->icon) : NULL;
+   dup->profiles = _profiles_dup(card->profiles, card->profile_count);
+   dup->profile_count = dup->profiles ? card->profile_count : 0;
+   dup->active = dup->profiles ? card->active : -1;
+   dup->changed = card->changed;
+
+   return dup;
+}
+
+static int
+_profile_cmp(const void *a, const void *b)
+{
+   const Epulse_Card_Profile *pa = a, *pb = b;
+
+   if (pa->priority != pb->priority)
+      return pa->priority > pb->priority ? -1 : 1;
+
+   return strcmp(pa->name, pb->name);
+}
+
+static Epulse_Event_Card *
+_card_new(const pa_card_info *info)
+{
+   Epulse_Event_Card *card;
+   const char *t;
+   uint32_t i;
+
+   card = calloc(1, sizeof(Epulse_Event_Card));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(card, NULL);
+
+   card->index = info->index;
+   t = pa_proplist_gets(info->proplist, PA_PROP_DEVICE_DESCRIPTION);
+   card->name = strdup(t ? t : info->name);
+   if ((t = pa_proplist_gets(info->proplist, PA_PROP_DEVICE_ICON_NAME)))
+      card->icon = strdup(t);
+   card->active = -1;
+   card->changed = EPULSE_CHANGE_ALL;
+
+   if (!info->n_profiles || !info->profiles2)
+      return card;
+
+   card->profiles = calloc(info->n_profiles, sizeof(Epulse_Card_Profile));
+   EINA_SAFETY_ON_NULL_GOTO(card->profiles, error);
+   card->profile_count = info->n_profiles;
+
+   for (i = 0; i < info->n_profiles; i++)
+     {
+        card->profiles[i].name =
+           eina_stringshare_add(info->profiles2[i]->name);
+        card->profiles[i].description =
+           eina_stringshare_add(info->profiles2[i]->description ?:
+                                info->profiles2[i]->name);
+        card->profiles[i].priority = info->profiles2[i]->priority;
+        card->profiles[i].available = !!info->profiles2[i]->available;
+     }
+   qsort(card->profiles, card->profile_count, sizeof(Epulse_Card_Profile),
+         _profile_cmp);
+
+   if (info->active_profile2)
+     {
+        t = eina_stringshare_add(info->active_profile2->name);
+        for (i = 0; i < card->profile_count; i++)
+          {
+             if (card->profiles[i].name == t)
+               {
+                  card->active = i;
+                  break;
+               }
+          }
+        eina_stringshare_del(t);
+     }
+
+   return card;
+
+ error:
+   _card_free(card);
+   return NULL;
+}
+
+static Eina_Bool
+_profiles_equal(const Epulse_Event_Card *a, const Epulse_Event_Card *b)
+{
+   unsigned int i;
+
+   if (a->profile_count != b->profile_count)
+      return EINA_FALSE;
+
+   for (i = 0; i < a->profile_count; i++)
+     {
+        if (a->profiles[i].name != b->profiles[i].name ||
+            a->profiles[i].description != b->profiles[i].description ||
+            a->profiles[i].priority != b->profiles[i].priority ||
+            a->profiles[i].available != b->profiles[i].available)
+           return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+static const char *
+_active_name(const Epulse_Event_Card *card)
+{
+   return card->active >= 0 ? card->profiles[card->active].name : NULL;
+}
+
+static Eina_Bool
+_str_equal(const char *a, const char *b)
+{
+   if (!a || !b)
+      return a == b;
+
+   return !strcmp(a, b);
+}
+
+/*
+ * Replaces the cached card with the new state, keeping the new one, and
+ * returns which fields differ. Cards seen for the first time report
+ * every field as changed.
+ */
+static unsigned int
+_card_cache_update(Epulse_Event_Card *card)
+{
+   Epulse_Event_Card *old;
+   unsigned int changed = EPULSE_CHANGE_NONE;
+
+   old = eina_hash_find(_cards, &card->index);
+   if (!old)
+     {
+        eina_hash_add(_cards, &card->index, card);
+        return EPULSE_CHANGE_ALL;
+     }
+
+   if (!_str_equal(old->name, card->name))
+      changed |= EPULSE_CHANGE_NAME;
+   if (!_str_equal(old->icon, card->icon))
+      changed |= EPULSE_CHANGE_ICON;
+   if (!_profiles_equal(old, card))
+      changed |= EPULSE_CHANGE_PROFILES;
+   /* stringshares, the same name is the same pointer */
+   if (_active_name(old) != _active_name(card))
+      changed |= EPULSE_CHANGE_ACTIVE_PROFILE;
+
+   eina_hash_modify(_cards, &card->index, card);
+   _card_free(old);
+
+   return changed;
+}
+
+static void
+_card_cb(pa_context *c, const pa_card_info *info, int eol,
+         void *userdata EINA_UNUSED)
+{
+   Epulse_Event_Card *card, *ev;
+   Eina_Bool known;
+
+   if (eol < 0)
+     {
+        if (pa_context_errno(c) == PA_ERR_NOENTITY)
+           return;
+
+        ERR("Card callback failure");
+        return;
+     }
+
+   if (eol > 0 || !_cards)
+      return;
+
+   DBG("card index: %d\ncard name: %s", info->index, info->name);
+
+   card = _card_new(info);
+   EINA_SAFETY_ON_NULL_RETURN(card);
+
+   known = !!eina_hash_find(_cards, &card->index);
+   card->changed = _card_cache_update(card);
+   if (!card->changed)
+      return;
+
+   if ((ev = _card_dup(card)))
+      ecore_event_add(known ? CARD_CHANGED : CARD_ADDED, ev,
+                      _event_card_free_cb, NULL);
+}
+
+static void
+_card_remove(int index)
+{
+   Epulse_Event_Card *ev;
+
+   DBG("Removing card: %d", index);
+
+   if (!eina_hash_del_by_key(_cards, &index))
+      return;
+
+   ev = calloc(1, sizeof(Epulse_Event_Card));
+   EINA_SAFETY_ON_NULL_RETURN(ev);
+   ev->index = index;
+   ev->active = -1;
+
+   ecore_event_add(CARD_REMOVED, ev, _event_card_free_cb, NULL);
+}
+
+void
+_epulse_card_init(void)
+{
+   CARD_ADDED = ecore_event_type_new();
+   CARD_CHANGED = ecore_event_type_new();
+   CARD_REMOVED = ecore_event_type_new();
+
+   _cards = eina_hash_int32_new(_card_free_cb);
+}
+
+void
+_epulse_card_shutdown(void)
+{
+   eina_hash_free(_cards);
+   _cards = NULL;
+}
+
+/* the server went away, consumers drop their cards on DISCONNECTED */
+void
+_epulse_cards_clear(void)
+{
+   eina_hash_free_buckets(_cards);
+}
+
+void
+_epulse_cards_list(pa_context *c)
+{
+   pa_operation *o;
+
+   if (!(o = pa_context_get_card_info_list(c, _card_cb, NULL)))
+     {
+        ERR("pa_context_get_card_info_list() failed");
+        return;
+     }
+   pa_operation_unref(o);
+}
+
+void
+_epulse_card_event(pa_context *c, pa_subscription_event_type_t t,
+                   uint32_t index)
+{
+   pa_operation *o;
+
+   if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
+     {
+        _card_remove(index);
+        return;
+     }
+
+   if (!(o = pa_context_get_card_info_by_index(c, index, _card_cb, NULL)))
+     {
+        ERR("pa_context_get_card_info_by_index() failed");
+        return;
+     }
+   pa_operation_unref(o);
+}
+
+Eina_Hash *
+_epulse_cards_get(void)
+{
+   return _cards;
+}
+
+void
+_epulse_card_replay(void)
+{
+   Epulse_Event_Card *card, *ev;
+   Eina_Iterator *it;
+
+   if (!_cards)
+      return;
+
+   it = eina_hash_iterator_data_new(_cards);
+   EINA_ITERATOR_FOREACH(it, card)
+     {
+        if (!(ev = _card_dup(card)))
+           break;
+        ev->changed = EPULSE_CHANGE_ALL;
+        ecore_event_add(CARD_ADDED, ev, _event_card_free_cb, NULL);
+     }
+   eina_iterator_free(it);
+}
+
+static void
+_card_profile_set_cb(pa_context *c EINA_UNUSED, int success, void *userdata)
+{
+   int index = (intptr_t)userdata;
+
+   if (!success)
+      ERR("The server refused the profile of card %d", index);
+}
+
+/*
+ * Switches the card to the profile with the given name. The request is
+ * not waited for, the new profile comes back as a CARD_CHANGED event
+ * with EPULSE_CHANGE_ACTIVE_PROFILE set.
+ */
+Eina_Bool
+epulse_card_profile_set(int index, const char *profile)
+{
+   pa_context *c = _epulse_pa_context_get();
+   pa_operation *o;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(c, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(profile, EINA_FALSE);
+
+   /* cards are not batch objects, nothing to hold back */
+   if (!(o = pa_context_set_card_profile_by_index(c, index, profile,
+                                                  _card_profile_set_cb,
+                                                  (void *)(intptr_t)index)))
+     {
+        ERR("pa_context_set_card_profile_by_index() failed");
+        return EINA_FALSE;
+     }
+   pa_operation_unref(o);
+
+   return EINA_TRUE;
+}
@@ -0,0 +1,523 @@
+#include "epulse_private.h"
+
+/*
+ * Scripting interface served on the EPULSE_CTL_NAME socket by whoever
+ * holds the PulseAudio connection (the module or a resident epulse), so
+ * a hotkey costs one socket write instead of a new client handshake.
+ *
+ * One command per line, named after the pactl ones:
+ *
+ *   set-sink-volume <sink> <volume>
+ *   set-sink-mute <sink> <1|0|toggle>
+ *   set-source-volume <source> <volume>
+ *   set-source-mute <source> <1|0|toggle>
+ *   set-sink-input-volume <input> <volume>
+ *   set-sink-input-mute <input> <1|0|toggle>
+ *   move-sink-input <input> <sink>
+ *   set-default-sink <sink>
+ *   get-default-sink
+ *   switch-output <sink>
+ *   fade-sink-volume <sink> <volume> <ms>
+ *   set-ducking <percent>
+ *   list-sinks | list-sources | list-sink-inputs
+ *   save-scene <name> | apply-scene <name> | delete-scene <name>
+ *   list-scenes
+ *   set-card-profile <card> <profile>
+ *   list-cards
+ *
+ * Objects are given by index, sinks also as @DEFAULT_SINK@. Volumes are
+ * in percent, absolute ("40") or relative ("+5", "-5"), and never go
+ * above CTL_VOLUME_MAX. Listings are one tab separated line per object:
+ * index, volume, mute, for streams also sink and corked, then cached and
+ * the name. Cached objects come from the last session and are not
+ * confirmed by the server yet, commands refuse them until they are.
+ * Every reply ends with a line reading "ok" or "error <reason>".
+ */
+
+#define CTL_ARGS_MAX 3
+#define CTL_VOLUME_MAX 150 /* percent */
+
+typedef struct _Ctl_Command Ctl_Command;
+struct _Ctl_Command
+{
+   const char *name;
+   unsigned int nargs;
+   const char *(*func)(Epulse_Ipc_Client *client, char **args);
+};
+
+static const Epulse_Object *
+_ctl_object_get(Epulse_Meter_Type type, const char *arg)
+{
+   Eina_Hash *hash = _epulse_objects_get(type);
+   char *end;
+   int index;
+
+   if (!hash)
+      return NULL;
+
+   if (type == EPULSE_METER_SINK && !strcmp(arg, "@DEFAULT_SINK@"))
+      index = _epulse_default_sink_get();
+   else
+     {
+        index = strtol(arg, &end, 10);
+        if (end == arg || *end)
+           return NULL;
+     }
+
+   return eina_hash_find(hash, &index);
+}
+
+/* whether a command can act on obj, or the reason why not */
+static const char *
+_ctl_object_check(const Epulse_Object *obj)
+{
+   if (!obj)
+      return "no such object";
+   if (obj->stale)
+      return "not confirmed by the server yet";
+
+   return NULL;
+}
+
+static Eina_Bool
+_ctl_volume_parse(const char *arg, const pa_cvolume *current,
+                  pa_cvolume *volume)
+{
+   pa_volume_t step;
+   char *end;
+   long val;
+
+   val = strtol(arg, &end, 10);
+   if (end == arg || (*end && strcmp(end, "%")) || !current->channels)
+      return EINA_FALSE;
+
+   *volume = *current;
+   if (arg[0] == '+' || arg[0] == '-')
+     {
+        step = INT_TO_PA_VOLUME(labs(val));
+        if (val > 0)
+           pa_cvolume_inc_clamp(volume, step,
+                                INT_TO_PA_VOLUME(CTL_VOLUME_MAX));
+        else
+           pa_cvolume_dec(volume, step);
+        return EINA_TRUE;
+     }
+
+   if (val < 0 || val > CTL_VOLUME_MAX)
+      return EINA_FALSE;
+
+   pa_cvolume_set(volume, current->channels, INT_TO_PA_VOLUME(val));
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_ctl_mute_parse(const char *arg, Eina_Bool current, Eina_Bool *mute)
+{
+   if (!strcmp(arg, "1") || !strcmp(arg, "on") || !strcmp(arg, "yes"))
+      *mute = EINA_TRUE;
+   else if (!strcmp(arg, "0") || !strcmp(arg, "off") || !strcmp(arg, "no"))
+      *mute = EINA_FALSE;
+   else if (!strcmp(arg, "toggle"))
+      *mute = !current;
+   else
+      return EINA_FALSE;
+
+   return EINA_TRUE;
+}
+
+static const char *
+_ctl_volume_set(Epulse_Meter_Type type, char **args)
+{
+   const Epulse_Object *obj = _ctl_object_get(type, args[0]);
+   const char *error = _ctl_object_check(obj);
+   pa_cvolume volume;
+   Eina_Bool ret;
+
+   if (error)
+      return error;
+   if (!_ctl_volume_parse(args[1], &obj->volume, &volume))
+      return "invalid volume";
+
+   if (type == EPULSE_METER_SINK)
+      ret = epulse_sink_volume_set(obj->index, volume);
+   else if (type == EPULSE_METER_SOURCE)
+      ret = epulse_source_volume_set(obj->index, volume);
+   else
+      ret = epulse_sink_input_volume_set(obj->index, volume);
+
+   return ret ? NULL : "request failed";
+}
+
+static const char *
+_ctl_mute_set(Epulse_Meter_Type type, char **args)
+{
+   const Epulse_Object *obj = _ctl_object_get(type, args[0]);
+   const char *error = _ctl_object_check(obj);
+   Eina_Bool mute, ret;
+
+   if (error)
+      return error;
+   if (!_ctl_mute_parse(args[1], obj->mute, &mute))
+      return "invalid mute state";
+
+   if (type == EPULSE_METER_SINK)
+      ret = epulse_sink_mute_set(obj->index, mute);
+   else if (type == EPULSE_METER_SOURCE)
+      ret = epulse_source_mute_set(obj->index, mute);
+   else
+      ret = epulse_sink_input_mute_set(obj->index, mute);
+
+   return ret ? NULL : "request failed";
+}
+
+static const char *
+_ctl_sink_volume_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return _ctl_volume_set(EPULSE_METER_SINK, args);
+}
+
+static const char *
+_ctl_sink_mute_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return _ctl_mute_set(EPULSE_METER_SINK, args);
+}
+
+static const char *
+_ctl_source_volume_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return _ctl_volume_set(EPULSE_METER_SOURCE, args);
+}
+
+static const char *
+_ctl_source_mute_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return _ctl_mute_set(EPULSE_METER_SOURCE, args);
+}
+
+static const char *
+_ctl_sink_input_volume_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return _ctl_volume_set(EPULSE_METER_SINK_INPUT, args);
+}
+
+static const char *
+_ctl_sink_input_mute_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return _ctl_mute_set(EPULSE_METER_SINK_INPUT, args);
+}
+
+static const char *
+_ctl_sink_input_move_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   const Epulse_Object *input, *sink;
+   const char *error;
+
+   input = _ctl_object_get(EPULSE_METER_SINK_INPUT, args[0]);
+   sink = _ctl_object_get(EPULSE_METER_SINK, args[1]);
+   if ((error = _ctl_object_check(input)) ||
+       (error = _ctl_object_check(sink)))
+      return error;
+
+   return epulse_sink_input_move(input->index, sink->index) ?
+      NULL : "request failed";
+}
+
+static const char *
+_ctl_default_sink_set_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   const Epulse_Object *sink = _ctl_object_get(EPULSE_METER_SINK, args[0]);
+   const char *error = _ctl_object_check(sink);
+
+   if (error)
+      return error;
+
+   return epulse_sink_default_set(sink->index) ? NULL : "request failed";
+}
+
+static const char *
+_ctl_sink_fade_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   const Epulse_Object *sink = _ctl_object_get(EPULSE_METER_SINK, args[0]);
+   const char *error = _ctl_object_check(sink);
+   pa_cvolume volume;
+   char *end;
+   long ms;
+
+   if (error)
+      return error;
+   if (!_ctl_volume_parse(args[1], &sink->volume, &volume))
+      return "invalid volume";
+
+   ms = strtol(args[2], &end, 10);
+   if (end == args[2] || *end || ms < 0)
+      return "invalid duration";
+
+   return epulse_fade_start(EPULSE_METER_SINK, sink->index,
+                            pa_cvolume_max(&volume), ms,
+                            EPULSE_FADE_SMOOTH) ? NULL : "request failed";
+}
+
+static const char *
+_ctl_ducking_set_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   char *end;
+   long percent = strtol(args[0], &end, 10);
+
+   if (end == args[0] || (*end && strcmp(end, "%")) || percent < 0 ||
+       percent > 100)
+      return "invalid level";
+
+   epulse_ducking_set(percent, EPULSE_DUCKING_DURATION);
+   return NULL;
+}
+
+static const char *
+_ctl_output_switch_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   const Epulse_Object *sink = _ctl_object_get(EPULSE_METER_SINK, args[0]);
+   const char *error = _ctl_object_check(sink);
+
+   if (error)
+      return error;
+
+   return epulse_output_switch(sink->index, NULL, NULL) ?
+      NULL : "request failed";
+}
+
+static void
+_ctl_object_reply(Epulse_Ipc_Client *client, Epulse_Meter_Type type,
+                  const Epulse_Object *obj)
+{
+   int vol = PA_VOLUME_TO_INT(pa_cvolume_avg(&obj->volume));
+
+   if (type == EPULSE_METER_SINK_INPUT)
+      epulse_ipc_reply(client, "%d\t%d\t%d\t%d\t%d\t%d\t%s", obj->index,
+                       vol, obj->mute, obj->sink, obj->corked, obj->stale,
+                       obj->name ? obj->name : "");
+   else
+      epulse_ipc_reply(client, "%d\t%d\t%d\t%d\t%s", obj->index, vol,
+                       obj->mute, obj->stale, obj->name ? obj->name : "");
+}
+
+static const char *
+_ctl_default_sink_get_cb(Epulse_Ipc_Client *client, char **args EINA_UNUSED)
+{
+   const Epulse_Object *sink;
+
+   sink = _ctl_object_get(EPULSE_METER_SINK, "@DEFAULT_SINK@");
+   if (!sink)
+      return "no default sink";
+
+   _ctl_object_reply(client, EPULSE_METER_SINK, sink);
+   return NULL;
+}
+
+static const char *
+_ctl_list(Epulse_Ipc_Client *client, Epulse_Meter_Type type)
+{
+   Eina_Hash *hash = _epulse_objects_get(type);
+   Eina_Iterator *it;
+   Epulse_Object *obj;
+
+   if (!hash)
+      return "not connected";
+
+   it = eina_hash_iterator_data_new(hash);
+   EINA_ITERATOR_FOREACH(it, obj)
+      _ctl_object_reply(client, type, obj);
+   eina_iterator_free(it);
+
+   return NULL;
+}
+
+static const char *
+_ctl_sinks_list_cb(Epulse_Ipc_Client *client, char **args EINA_UNUSED)
+{
+   return _ctl_list(client, EPULSE_METER_SINK);
+}
+
+static const char *
+_ctl_sources_list_cb(Epulse_Ipc_Client *client, char **args EINA_UNUSED)
+{
+   return _ctl_list(client, EPULSE_METER_SOURCE);
+}
+
+static const char *
+_ctl_sink_inputs_list_cb(Epulse_Ipc_Client *client, char **args EINA_UNUSED)
+{
+   return _ctl_list(client, EPULSE_METER_SINK_INPUT);
+}
+
+static const Epulse_Event_Card *
+_ctl_card_get(const char *arg)
+{
+   Eina_Hash *cards = _epulse_cards_get();
+   char *end;
+   int index;
+
+   if (!cards)
+      return NULL;
+
+   index = strtol(arg, &end, 10);
+   if (end == arg || *end)
+      return NULL;
+
+   return eina_hash_find(cards, &index);
+}
+
+static const char *
+_ctl_card_profile_set_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   const Epulse_Event_Card *card = _ctl_card_get(args[0]);
+   unsigned int i;
+
+   if (!card)
+      return "no such object";
+
+   for (i = 0; i < card->profile_count; i++)
+      if (!strcmp(card->profiles[i].name, args[1]))
+         break;
+   if (i == card->profile_count)
+      return "no such profile";
+
+   return epulse_card_profile_set(card->index, card->profiles[i].name) ?
+      NULL : "request failed";
+}
+
+static const char *
+_ctl_cards_list_cb(Epulse_Ipc_Client *client, char **args EINA_UNUSED)
+{
+   Eina_Hash *cards = _epulse_cards_get();
+   const Epulse_Event_Card *card;
+   Eina_Iterator *it;
+
+   if (!cards)
+      return "not connected";
+
+   it = eina_hash_iterator_data_new(cards);
+   EINA_ITERATOR_FOREACH(it, card)
+      epulse_ipc_reply(client, "%d\t%s\t%s", card->index,
+                       card->active >= 0 ?
+                       card->profiles[card->active].name : "",
+                       card->name ? card->name : "");
+   eina_iterator_free(it);
+
+   return NULL;
+}
+
+static const char *
+_ctl_scene_save_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return epulse_scene_save(args[0]) ? NULL : "could not save the scene";
+}
+
+static const char *
+_ctl_scene_apply_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return epulse_scene_apply(args[0], NULL, NULL) ? NULL : "no such scene";
+}
+
+static const char *
+_ctl_scene_del_cb(Epulse_Ipc_Client *client EINA_UNUSED, char **args)
+{
+   return epulse_scene_del(args[0]) ? NULL : "no such scene";
+}
+
+static const char *
+_ctl_scenes_list_cb(Epulse_Ipc_Client *client, char **args EINA_UNUSED)
+{
+   Eina_List *names = epulse_scene_list();
+   const char *name;
+
+   EINA_LIST_FREE(names, name)
+     {
+        epulse_ipc_reply(client, "%s", name);
+        eina_stringshare_del(name);
+     }
+
+   return NULL;
+}
+
+static const Ctl_Command _commands[] = {
+   { "set-sink-volume", 2, _ctl_sink_volume_cb },
+   { "set-sink-mute", 2, _ctl_sink_mute_cb },
+   { "set-source-volume", 2, _ctl_source_volume_cb },
+   { "set-source-mute", 2, _ctl_source_mute_cb },
+   { "set-sink-input-volume", 2, _ctl_sink_input_volume_cb },
+   { "set-sink-input-mute", 2, _ctl_sink_input_mute_cb },
+   { "move-sink-input", 2, _ctl_sink_input_move_cb },
+   { "set-default-sink", 1, _ctl_default_sink_set_cb },
+   { "get-default-sink", 0, _ctl_default_sink_get_cb },
+   { "switch-output", 1, _ctl_output_switch_cb },
+   { "fade-sink-volume", 3, _ctl_sink_fade_cb },
+   { "set-ducking", 1, _ctl_ducking_set_cb },
+   { "list-sinks", 0, _ctl_sinks_list_cb },
+   { "list-sources", 0, _ctl_sources_list_cb },
+   { "list-sink-inputs", 0, _ctl_sink_inputs_list_cb },
+   { "save-scene", 1, _ctl_scene_save_cb },
+   { "apply-scene", 1, _ctl_scene_apply_cb },
+   { "delete-scene", 1, _ctl_scene_del_cb },
+   { "list-scenes", 0, _ctl_scenes_list_cb },
+   { "set-card-profile", 2, _ctl_card_profile_set_cb },
+   { "list-cards", 0, _ctl_cards_list_cb },
+   { NULL, 0, NULL }
+};
+
+static void
+_ctl_command_cb(void *data EINA_UNUSED, Epulse_Ipc_Client *client,
+                const char *command)
+{
+   char *args[CTL_ARGS_MAX + 1] = { NULL };
+   char *line, *name, *save = NULL;
+   const Ctl_Command *cmd;
+   const char *error = NULL;
+   unsigned int nargs = 0;
+
+   line = strdup(command);
+   EINA_SAFETY_ON_NULL_RETURN(line);
+
+   name = strtok_r(line, " \t", &save);
+   while (name && nargs <= CTL_ARGS_MAX &&
+          (args[nargs] = strtok_r(NULL, " \t", &save)))
+      nargs++;
+
+   for (cmd = _commands; cmd->name; cmd++)
+      if (name && !strcmp(cmd->name, name))
+         break;
+
+   if (!cmd->name)
+      error = "unknown command";
+   else if (nargs != cmd->nargs)
+      error = "wrong number of arguments";
+   else if (!_epulse_pa_context_get())
+      error = "not connected";
+   else
+      error = cmd->func(client, args);
+
+   if (error)
+     {
+        DBG("Control command '%s' failed: %s", command, error);
+        epulse_ipc_reply(client, "error %s", error);
+     }
+   else
+      epulse_ipc_reply(client, "ok");
+
+   free(line);
+}
+
+/*
+ * Returns NULL when another process already serves the control socket.
+ * The one serving it also runs the application rules, other processes
+ * would apply them again and race on the file.
+ */
+Epulse_Ipc *
+epulse_ctl_server_add(void)
+{
+   Epulse_Ipc *ipc;
+
+   ipc = epulse_ipc_server_add(EPULSE_CTL_NAME, _ctl_command_cb, NULL);
+   if (ipc)
+      _epulse_policies_set(EINA_TRUE);
+
+   return ipc;
+}
@@ -0,0 +1,616 @@
+#include "epulse_private.h"
+
+#include <Eet.h>
+
+/*
+ * Volume ramps and ducking.
+ *
+ * Every running fade is advanced by one shared timer. Each tick writes
+ * at most one volume per object, and none while the previous write of
+ * that object is still in flight: the next tick sends the latest value
+ * instead, so a slow server sees fewer, not queued up, requests.
+ *
+ * Ducking fades every other stream down while a phone stream plays and
+ * back up to where it was once the last one is gone or corked. Only the
+ * process serving epulse-ctl ducks, two of them would take each other's
+ * lowered volumes for the ones to restore. The level is kept in the
+ * config directory and ducked streams are restored at shutdown.
+ */
+
+#define FADE_TICK (1.0 / 30.0)
+#define DUCK_LEVEL_DEFAULT 30 /* percent of the original volume */
+#define DUCK_FILE "ducking.eet"
+#define DUCK_RESTORE_TIMEOUT 0.5
+
+typedef struct _Fade Fade;
+struct _Fade
+{
+   Epulse_Meter_Type type;
+   int index;
+   pa_cvolume base; /* balance to keep, scaled to the current level */
+   pa_volume_t from;
+   pa_volume_t to;
+   pa_volume_t written;
+   double start;
+   double duration;
+   Epulse_Fade_Curve curve;
+   Eina_Bool in_flight;
+};
+
+typedef struct _Duck Duck;
+struct _Duck
+{
+   int index;
+   pa_volume_t volume; /* to restore */
+};
+
+static Eina_List *_fades = NULL;
+static Ecore_Timer *_timer = NULL;
+
+static Eina_List *_ducks = NULL;
+static Eina_Bool _duck_loaded = EINA_FALSE;
+static unsigned int _duck_level = DUCK_LEVEL_DEFAULT;
+static unsigned int _duck_duration = EPULSE_DUCKING_DURATION;
+
+#define FADE_KEY(_type, _index) \
+   ((void *)(intptr_t)(((_index) << 2) | (_type)))
+
+static Fade *
+_fade_find(Epulse_Meter_Type type, int index)
+{
+   const Eina_List *l;
+   Fade *f;
+
+   EINA_LIST_FOREACH(_fades, l, f)
+      if (f->type == type && f->index == index)
+         return f;
+
+   return NULL;
+}
+
+static double
+_curve(Epulse_Fade_Curve curve, double t)
+{
+   switch (curve)
+     {
+      case EPULSE_FADE_EASE_IN:
+         return t * t;
+      case EPULSE_FADE_EASE_OUT:
+         return 1.0 - (1.0 - t) * (1.0 - t);
+      case EPULSE_FADE_SMOOTH:
+         return t * t * (3.0 - 2.0 * t);
+      case EPULSE_FADE_LINEAR:
+      default:
+         return t;
+     }
+}
+
+/* the userdata is the object key, a stopped fade must not be touched */
+static void
+_fade_written_cb(pa_context *c EINA_UNUSED, int success, void *userdata)
+{
+   const Eina_List *l;
+   Fade *f;
+
+   EINA_LIST_FOREACH(_fades, l, f)
+     {
+        if (FADE_KEY(f->type, f->index) != userdata)
+           continue;
+
+        f->in_flight = EINA_FALSE;
+        if (!success)
+           DBG("Fade write failed for object %d", f->index);
+        break;
+     }
+}
+
+static Eina_Bool
+_fade_write(Fade *f, pa_volume_t volume)
+{
+   pa_context *c = _epulse_pa_context_get();
+   pa_cvolume cv = f->base;
+   pa_operation *o = NULL;
+   void *key = FADE_KEY(f->type, f->index);
+
+   if (!c)
+      return EINA_FALSE;
+
+   pa_cvolume_scale(&cv, volume);
+   switch (f->type)
+     {
+      case EPULSE_METER_SINK:
+         o = pa_context_set_sink_volume_by_index(c, f->index, &cv,
+                                                 _fade_written_cb, key);
+         break;
+      case EPULSE_METER_SOURCE:
+         o = pa_context_set_source_volume_by_index(c, f->index, &cv,
+                                                   _fade_written_cb, key);
+         break;
+      case EPULSE_METER_SINK_INPUT:
+         o = pa_context_set_sink_input_volume(c, f->index, &cv,
+                                              _fade_written_cb, key);
+         break;
+     }
+
+   if (!o)
+      return EINA_FALSE;
+   pa_operation_unref(o);
+
+   f->in_flight = EINA_TRUE;
+   f->written = volume;
+   return EINA_TRUE;
+}
+
+/* returns whether fades are left */
+static Eina_Bool
+_fades_advance(void)
+{
+   double now = ecore_loop_time_get(), t;
+   Eina_Bool connected = !!_epulse_pa_context_get();
+   Eina_List *l, *ll;
+   Eina_Hash *hash;
+   pa_volume_t volume;
+   Fade *f;
+
+   EINA_LIST_FOREACH_SAFE(_fades, l, ll, f)
+     {
+        hash = _epulse_objects_get(f->type);
+        if (!connected || !hash || !eina_hash_find(hash, &f->index))
+          {
+             _fades = eina_list_remove_list(_fades, l);
+             free(f);
+             continue;
+          }
+
+        t = f->duration > 0.0 ? (now - f->start) / f->duration : 1.0;
+        if (t > 1.0)
+           t = 1.0;
+        volume = f->from + ((double)f->to - f->from) * _curve(f->curve, t);
+
+        if (!f->in_flight && volume != f->written &&
+            !_fade_write(f, volume))
+          {
+             ERR("Could not set the volume of object %d", f->index);
+             _fades = eina_list_remove_list(_fades, l);
+             free(f);
+             continue;
+          }
+
+        /* done once the final level went out */
+        if (t >= 1.0 && f->written == f->to && !f->in_flight)
+          {
+             _fades = eina_list_remove_list(_fades, l);
+             free(f);
+          }
+     }
+
+   return !!_fades;
+}
+
+static Eina_Bool
+_fade_tick_cb(void *data EINA_UNUSED)
+{
+   if (_fades_advance())
+      return ECORE_CALLBACK_RENEW;
+
+   _timer = NULL;
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static Eina_Bool
+_fade_add(Epulse_Meter_Type type, int index, pa_volume_t target,
+          unsigned int ms, Epulse_Fade_Curve curve)
+{
+   const Epulse_Object *obj;
+   Eina_Hash *hash;
+   Fade *f;
+
+   hash = _epulse_objects_get(type);
+   if (!hash || !(obj = eina_hash_find(hash, &index)))
+      return EINA_FALSE;
+
+   /* a new fade of the same object takes over from where it is */
+   f = _fade_find(type, index);
+   if (!f)
+     {
+        f = calloc(1, sizeof(Fade));
+        EINA_SAFETY_ON_NULL_RETURN_VAL(f, EINA_FALSE);
+        f->type = type;
+        f->index = index;
+        f->base = obj->volume;
+        f->written = pa_cvolume_max(&obj->volume);
+        _fades = eina_list_append(_fades, f);
+     }
+
+   f->from = f->written;
+   f->to = target;
+   f->start = ecore_loop_time_get();
+   f->duration = ms / 1000.0;
+   f->curve = curve;
+
+   /* the first step goes out now, a zero length fade is a plain set */
+   if (!_fades_advance())
+     {
+        if (_timer)
+           ecore_timer_del(_timer);
+        _timer = NULL;
+     }
+   else if (!_timer)
+      _timer = ecore_timer_add(FADE_TICK, _fade_tick_cb, NULL);
+
+   return EINA_TRUE;
+}
+
+/*
+ * Ramps the volume of an object to target over ms milliseconds, keeping
+ * its balance. Replaces a fade already running on the same object.
+ */
+Eina_Bool
+epulse_fade_start(Epulse_Meter_Type type, int index, pa_volume_t target,
+                  unsigned int ms, Epulse_Fade_Curve curve)
+{
+   EINA_SAFETY_ON_FALSE_RETURN_VAL(PA_VOLUME_IS_VALID(target), EINA_FALSE);
+
+   if (!_epulse_pa_context_get())
+      return EINA_FALSE;
+
+   return _fade_add(type, index, target, ms, curve);
+}
+
+/*
+ * Stops a fade where it is.
+ */
+void
+epulse_fade_cancel(Epulse_Meter_Type type, int index)
+{
+   Fade *f = _fade_find(type, index);
+
+   if (!f)
+      return;
+
+   _fades = eina_list_remove(_fades, f);
+   free(f);
+}
+
+static void
+_duck_level_load(void)
+{
+   char path[PATH_MAX];
+   Eet_File *ef;
+   char *level;
+   int size;
+
+   _duck_loaded = EINA_TRUE;
+   if (!_epulse_config_path_get(path, sizeof(path), DUCK_FILE, EINA_FALSE))
+      return;
+
+   eet_init();
+   ef = eet_open(path, EET_FILE_MODE_READ);
+   if (ef)
+     {
+        level = eet_read(ef, "level", &size);
+        if (level && size > 0 && !level[size - 1] && atoi(level) >= 0 &&
+            atoi(level) <= 100)
+           _duck_level = atoi(level);
+        free(level);
+        eet_close(ef);
+     }
+   eet_shutdown();
+}
+
+static void
+_duck_level_save(void)
+{
+   char path[PATH_MAX], level[16];
+   Eet_File *ef;
+
+   if (!_epulse_config_path_get(path, sizeof(path), DUCK_FILE, EINA_TRUE))
+      return;
+
+   eet_init();
+   ef = eet_open(path, EET_FILE_MODE_WRITE);
+   if (ef)
+     {
+        snprintf(level, sizeof(level), "%u", _duck_level);
+        eet_write(ef, "level", level, strlen(level) + 1, EINA_FALSE);
+        eet_close(ef);
+     }
+   else
+      ERR("Could not write %s", path);
+   eet_shutdown();
+}
+
+static Eina_Bool
+_role_is_phone(const char *role)
+{
+   return role && (!strcasecmp(role, "phone") ||
+                   !strcasecmp(role, "communication"));
+}
+
+/* corked calls are on hold, they leave the others alone */
+static Eina_Bool
+_phone_playing(const Epulse_Object *obj)
+{
+   return !obj->stale && !obj->corked && _role_is_phone(obj->role);
+}
+
+static pa_volume_t
+_ducked_volume(pa_volume_t volume)
+{
+   return (uint64_t)volume * _duck_level / 100;
+}
+
+static void
+_duck(const Epulse_Object *obj)
+{
+   const Eina_List *l;
+   Duck *duck;
+   Fade *f;
+
+   EINA_LIST_FOREACH(_ducks, l, duck)
+      if (duck->index == obj->index)
+         return;
+
+   duck = calloc(1, sizeof(Duck));
+   EINA_SAFETY_ON_NULL_RETURN(duck);
+   duck->index = obj->index;
+   /* a stream still fading back goes back to where it was heading */
+   f = _fade_find(EPULSE_METER_SINK_INPUT, obj->index);
+   duck->volume = f ? f->to : pa_cvolume_max(&obj->volume);
+   _ducks = eina_list_append(_ducks, duck);
+
+   _fade_add(EPULSE_METER_SINK_INPUT, obj->index,
+             _ducked_volume(duck->volume), _duck_duration,
+             EPULSE_FADE_SMOOTH);
+}
+
+static void
+_unduck(int index)
+{
+   Eina_List *l;
+   Duck *duck;
+
+   EINA_LIST_FOREACH(_ducks, l, duck)
+     {
+        if (duck->index != index)
+           continue;
+
+        _ducks = eina_list_remove_list(_ducks, l);
+        _fade_add(EPULSE_METER_SINK_INPUT, duck->index, duck->volume,
+                  _duck_duration, EPULSE_FADE_SMOOTH);
+        free(duck);
+        return;
+     }
+}
+
+static void
+_unduck_all(void)
+{
+   Duck *duck;
+
+   EINA_LIST_FREE(_ducks, duck)
+     {
+        _fade_add(EPULSE_METER_SINK_INPUT, duck->index, duck->volume,
+                  _duck_duration, EPULSE_FADE_SMOOTH);
+        free(duck);
+     }
+}
+
+/*
+ * Ducks every stream while a phone stream plays and restores them all
+ * once none does. Works from the cached streams, so it can be run again
+ * whenever something that matters changed.
+ */
+void
+_epulse_ducking_update(void)
+{
+   Eina_Hash *inputs = _epulse_objects_get(EPULSE_METER_SINK_INPUT);
+   const Epulse_Object *obj;
+   Eina_Iterator *it;
+   Eina_Bool phone = EINA_FALSE;
+
+   if (_epulse_policies_get() && !_duck_loaded)
+      _duck_level_load();
+
+   if (inputs && _duck_level < 100 && _epulse_policies_get())
+     {
+        it = eina_hash_iterator_data_new(inputs);
+        EINA_ITERATOR_FOREACH(it, obj)
+          {
+             if (_phone_playing(obj))
+               {
+                  phone = EINA_TRUE;
+                  break;
+               }
+          }
+        eina_iterator_free(it);
+     }
+
+   if (!phone)
+     {
+        if (_ducks)
+           DBG("No phone stream playing, restoring the others");
+        _unduck_all();
+        return;
+     }
+
+   it = eina_hash_iterator_data_new(inputs);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (_phone_playing(obj))
+           _unduck(obj->index);
+        else if (!obj->stale)
+           _duck(obj);
+     }
+   eina_iterator_free(it);
+}
+
+/*
+ * Streams play at percent of their volume while a phone stream plays,
+ * 100 turns ducking off. Fades take ms milliseconds. Only has an effect
+ * in the process serving epulse-ctl, which remembers the level.
+ */
+void
+epulse_ducking_set(unsigned int percent, unsigned int ms)
+{
+   const Eina_List *l;
+   Duck *duck;
+
+   if (!_epulse_policies_get())
+     {
+        WRN("Ducking is left to the process serving epulse-ctl");
+        return;
+     }
+
+   percent = percent > 100 ? 100 : percent;
+   _duck_duration = ms;
+   _duck_loaded = EINA_TRUE;
+   if (percent == _duck_level)
+      return;
+
+   _duck_level = percent;
+   _duck_level_save();
+   /* the streams held down now follow the new level */
+   EINA_LIST_FOREACH(_ducks, l, duck)
+      _fade_add(EPULSE_METER_SINK_INPUT, duck->index,
+                _ducked_volume(duck->volume), _duck_duration,
+                EPULSE_FADE_SMOOTH);
+
+   if (_epulse_pa_context_get())
+      _epulse_ducking_update();
+}
+
+/*
+ * Called for every new stream once it is cached.
+ */
+void
+_epulse_duck_stream_added(const Epulse_Event_Sink_Input *ev EINA_UNUSED)
+{
+   _epulse_ducking_update();
+}
+
+/* corking and the role decide whether a stream ducks the others */
+void
+_epulse_duck_stream_changed(const Epulse_Event_Sink_Input *ev)
+{
+   if (ev->base.changed & (EPULSE_CHANGE_CORKED | EPULSE_CHANGE_APP))
+      _epulse_ducking_update();
+}
+
+/*
+ * Called once the stream is gone from the cache.
+ */
+void
+_epulse_duck_stream_removed(int index)
+{
+   Eina_List *l;
+   Duck *duck;
+
+   EINA_LIST_FOREACH(_ducks, l, duck)
+     {
+        if (duck->index == index)
+          {
+             _ducks = eina_list_remove_list(_ducks, l);
+             free(duck);
+             break;
+          }
+     }
+
+   /* the last playing phone stream may be the one that left */
+   if (_ducks)
+      _epulse_ducking_update();
+}
+
+/*
+ * Volumes set by a fade or held down by ducking are not the user's, the
+ * application rules must not learn them.
+ */
+Eina_Bool
+_epulse_fade_owns(Epulse_Meter_Type type, int index)
+{
+   const Eina_List *l;
+   Duck *duck;
+
+   if (_fade_find(type, index))
+      return EINA_TRUE;
+
+   if (type != EPULSE_METER_SINK_INPUT)
+      return EINA_FALSE;
+
+   EINA_LIST_FOREACH(_ducks, l, duck)
+      if (duck->index == index)
+         return EINA_TRUE;
+
+   return EINA_FALSE;
+}
+
+static unsigned int _restoring = 0;
+
+static void
+_duck_restored_cb(pa_context *c EINA_UNUSED, int success,
+                  void *userdata EINA_UNUSED)
+{
+   if (!success)
+      DBG("Could not restore a ducked stream");
+   if (_restoring)
+      _restoring--;
+}
+
+/*
+ * Puts the ducked streams back at their volume before the context goes
+ * away, waiting a moment for the server to take the writes.
+ */
+static void
+_ducks_restore(void)
+{
+   Eina_Hash *inputs = _epulse_objects_get(EPULSE_METER_SINK_INPUT);
+   pa_context *c = _epulse_pa_context_get();
+   const Epulse_Object *obj;
+   pa_operation *o;
+   pa_cvolume cv;
+   double start;
+   Duck *duck;
+
+   EINA_LIST_FREE(_ducks, duck)
+     {
+        obj = inputs ? eina_hash_find(inputs, &duck->index) : NULL;
+        if (c && obj)
+          {
+             cv = obj->volume;
+             pa_cvolume_scale(&cv, duck->volume);
+             o = pa_context_set_sink_input_volume(c, duck->index, &cv,
+                                                  _duck_restored_cb, NULL);
+             if (o)
+               {
+                  _restoring++;
+                  pa_operation_unref(o);
+               }
+          }
+        free(duck);
+     }
+
+   start = ecore_time_get();
+   while (_restoring && ecore_time_get() - start < DUCK_RESTORE_TIMEOUT)
+      ecore_main_loop_iterate();
+   if (_restoring)
+      WRN("%u ducked streams may not have been restored", _restoring);
+   _restoring = 0;
+}
+
+void
+_epulse_fade_shutdown(void)
+{
+   Fade *f;
+
+   if (_timer)
+     {
+        ecore_timer_del(_timer);
+        _timer = NULL;
+     }
+
+   EINA_LIST_FREE(_fades, f)
+      free(f);
+   _ducks_restore();
+   _duck_loaded = EINA_FALSE;
+   _duck_level = DUCK_LEVEL_DEFAULT;
+}
@@ -0,0 +1,265 @@
+#include "epulse_private.h"
+
+#include <math.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#define FFT_ALIGN 16
+#define FFT_MIN_SIZE 16
+#define FFT_MIN_FREQ 20.0f
+
+/*
+ * Real FFT of size n computed as a complex FFT of size n/2 on the
+ * even/odd interleaved samples followed by a split step. The complex
+ * transform is an iterative radix-2 on split real/imaginary arrays so
+ * that four butterflies of the same stage map to one SSE register.
+ */
+struct _Epulse_Fft
+{
+   unsigned int n;
+   unsigned int m;
+   unsigned int *rev;
+
+   /* stage twiddles, the stage with half size h starts at offset h */
+   float *tw_re;
+   float *tw_im;
+
+   /* exp(-2*pi*i*k/n), used to split the half size transform */
+   float *split_re;
+   float *split_im;
+
+   float *window;
+   float *re;
+   float *im;
+};
+
+static float *
+_fft_alloc(unsigned int count)
+{
+   void *mem = NULL;
+
+   if (posix_memalign(&mem, FFT_ALIGN, count * sizeof(float)))
+      return NULL;
+
+   memset(mem, 0, count * sizeof(float));
+   return mem;
+}
+
+void
+epulse_fft_free(Epulse_Fft *fft)
+{
+   if (!fft)
+      return;
+
+   free(fft->rev);
+   free(fft->tw_re);
+   free(fft->tw_im);
+   free(fft->split_re);
+   free(fft->split_im);
+   free(fft->window);
+   free(fft->re);
+   free(fft->im);
+   free(fft);
+}
+
+Epulse_Fft *
+epulse_fft_new(unsigned int size)
+{
+   Epulse_Fft *fft;
+   unsigned int i, h, bits = 0;
+
+   if (size < FFT_MIN_SIZE || (size & (size - 1)))
+     {
+        ERR("FFT size must be a power of two >= %d, got %u",
+            FFT_MIN_SIZE, size);
+        return NULL;
+     }
+
+   fft = calloc(1, sizeof(Epulse_Fft));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(fft, NULL);
+
+   fft->n = size;
+   fft->m = size / 2;
+   while ((1U << bits) < fft->m)
+      bits++;
+
+   fft->rev = malloc(fft->m * sizeof(unsigned int));
+   fft->tw_re = _fft_alloc(2 * fft->m);
+   fft->tw_im = _fft_alloc(2 * fft->m);
+   fft->split_re = _fft_alloc(fft->m);
+   fft->split_im = _fft_alloc(fft->m);
+   fft->window = _fft_alloc(fft->n);
+   fft->re = _fft_alloc(fft->m);
+   fft->im = _fft_alloc(fft->m);
+   if (!fft->rev || !fft->tw_re || !fft->tw_im || !fft->split_re ||
+       !fft->split_im || !fft->window || !fft->re || !fft->im)
+     {
+        epulse_fft_free(fft);
+        return NULL;
+     }
+
+   for (i = 0; i < fft->m; i++)
+     {
+        unsigned int r = 0, v = i, b;
+
+        for (b = 0; b < bits; b++, v >>= 1)
+           r = (r << 1) | (v & 1);
+        fft->rev[i] = r;
+
+        fft->split_re[i] = cos(2.0 * M_PI * i / fft->n);
+        fft->split_im[i] = -sin(2.0 * M_PI * i / fft->n);
+     }
+
+   for (h = 1; h < fft->m; h <<= 1)
+     for (i = 0; i < h; i++)
+       {
+          fft->tw_re[h + i] = cos(M_PI * i / h);
+          fft->tw_im[h + i] = -sin(M_PI * i / h);
+       }
+
+   /* Hann window */
+   for (i = 0; i < fft->n; i++)
+      fft->window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / (fft->n - 1));
+
+   return fft;
+}
+
+unsigned int
+epulse_fft_size_get(const Epulse_Fft *fft)
+{
+   EINA_SAFETY_ON_NULL_RETURN_VAL(fft, 0);
+
+   return fft->n;
+}
+
+static void
+_fft_butterflies(float *restrict re, float *restrict im,
+                 const float *restrict wr, const float *restrict wi,
+                 unsigned int a, unsigned int h)
+{
+   unsigned int j = 0;
+
+#if defined(__SSE__)
+   for (; j + 4 <= h; j += 4)
+     {
+        float *ar = re + a + j, *ai = im + a + j;
+        float *br = ar + h, *bi = ai + h;
+        __m128 w_r = _mm_load_ps(wr + j);
+        __m128 w_i = _mm_load_ps(wi + j);
+        __m128 x_r = _mm_load_ps(br);
+        __m128 x_i = _mm_load_ps(bi);
+        __m128 t_r = _mm_sub_ps(_mm_mul_ps(x_r, w_r), _mm_mul_ps(x_i, w_i));
+        __m128 t_i = _mm_add_ps(_mm_mul_ps(x_r, w_i), _mm_mul_ps(x_i, w_r));
+        __m128 u_r = _mm_load_ps(ar);
+        __m128 u_i = _mm_load_ps(ai);
+
+        _mm_store_ps(br, _mm_sub_ps(u_r, t_r));
+        _mm_store_ps(bi, _mm_sub_ps(u_i, t_i));
+        _mm_store_ps(ar, _mm_add_ps(u_r, t_r));
+        _mm_store_ps(ai, _mm_add_ps(u_i, t_i));
+     }
+#endif
+
+   for (; j < h; j++)
+     {
+        unsigned int x = a + j, y = x + h;
+        float t_r = re[y] * wr[j] - im[y] * wi[j];
+        float t_i = re[y] * wi[j] + im[y] * wr[j];
+
+        re[y] = re[x] - t_r;
+        im[y] = im[x] - t_i;
+        re[x] += t_r;
+        im[x] += t_i;
+     }
+}
+
+/*
+ * Windows n real samples and stores the power of bins 0 .. n/2 - 1.
+ */
+void
+epulse_fft_power(Epulse_Fft *fft, const float *samples, float *power)
+{
+   unsigned int i, h, k, m;
+   float *re, *im;
+
+   EINA_SAFETY_ON_NULL_RETURN(fft);
+   EINA_SAFETY_ON_NULL_RETURN(samples);
+   EINA_SAFETY_ON_NULL_RETURN(power);
+
+   m = fft->m;
+   re = fft->re;
+   im = fft->im;
+
+   for (i = 0; i < m; i++)
+     {
+        re[fft->rev[i]] = samples[2 * i] * fft->window[2 * i];
+        im[fft->rev[i]] = samples[2 * i + 1] * fft->window[2 * i + 1];
+     }
+
+   for (h = 1; h < m; h <<= 1)
+     for (i = 0; i < m; i += 2 * h)
+        _fft_butterflies(re, im, fft->tw_re + h, fft->tw_im + h, i, h);
+
+   for (k = 0; k < m; k++)
+     {
+        unsigned int c = (m - k) & (m - 1);
+        float e_r = 0.5f * (re[k] + re[c]);
+        float e_i = 0.5f * (im[k] - im[c]);
+        float o_r = 0.5f * (im[k] + im[c]);
+        float o_i = -0.5f * (re[k] - re[c]);
+        float x_r = e_r + fft->split_re[k] * o_r - fft->split_im[k] * o_i;
+        float x_i = e_i + fft->split_re[k] * o_i + fft->split_im[k] * o_r;
+
+        power[k] = x_r * x_r + x_i * x_i;
+     }
+}
+
+/*
+ * Maps the power spectrum to nbands log spaced bands between 20Hz and
+ * the Nyquist frequency, each scaled to 0..1 over the range
+ * EPULSE_SPECTRUM_FLOOR_DB .. 0 dBFS.
+ */
+void
+epulse_fft_bands(const Epulse_Fft *fft, const float *power, float rate,
+                 float *bands, unsigned int nbands)
+{
+   float fmin, fmax, ratio, full_scale;
+   unsigned int b, k, lo, hi;
+
+   EINA_SAFETY_ON_NULL_RETURN(fft);
+   EINA_SAFETY_ON_NULL_RETURN(power);
+   EINA_SAFETY_ON_NULL_RETURN(bands);
+
+   fmin = FFT_MIN_FREQ;
+   fmax = rate / 2.0f;
+   ratio = fmax / fmin;
+   /* a full scale sine through a Hann window peaks at n/4 */
+   full_scale = (fft->n / 4.0f) * (fft->n / 4.0f);
+
+   for (b = 0; b < nbands; b++)
+     {
+        float p = 0.0f, db;
+
+        lo = fmin * powf(ratio, (float)b / nbands) * fft->n / rate;
+        hi = fmin * powf(ratio, (float)(b + 1) / nbands) * fft->n / rate;
+        if (hi >= fft->m)
+           hi = fft->m - 1;
+        if (lo > hi)
+           lo = hi;
+
+        for (k = lo; k <= hi; k++)
+           if (power[k] > p)
+              p = power[k];
+
+        db = (p > 0.0f) ? 10.0f * log10f(p / full_scale)
+                        : EPULSE_SPECTRUM_FLOOR_DB;
+        if (db < EPULSE_SPECTRUM_FLOOR_DB)
+           db = EPULSE_SPECTRUM_FLOOR_DB;
+        else if (db > 0.0f)
+           db = 0.0f;
+
+        bands[b] = 1.0f - db / EPULSE_SPECTRUM_FLOOR_DB;
+     }
+}
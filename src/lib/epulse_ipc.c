@@ -0,0 +1,327 @@
+#include "common.h"
+
+#include <stdarg.h>
+#include <Ecore_Con.h>
+
+/*
+ * Line based command channels on per-user local sockets. The process
+ * owning a socket serves it; anyone else (a second epulse, the module,
+ * epulse-ctl) connects, writes a command and either disconnects or
+ * reads the reply lines the server sends back.
+ */
+
+struct _Epulse_Ipc
+{
+   Ecore_Con_Server *server;
+   Epulse_Ipc_Cb cb;
+   const void *data;
+
+   Ecore_Event_Handler *client_data;
+   Ecore_Event_Handler *client_del;
+};
+
+typedef struct _Ipc_Request Ipc_Request;
+struct _Ipc_Request
+{
+   Ecore_Con_Server *server;
+   Epulse_Ipc_Reply_Cb reply;
+   Epulse_Ipc_Done_Cb cb;
+   const void *data;
+   char *command;
+   Eina_Strbuf *buf;
+
+   Ecore_Event_Handler *server_add;
+   Ecore_Event_Handler *server_data;
+   Ecore_Event_Handler *server_del;
+};
+
+/* Removes the first complete line from buf, NULL when there is none */
+static char *
+_ipc_line_take(Eina_Strbuf *buf)
+{
+   const char *str = eina_strbuf_string_get(buf);
+   char *nl, *line;
+   size_t len;
+
+   if (!str || !(nl = strchr(str, '\n')))
+      return NULL;
+
+   len = nl - str;
+   line = strndup(str, len);
+   eina_strbuf_remove(buf, 0, len + 1);
+   if (line && len && line[len - 1] == '\r')
+      line[len - 1] = '\0';
+
+   return line;
+}
+
+static void
+_ipc_lines_dispatch(Epulse_Ipc *ipc, Ecore_Con_Client *client,
+                    Eina_Strbuf *buf)
+{
+   char *line;
+
+   while ((line = _ipc_line_take(buf)))
+     {
+        if (line[0])
+          {
+             DBG("IPC command: %s", line);
+             ipc->cb((void *)ipc->data, (Epulse_Ipc_Client *)client, line);
+          }
+        free(line);
+     }
+}
+
+static Eina_Bool
+_client_data_cb(void *data, int type EINA_UNUSED, void *event)
+{
+   Epulse_Ipc *ipc = data;
+   Ecore_Con_Event_Client_Data *ev = event;
+   Eina_Strbuf *buf;
+
+   if (ecore_con_client_server_get(ev->client) != ipc->server)
+      return ECORE_CALLBACK_PASS_ON;
+
+   buf = ecore_con_client_data_get(ev->client);
+   if (!buf)
+     {
+        buf = eina_strbuf_new();
+        ecore_con_client_data_set(ev->client, buf);
+     }
+
+   eina_strbuf_append_length(buf, ev->data, ev->size);
+   _ipc_lines_dispatch(ipc, ev->client, buf);
+
+   return ECORE_CALLBACK_DONE;
+}
+
+static Eina_Bool
+_client_del_cb(void *data, int type EINA_UNUSED, void *event)
+{
+   Epulse_Ipc *ipc = data;
+   Ecore_Con_Event_Client_Del *ev = event;
+   Eina_Strbuf *buf;
+
+   if (ecore_con_client_server_get(ev->client) != ipc->server)
+      return ECORE_CALLBACK_PASS_ON;
+
+   buf = ecore_con_client_data_get(ev->client);
+   if (buf)
+     {
+        /* a command sent without a trailing newline */
+        eina_strbuf_append_char(buf, '\n');
+        _ipc_lines_dispatch(ipc, NULL, buf);
+        eina_strbuf_free(buf);
+     }
+
+   ecore_con_client_del(ev->client);
+   return ECORE_CALLBACK_DONE;
+}
+
+/*
+ * Returns NULL when the socket is already owned, which means another
+ * instance is running and commands should be sent to it instead.
+ */
+Epulse_Ipc *
+epulse_ipc_server_add(const char *name, Epulse_Ipc_Cb cb, const void *data)
+{
+   Epulse_Ipc *ipc;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(name, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(cb, NULL);
+
+   ipc = calloc(1, sizeof(Epulse_Ipc));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(ipc, NULL);
+
+   ecore_con_init();
+   ipc->server = ecore_con_server_add(ECORE_CON_LOCAL_USER, name, 0, ipc);
+   if (!ipc->server)
+     {
+        INF("IPC socket '%s' is already in use", name);
+        ecore_con_shutdown();
+        free(ipc);
+        return NULL;
+     }
+
+   ipc->cb = cb;
+   ipc->data = data;
+   ipc->client_data = ecore_event_handler_add(ECORE_CON_EVENT_CLIENT_DATA,
+                                              _client_data_cb, ipc);
+   ipc->client_del = ecore_event_handler_add(ECORE_CON_EVENT_CLIENT_DEL,
+                                             _client_del_cb, ipc);
+
+   return ipc;
+}
+
+void
+epulse_ipc_server_del(Epulse_Ipc *ipc)
+{
+   if (!ipc)
+      return;
+
+   ecore_event_handler_del(ipc->client_data);
+   ecore_event_handler_del(ipc->client_del);
+   ecore_con_server_del(ipc->server);
+   free(ipc);
+   ecore_con_shutdown();
+}
+
+/*
+ * Sends one reply line to the client a command came from. Commands
+ * flushed when the client disconnects have no client to reply to.
+ */
+void
+epulse_ipc_reply(Epulse_Ipc_Client *client, const char *fmt, ...)
+{
+   Eina_Strbuf *buf;
+   va_list args;
+
+   if (!client)
+      return;
+
+   buf = eina_strbuf_new();
+   EINA_SAFETY_ON_NULL_RETURN(buf);
+
+   va_start(args, fmt);
+   eina_strbuf_append_vprintf(buf, fmt, args);
+   va_end(args);
+   eina_strbuf_append_char(buf, '\n');
+
+   ecore_con_client_send((Ecore_Con_Client *)client,
+                         eina_strbuf_string_get(buf),
+                         eina_strbuf_length_get(buf));
+   eina_strbuf_free(buf);
+}
+
+static void
+_request_free(Ipc_Request *req, Eina_Bool delivered)
+{
+   ecore_event_handler_del(req->server_add);
+   ecore_event_handler_del(req->server_data);
+   ecore_event_handler_del(req->server_del);
+   if (req->server)
+      ecore_con_server_del(req->server);
+
+   if (req->cb)
+      req->cb((void *)req->data, delivered);
+
+   if (req->buf)
+      eina_strbuf_free(req->buf);
+   free(req->command);
+   free(req);
+   ecore_con_shutdown();
+}
+
+static Eina_Bool
+_server_add_cb(void *data, int type EINA_UNUSED, void *event)
+{
+   Ipc_Request *req = data;
+   Ecore_Con_Event_Server_Add *ev = event;
+
+   if (ev->server != req->server)
+      return ECORE_CALLBACK_PASS_ON;
+
+   ecore_con_server_send(req->server, req->command, strlen(req->command));
+   ecore_con_server_flush(req->server);
+   if (!req->reply)
+      _request_free(req, EINA_TRUE);
+
+   return ECORE_CALLBACK_DONE;
+}
+
+static Eina_Bool
+_server_data_cb(void *data, int type EINA_UNUSED, void *event)
+{
+   Ipc_Request *req = data;
+   Ecore_Con_Event_Server_Data *ev = event;
+   char *line;
+
+   if (ev->server != req->server)
+      return ECORE_CALLBACK_PASS_ON;
+
+   eina_strbuf_append_length(req->buf, ev->data, ev->size);
+   while ((line = _ipc_line_take(req->buf)))
+     {
+        Eina_Bool more = req->reply((void *)req->data, line);
+
+        free(line);
+        if (!more)
+          {
+             _request_free(req, EINA_TRUE);
+             break;
+          }
+     }
+
+   return ECORE_CALLBACK_DONE;
+}
+
+static Eina_Bool
+_server_del_cb(void *data, int type EINA_UNUSED, void *event)
+{
+   Ipc_Request *req = data;
+   Ecore_Con_Event_Server_Del *ev = event;
+
+   if (ev->server != req->server)
+      return ECORE_CALLBACK_PASS_ON;
+
+   DBG("No instance is listening, or it went away before replying");
+   _request_free(req, EINA_FALSE);
+
+   return ECORE_CALLBACK_DONE;
+}
+
+/*
+ * Sends one command to the owner of the socket name. Without a reply
+ * callback the request is done once the command is written; with one,
+ * every reply line is passed to it until it returns EINA_FALSE. cb is
+ * always called, with delivered set to EINA_FALSE when nobody owns the
+ * socket or the connection closed before the reply was complete.
+ */
+void
+epulse_ipc_request(const char *name, const char *command,
+                   Epulse_Ipc_Reply_Cb reply, Epulse_Ipc_Done_Cb cb,
+                   const void *data)
+{
+   Ipc_Request *req;
+
+   EINA_SAFETY_ON_NULL_RETURN(name);
+   EINA_SAFETY_ON_NULL_RETURN(command);
+
+   req = calloc(1, sizeof(Ipc_Request));
+   EINA_SAFETY_ON_NULL_RETURN(req);
+
+   ecore_con_init();
+   req->reply = reply;
+   req->cb = cb;
+   req->data = data;
+   if (asprintf(&req->command, "%s\n", command) < 0)
+      req->command = NULL;
+   if (reply)
+      req->buf = eina_strbuf_new();
+
+   if (req->command && (!reply || req->buf))
+      req->server = ecore_con_server_connect(ECORE_CON_LOCAL_USER,
+                                             name, 0, req);
+   if (!req->server)
+     {
+        _request_free(req, EINA_FALSE);
+        return;
+     }
+
+   req->server_add = ecore_event_handler_add(ECORE_CON_EVENT_SERVER_ADD,
+                                             _server_add_cb, req);
+   if (reply)
+      req->server_data = ecore_event_handler_add(ECORE_CON_EVENT_SERVER_DATA,
+                                                 _server_data_cb, req);
+   req->server_del = ecore_event_handler_add(ECORE_CON_EVENT_SERVER_DEL,
+                                             _server_del_cb, req);
+}
+
+/*
+ * Sends one command to the running mixer.
+ */
+void
+epulse_ipc_send(const char *command, Epulse_Ipc_Done_Cb cb, const void *data)
+{
+   epulse_ipc_request(EPULSE_IPC_NAME, command, NULL, cb, data);
+}
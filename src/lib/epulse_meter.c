@@ -0,0 +1,298 @@
+#include "epulse_private.h"
+
+#include <math.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define METER_KEY "epulse.meter"
+
+struct _Epulse_Meter
+{
+   pa_stream *stream; /* NULL while waiting to start */
+   Epulse_Meter_Type type;
+   int index;
+   Epulse_Meter_Cb cb;
+   const void *data;
+};
+
+static unsigned int _meter_rate = 0;
+static Eina_List *_pending = NULL;
+
+/*
+ * Highest absolute value of a block of float samples. With PEAK_DETECT
+ * every sample the server sends is already the peak of one period, so
+ * this is the peak since the last read; an RMS of those would not be a
+ * signal level and is not computed. The vector paths keep two
+ * accumulators so the loads are not serialized on a single register;
+ * the tail is handled by the scalar loop.
+ */
+float
+epulse_peak_compute(const float *samples, size_t count)
+{
+   float p = 0.0f;
+   size_t i = 0;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(samples, 0.0f);
+
+#if defined(__SSE__)
+   if (count >= 8)
+     {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        __m128 max0 = _mm_setzero_ps(), max1 = _mm_setzero_ps();
+        float tmp[4];
+
+        for (; i + 8 <= count; i += 8)
+          {
+             __m128 a = _mm_loadu_ps(samples + i);
+             __m128 b = _mm_loadu_ps(samples + i + 4);
+
+             max0 = _mm_max_ps(max0, _mm_andnot_ps(sign, a));
+             max1 = _mm_max_ps(max1, _mm_andnot_ps(sign, b));
+          }
+
+        _mm_storeu_ps(tmp, _mm_max_ps(max0, max1));
+        p = fmaxf(fmaxf(tmp[0], tmp[1]), fmaxf(tmp[2], tmp[3]));
+     }
+#elif defined(__ARM_NEON)
+   if (count >= 8)
+     {
+        float32x4_t max0 = vdupq_n_f32(0.0f), max1 = vdupq_n_f32(0.0f);
+        float tmp[4];
+
+        for (; i + 8 <= count; i += 8)
+          {
+             float32x4_t a = vld1q_f32(samples + i);
+             float32x4_t b = vld1q_f32(samples + i + 4);
+
+             max0 = vmaxq_f32(max0, vabsq_f32(a));
+             max1 = vmaxq_f32(max1, vabsq_f32(b));
+          }
+
+        vst1q_f32(tmp, vmaxq_f32(max0, max1));
+        p = fmaxf(fmaxf(tmp[0], tmp[1]), fmaxf(tmp[2], tmp[3]));
+     }
+#endif
+
+   for (; i < count; i++)
+      p = fmaxf(p, fabsf(samples[i]));
+
+   return p;
+}
+
+void
+epulse_meter_rate_set(unsigned int rate)
+{
+   _meter_rate = rate;
+}
+
+unsigned int
+epulse_meter_rate_get(void)
+{
+   if (!_meter_rate)
+     {
+        const char *env = getenv("EPULSE_METER_RATE");
+
+        _meter_rate = env ? (unsigned int)atoi(env) : EPULSE_METER_RATE;
+        if (!_meter_rate)
+           _meter_rate = EPULSE_METER_RATE;
+     }
+
+   return _meter_rate;
+}
+
+static void
+_stream_read_cb(pa_stream *s, size_t length EINA_UNUSED, void *userdata)
+{
+   Epulse_Meter *meter = userdata;
+   const void *data;
+   size_t nbytes;
+   float peak;
+
+   if (pa_stream_peek(s, &data, &nbytes) < 0)
+     {
+        WRN("Failed to read from the meter stream");
+        return;
+     }
+
+   /* A hole in the buffer has no data but still needs to be dropped */
+   if (!data)
+     {
+        if (nbytes)
+           pa_stream_drop(s);
+        return;
+     }
+
+   peak = epulse_peak_compute(data, nbytes / sizeof(float));
+   pa_stream_drop(s);
+
+   meter->cb((void *)meter->data, peak);
+}
+
+static Eina_Bool
+_meter_start(Epulse_Meter *meter)
+{
+   pa_context *context = _epulse_pa_context_get();
+   pa_sample_spec ss;
+   pa_buffer_attr attr;
+   char dev[16];
+   int source;
+
+   source = _epulse_monitor_source_get(meter->type, meter->index);
+   if (!context || source < 0)
+      return EINA_FALSE;
+
+   /* With PEAK_DETECT the server sends one peak value per sample period,
+      so the sample rate is the meter update rate */
+   ss.format = PA_SAMPLE_FLOAT32NE;
+   ss.channels = 1;
+   ss.rate = epulse_meter_rate_get();
+
+   memset(&attr, 0, sizeof(attr));
+   attr.fragsize = sizeof(float);
+   attr.maxlength = (uint32_t)-1;
+
+   meter->stream = pa_stream_new(context, "Peak detect", &ss, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(meter->stream, EINA_FALSE);
+
+   if (meter->type == EPULSE_METER_SINK_INPUT)
+      pa_stream_set_monitor_stream(meter->stream, meter->index);
+
+   pa_stream_set_read_callback(meter->stream, _stream_read_cb, meter);
+
+   snprintf(dev, sizeof(dev), "%d", source);
+   if (pa_stream_connect_record(meter->stream, dev, &attr,
+                                (pa_stream_flags_t)
+                                (PA_STREAM_DONT_MOVE |
+                                 PA_STREAM_PEAK_DETECT |
+                                 PA_STREAM_ADJUST_LATENCY |
+                                 PA_STREAM_DONT_INHIBIT_AUTO_SUSPEND)) < 0)
+     {
+        ERR("pa_stream_connect_record() failed");
+        pa_stream_unref(meter->stream);
+        meter->stream = NULL;
+        return EINA_FALSE;
+     }
+
+   return EINA_TRUE;
+}
+
+/*
+ * Meters asked for before the object list is in sync, like for rows
+ * shown from the state cache, wait and start once it is.
+ */
+Epulse_Meter *
+epulse_meter_add(Epulse_Meter_Type type, int index, Epulse_Meter_Cb cb,
+                 const void *data)
+{
+   Epulse_Meter *meter;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(cb, NULL);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(_epulse_objects_get(type), NULL);
+
+   meter = calloc(1, sizeof(Epulse_Meter));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(meter, NULL);
+
+   meter->type = type;
+   meter->index = index;
+   meter->cb = cb;
+   meter->data = data;
+
+   if (!_epulse_synced_get())
+     {
+        _pending = eina_list_append(_pending, meter);
+        return meter;
+     }
+
+   if (!_meter_start(meter))
+     {
+        free(meter);
+        return NULL;
+     }
+
+   return meter;
+}
+
+void
+epulse_meter_del(Epulse_Meter *meter)
+{
+   if (!meter)
+      return;
+
+   if (!meter->stream)
+     {
+        _pending = eina_list_remove(_pending, meter);
+        free(meter);
+        return;
+     }
+
+   pa_stream_set_read_callback(meter->stream, NULL, NULL);
+   pa_stream_disconnect(meter->stream);
+   pa_stream_unref(meter->stream);
+   free(meter);
+}
+
+/* the object list is in sync, the waiting meters can find their source */
+void
+_epulse_meters_start(void)
+{
+   Epulse_Meter *meter;
+   Eina_List *l, *ll;
+
+   EINA_LIST_FOREACH_SAFE(_pending, l, ll, meter)
+     {
+        _pending = eina_list_remove_list(_pending, l);
+        /* the object is gone, the meter stays at zero until deleted */
+        if (!_meter_start(meter))
+           DBG("No meter for object %d", meter->index);
+     }
+}
+
+void
+_epulse_meter_shutdown(void)
+{
+   _pending = eina_list_free(_pending);
+}
+
+static void
+_meter_widget_cb(void *data, float peak)
+{
+   elm_progressbar_value_set(data, peak > 1.0f ? 1.0 : peak);
+}
+
+static void
+_meter_widget_del_cb(void *data, Evas *e EINA_UNUSED,
+                     Evas_Object *obj EINA_UNUSED,
+                     void *event_info EINA_UNUSED)
+{
+   epulse_meter_del(data);
+}
+
+Evas_Object *
+epulse_meter_widget_add(Evas_Object *parent, Epulse_Meter_Type type,
+                        int index)
+{
+   Evas_Object *bar;
+   Epulse_Meter *meter;
+
+   bar = elm_progressbar_add(parent);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(bar, NULL);
+
+   elm_progressbar_horizontal_set(bar, EINA_TRUE);
+   elm_progressbar_unit_format_set(bar, NULL);
+   elm_progressbar_span_size_set(bar, 120);
+   elm_progressbar_value_set(bar, 0.0);
+
+   meter = epulse_meter_add(type, index, _meter_widget_cb, bar);
+   if (meter)
+     {
+        evas_object_data_set(bar, METER_KEY, meter);
+        evas_object_event_callback_add(bar, EVAS_CALLBACK_DEL,
+                                       _meter_widget_del_cb, meter);
+     }
+
+   return bar;
+}
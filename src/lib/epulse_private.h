@@ -0,0 +1,109 @@
+#ifndef __EPULSE_PRIVATE_H__
+#define __EPULSE_PRIVATE_H__
+
+#include "epulse.h"
+
+/* ecore_thread_wait() came with EFL 1.19 */
+#if ECORE_VERSION_MAJOR > 1 || ECORE_VERSION_MINOR >= 19
+# define EPULSE_THREAD_WAIT 1
+#endif
+
+/* Internal helpers shared between the libepulse translation units */
+
+/* Cached copy of what was last reported to the event consumers */
+typedef struct _Epulse_Object Epulse_Object;
+struct _Epulse_Object {
+   int index;
+   char *name;
+   /* stable across sessions: the server name of sinks and sources, the
+    * application name of sink inputs */
+   char *key;
+   char *icon;
+   pa_cvolume volume;
+   Eina_Bool mute;
+   Eina_Bool corked;
+   /* sink inputs only, see Epulse_Event_Sink_Input */
+   char *binary;
+   char *role;
+   int pid;
+   int sink;
+   int monitor;
+   Eina_List *ports;
+
+   /* loaded from the state cache and not yet confirmed by the server */
+   Eina_Bool stale;
+};
+
+Eina_Bool _epulse_cache_load(Eina_Hash *sinks, Eina_Hash *sink_inputs,
+                             Eina_Hash *sources, int *default_sink);
+Eina_Bool _epulse_cache_save(const Eina_Hash *sinks,
+                             const Eina_Hash *sink_inputs,
+                             const Eina_Hash *sources, int default_sink);
+
+pa_context *_epulse_pa_context_get(void);
+int _epulse_monitor_source_get(Epulse_Meter_Type type, int index);
+/* Epulse_Object hash of the given kind, keyed by index */
+Eina_Hash *_epulse_objects_get(Epulse_Meter_Type type);
+int _epulse_default_sink_get(void);
+/* whether the objects are the server's, not the state cache's */
+Eina_Bool _epulse_synced_get(void);
+/* whether this process runs the rules and ducking, only the epulse-ctl
+ * server does */
+Eina_Bool _epulse_policies_get(void);
+void _epulse_policies_set(Eina_Bool policies);
+/* epulse_sink_input_move() without it counting as the user's choice */
+Eina_Bool _epulse_sink_input_move(int index, int sink_index);
+/* see epulse_meter.c */
+void _epulse_meters_start(void);
+void _epulse_meter_shutdown(void);
+/* server name of the default source */
+const char *_epulse_default_source_get(void);
+void _epulse_object_changed_emit(Epulse_Meter_Type type, int index,
+                                 unsigned int changed);
+Eina_Bool _epulse_object_refresh(Epulse_Meter_Type type, int index,
+                                 void *batch);
+
+/*
+ * Batch bookkeeping, see epulse_batch.c. Setters get an operation handle
+ * from _epulse_batch_op_add() (NULL outside of a batch) and pass it as
+ * the userdata of _epulse_batch_op_cb.
+ */
+void *_epulse_batch_op_add(Epulse_Meter_Type type, int index);
+void _epulse_batch_op_cb(pa_context *c, int success, void *userdata);
+void _epulse_batch_op_done(void *op, Eina_Bool success);
+Eina_Bool _epulse_batch_changed(Epulse_Meter_Type type, int index,
+                                unsigned int changed);
+void _epulse_batch_refresh_done(void *batch);
+void _epulse_batch_cancel(void);
+
+void _epulse_scene_init(void);
+void _epulse_scene_shutdown(void);
+Eina_Bool _epulse_config_path_get(char *buf, size_t size, const char *file,
+                                  Eina_Bool mkdir);
+
+/* Per application volume memory, see epulse_rules.c */
+void _epulse_rules_apply(Epulse_Event_Sink_Input *ev);
+void _epulse_rules_update(const Epulse_Event_Sink_Input *ev);
+void _epulse_rules_user_move(int index);
+void _epulse_rules_shutdown(void);
+
+/* Fades and ducking, see epulse_fade.c */
+void _epulse_duck_stream_added(const Epulse_Event_Sink_Input *ev);
+void _epulse_duck_stream_changed(const Epulse_Event_Sink_Input *ev);
+void _epulse_duck_stream_removed(int index);
+void _epulse_ducking_update(void);
+Eina_Bool _epulse_fade_owns(Epulse_Meter_Type type, int index);
+void _epulse_fade_shutdown(void);
+
+/* Sound cards, see epulse_card.c */
+void _epulse_card_init(void);
+void _epulse_card_shutdown(void);
+void _epulse_cards_clear(void);
+void _epulse_cards_list(pa_context *c);
+void _epulse_card_event(pa_context *c, pa_subscription_event_type_t t,
+                        uint32_t index);
+void _epulse_card_replay(void);
+/* Epulse_Event_Card hash keyed by index, NULL before init */
+Eina_Hash *_epulse_cards_get(void);
+
+#endif /* __EPULSE_PRIVATE_H__ */
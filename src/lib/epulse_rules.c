@@ -0,0 +1,403 @@
+#include "epulse_private.h"
+
+#include <Eet.h>
+#include <Ecore_File.h>
+
+/*
+ * Remembers the volume, mute and sink of every application and applies
+ * them to its new streams before they are announced, so a stream never
+ * starts out at the server's default level.
+ *
+ * Rules are kept in a hash by application name. The file is only read
+ * when the first stream shows up and written a moment after the last
+ * change, from a thread where ecore can wait for one at shutdown.
+ *
+ * Only the process serving epulse-ctl keeps rules. The sink is only
+ * learned from moves the user asked for, not from the server moving
+ * streams around or an output switch.
+ */
+
+#define RULES_FILE "rules.eet"
+#define RULES_ENTRY "rules"
+#define RULES_VERSION 1
+#define RULES_SAVE_DELAY 2.0
+
+typedef struct _Rule Rule;
+struct _Rule
+{
+   const char *app;
+   const char *sink; /* server name, NULL when never moved */
+   unsigned int volume;
+   unsigned char mute;
+};
+
+typedef struct _Rules_File Rules_File;
+struct _Rules_File
+{
+   unsigned int version;
+   Eina_List *rules;
+};
+
+typedef struct _Rules_Write Rules_Write;
+struct _Rules_Write
+{
+   char path[PATH_MAX];
+   void *blob;
+   int size;
+};
+
+static Eina_Hash *_rules = NULL;
+static Eina_Bool _loaded = EINA_FALSE;
+static Eet_Data_Descriptor *_rule_edd = NULL;
+static Eet_Data_Descriptor *_file_edd = NULL;
+static Ecore_Timer *_save_timer = NULL;
+static Ecore_Thread *_save_thread = NULL;
+static Eina_Hash *_user_moves = NULL; /* stream indexes */
+
+static void
+_rule_free_cb(void *data)
+{
+   Rule *rule = data;
+
+   eina_stringshare_del(rule->app);
+   eina_stringshare_del(rule->sink);
+   free(rule);
+}
+
+static void
+_rules_load(void)
+{
+   char path[PATH_MAX];
+   Eet_Data_Descriptor_Class eddc;
+   Rules_File *file = NULL;
+   Eet_File *ef;
+   Rule *rule;
+   double start = ecore_time_get();
+
+   _loaded = EINA_TRUE;
+   eet_init();
+
+   EET_EINA_STREAM_DATA_DESCRIPTOR_CLASS_SET(&eddc, Rule);
+   _rule_edd = eet_data_descriptor_stream_new(&eddc);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_rule_edd, Rule, "app", app, EET_T_STRING);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_rule_edd, Rule, "sink", sink, EET_T_STRING);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_rule_edd, Rule, "volume", volume,
+                                 EET_T_UINT);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_rule_edd, Rule, "mute", mute, EET_T_UCHAR);
+
+   EET_EINA_STREAM_DATA_DESCRIPTOR_CLASS_SET(&eddc, Rules_File);
+   _file_edd = eet_data_descriptor_stream_new(&eddc);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_file_edd, Rules_File, "version", version,
+                                 EET_T_UINT);
+   EET_DATA_DESCRIPTOR_ADD_LIST(_file_edd, Rules_File, "rules", rules,
+                                _rule_edd);
+
+   _rules = eina_hash_string_superfast_new(_rule_free_cb);
+
+   if (!_epulse_config_path_get(path, sizeof(path), RULES_FILE, EINA_FALSE))
+      return;
+
+   ef = eet_open(path, EET_FILE_MODE_READ);
+   if (ef)
+     {
+        file = eet_data_read(ef, _file_edd, RULES_ENTRY);
+        eet_close(ef);
+     }
+
+   if (!file)
+      return;
+
+   EINA_LIST_FREE(file->rules, rule)
+     {
+        if (file->version != RULES_VERSION || !rule->app ||
+            !eina_hash_add(_rules, rule->app, rule))
+           _rule_free_cb(rule);
+     }
+   free(file);
+
+   INF("Loaded %d application rules in %.2f ms",
+       eina_hash_population(_rules), (ecore_time_get() - start) * 1000.0);
+}
+
+static void
+_rules_write(void *data, Ecore_Thread *thread EINA_UNUSED)
+{
+   Rules_Write *w = data;
+   char tmp[PATH_MAX + 16];
+   Eet_File *ef;
+
+   snprintf(tmp, sizeof(tmp), "%s.%d", w->path, getpid());
+   ef = eet_open(tmp, EET_FILE_MODE_WRITE);
+   if (!ef)
+      return;
+
+   eet_write(ef, RULES_ENTRY, w->blob, w->size, EINA_TRUE);
+   eet_close(ef);
+
+   if (rename(tmp, w->path) < 0)
+      ecore_file_unlink(tmp);
+}
+
+static void
+_rules_write_end(void *data, Ecore_Thread *thread)
+{
+   Rules_Write *w = data;
+
+   if (_save_thread == thread)
+      _save_thread = NULL;
+   free(w->blob);
+   free(w);
+}
+
+static Rules_Write *
+_rules_encode(void)
+{
+   Rules_File file = { RULES_VERSION, NULL };
+   Eina_Iterator *it;
+   Rules_Write *w;
+   Rule *rule;
+
+   w = calloc(1, sizeof(Rules_Write));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(w, NULL);
+
+   if (!_epulse_config_path_get(w->path, sizeof(w->path), RULES_FILE,
+                                EINA_TRUE))
+     {
+        free(w);
+        return NULL;
+     }
+
+   it = eina_hash_iterator_data_new(_rules);
+   EINA_ITERATOR_FOREACH(it, rule)
+      file.rules = eina_list_append(file.rules, rule);
+   eina_iterator_free(it);
+
+   w->blob = eet_data_descriptor_encode(_file_edd, &file, &w->size);
+   eina_list_free(file.rules);
+   if (!w->blob)
+     {
+        free(w);
+        return NULL;
+     }
+
+   return w;
+}
+
+static Eina_Bool
+_rules_save_cb(void *data EINA_UNUSED)
+{
+   Rules_Write *w;
+
+   /* one writer at a time, they share the temporary file */
+   if (_save_thread)
+      return ECORE_CALLBACK_RENEW;
+
+   _save_timer = NULL;
+   if (!(w = _rules_encode()))
+      return ECORE_CALLBACK_CANCEL;
+
+#ifdef EPULSE_THREAD_WAIT
+   _save_thread = ecore_thread_run(_rules_write, _rules_write_end,
+                                   _rules_write_end, w);
+#else
+   _rules_write(w, NULL);
+   _rules_write_end(w, NULL);
+#endif
+
+   return ECORE_CALLBACK_CANCEL;
+}
+
+static Rule *
+_rule_find(const char *app)
+{
+   if (!_loaded)
+      _rules_load();
+
+   return eina_hash_find(_rules, app);
+}
+
+static const Epulse_Object *
+_sink_by_key(const char *key)
+{
+   Eina_Hash *sinks = _epulse_objects_get(EPULSE_METER_SINK);
+   const Epulse_Object *obj, *found = NULL;
+   Eina_Iterator *it;
+
+   if (!sinks)
+      return NULL;
+
+   it = eina_hash_iterator_data_new(sinks);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (obj->key && !strcmp(obj->key, key))
+          {
+             found = obj;
+             break;
+          }
+     }
+   eina_iterator_free(it);
+
+   return found;
+}
+
+/*
+ * Called with the event of a new stream before it is cached and
+ * emitted: the event is updated to the remembered state and the
+ * requests to get there are sent.
+ */
+void
+_epulse_rules_apply(Epulse_Event_Sink_Input *ev)
+{
+   const Epulse_Object *sink;
+   double start;
+   Rule *rule;
+
+   if (!ev->app || !_epulse_policies_get())
+      return;
+
+   start = ecore_time_get();
+   rule = _rule_find(ev->app);
+   DBG("Rule lookup for '%s' took %.3f ms, %s", ev->app,
+       (ecore_time_get() - start) * 1000.0, rule ? "found" : "none");
+   if (!rule)
+      return;
+
+   if (pa_cvolume_max(&ev->base.volume) != rule->volume &&
+       pa_cvolume_valid(&ev->base.volume))
+     {
+        pa_cvolume_set(&ev->base.volume, ev->base.volume.channels,
+                       rule->volume);
+        epulse_sink_input_volume_set(ev->base.index, ev->base.volume);
+     }
+
+   if (!!ev->base.mute != !!rule->mute)
+     {
+        ev->base.mute = rule->mute;
+        epulse_sink_input_mute_set(ev->base.index, rule->mute);
+     }
+
+   if (rule->sink && (sink = _sink_by_key(rule->sink)) &&
+       sink->index != ev->sink)
+     {
+        ev->sink = sink->index;
+        _epulse_sink_input_move(ev->base.index, sink->index);
+     }
+}
+
+/*
+ * The stream is being moved on the user's behalf, its next sink change
+ * is what its application should get.
+ */
+void
+_epulse_rules_user_move(int index)
+{
+   if (!_epulse_policies_get())
+      return;
+
+   if (!_user_moves)
+      _user_moves = eina_hash_int32_new(NULL);
+   eina_hash_set(_user_moves, &index, (void *)1);
+}
+
+/*
+ * Called for every stream change, keeps the rule of its application up
+ * to date.
+ */
+void
+_epulse_rules_update(const Epulse_Event_Sink_Input *ev)
+{
+   const Epulse_Object *sink;
+   Eina_Hash *sinks;
+   Rule *rule;
+   pa_volume_t volume;
+   Eina_Bool dirty = EINA_FALSE, moved = EINA_FALSE;
+
+   if (!ev->app || !_epulse_policies_get())
+      return;
+
+   if ((ev->base.changed & EPULSE_CHANGE_SINK) && _user_moves)
+      moved = eina_hash_del_by_key(_user_moves, &ev->base.index);
+
+   if ((!moved &&
+        !(ev->base.changed & (EPULSE_CHANGE_VOLUME | EPULSE_CHANGE_MUTE))) ||
+       _epulse_fade_owns(EPULSE_METER_SINK_INPUT, ev->base.index))
+      return;
+
+   rule = _rule_find(ev->app);
+   if (!rule)
+     {
+        rule = calloc(1, sizeof(Rule));
+        EINA_SAFETY_ON_NULL_RETURN(rule);
+        rule->app = eina_stringshare_add(ev->app);
+        eina_hash_add(_rules, rule->app, rule);
+        dirty = EINA_TRUE;
+     }
+
+   volume = pa_cvolume_max(&ev->base.volume);
+   if (rule->volume != volume || !!rule->mute != !!ev->base.mute)
+     {
+        rule->volume = volume;
+        rule->mute = ev->base.mute;
+        dirty = EINA_TRUE;
+     }
+
+   sinks = moved ? _epulse_objects_get(EPULSE_METER_SINK) : NULL;
+   sink = sinks ? eina_hash_find(sinks, &ev->sink) : NULL;
+   if (sink && sink->key && rule->sink != sink->key &&
+       (!rule->sink || strcmp(rule->sink, sink->key)))
+     {
+        eina_stringshare_replace(&rule->sink, sink->key);
+        dirty = EINA_TRUE;
+     }
+
+   if (!dirty)
+      return;
+
+   if (_save_timer)
+      ecore_timer_reset(_save_timer);
+   else
+      _save_timer = ecore_timer_add(RULES_SAVE_DELAY, _rules_save_cb, NULL);
+}
+
+void
+_epulse_rules_shutdown(void)
+{
+   Rules_Write *w;
+
+   if (_user_moves)
+     {
+        eina_hash_free(_user_moves);
+        _user_moves = NULL;
+     }
+
+   if (!_loaded)
+      return;
+
+   /* the writer uses eet and this code, it must be done before both go
+    * away; a change still pending is then written right here */
+#ifdef EPULSE_THREAD_WAIT
+   if (_save_thread)
+      ecore_thread_wait(_save_thread, 5.0);
+#endif
+
+   if (_save_timer)
+     {
+        ecore_timer_del(_save_timer);
+        _save_timer = NULL;
+        if ((w = _rules_encode()))
+          {
+             _rules_write(w, NULL);
+             free(w->blob);
+             free(w);
+          }
+     }
+
+   eina_hash_free(_rules);
+   _rules = NULL;
+   eet_data_descriptor_free(_rule_edd);
+   eet_data_descriptor_free(_file_edd);
+   _rule_edd = _file_edd = NULL;
+   _loaded = EINA_FALSE;
+
+   eet_shutdown();
+}
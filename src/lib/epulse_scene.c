@@ -0,0 +1,604 @@
+#include "epulse_private.h"
+
+#include <Eet.h>
+#include <Ecore_File.h>
+
+/*
+ * Named snapshots of the mixer: volume, mute and active port of every
+ * sink and source, the default sink and source and which sink each
+ * application plays to. Devices are matched by server name and streams by
+ * application name, so a scene survives restarts and replugging.
+ *
+ * All scenes live in one eet file, one compressed entry per scene, and
+ * applying one issues everything as a single batch.
+ */
+
+#define SCENE_FILE "scenes.eet"
+#define SCENE_VERSION 1
+
+typedef struct _Scene_Device Scene_Device;
+struct _Scene_Device
+{
+   const char *key;
+   int type; /* EPULSE_METER_SINK or EPULSE_METER_SOURCE */
+   unsigned int channels;
+   unsigned int volume[PA_CHANNELS_MAX];
+   unsigned char mute;
+   const char *port;
+};
+
+typedef struct _Scene_Route Scene_Route;
+struct _Scene_Route
+{
+   const char *app;
+   const char *sink;
+};
+
+typedef struct _Scene Scene;
+struct _Scene
+{
+   unsigned int version;
+   const char *default_sink;
+   const char *default_source; /* missing in scenes saved before it */
+   Eina_List *devices;
+   Eina_List *routes;
+};
+
+typedef struct _Scene_Apply Scene_Apply;
+struct _Scene_Apply
+{
+   char *name;
+   double start;
+   Epulse_Batch_Cb cb;
+   const void *data;
+};
+
+static Eet_Data_Descriptor *_scene_edd = NULL;
+static Eet_Data_Descriptor *_device_edd = NULL;
+static Eet_Data_Descriptor *_route_edd = NULL;
+
+void
+_epulse_scene_init(void)
+{
+   Eet_Data_Descriptor_Class eddc;
+
+   eet_init();
+
+   EET_EINA_STREAM_DATA_DESCRIPTOR_CLASS_SET(&eddc, Scene_Device);
+   _device_edd = eet_data_descriptor_stream_new(&eddc);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_device_edd, Scene_Device, "key", key,
+                                 EET_T_STRING);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_device_edd, Scene_Device, "type", type,
+                                 EET_T_INT);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_device_edd, Scene_Device, "channels",
+                                 channels, EET_T_UINT);
+   EET_DATA_DESCRIPTOR_ADD_BASIC_ARRAY(_device_edd, Scene_Device, "volume",
+                                       volume, EET_T_UINT);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_device_edd, Scene_Device, "mute", mute,
+                                 EET_T_UCHAR);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_device_edd, Scene_Device, "port", port,
+                                 EET_T_STRING);
+
+   EET_EINA_STREAM_DATA_DESCRIPTOR_CLASS_SET(&eddc, Scene_Route);
+   _route_edd = eet_data_descriptor_stream_new(&eddc);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_route_edd, Scene_Route, "app", app,
+                                 EET_T_STRING);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_route_edd, Scene_Route, "sink", sink,
+                                 EET_T_STRING);
+
+   EET_EINA_STREAM_DATA_DESCRIPTOR_CLASS_SET(&eddc, Scene);
+   _scene_edd = eet_data_descriptor_stream_new(&eddc);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_scene_edd, Scene, "version", version,
+                                 EET_T_UINT);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_scene_edd, Scene, "default_sink",
+                                 default_sink, EET_T_STRING);
+   EET_DATA_DESCRIPTOR_ADD_BASIC(_scene_edd, Scene, "default_source",
+                                 default_source, EET_T_STRING);
+   EET_DATA_DESCRIPTOR_ADD_LIST(_scene_edd, Scene, "devices", devices,
+                                _device_edd);
+   EET_DATA_DESCRIPTOR_ADD_LIST(_scene_edd, Scene, "routes", routes,
+                                _route_edd);
+}
+
+void
+_epulse_scene_shutdown(void)
+{
+   eet_data_descriptor_free(_scene_edd);
+   eet_data_descriptor_free(_device_edd);
+   eet_data_descriptor_free(_route_edd);
+   _scene_edd = _device_edd = _route_edd = NULL;
+
+   eet_shutdown();
+}
+
+/*
+ * Path of a file in the epulse config directory, which is created when
+ * mkdir is set. Shared with the application rules.
+ */
+Eina_Bool
+_epulse_config_path_get(char *buf, size_t size, const char *file,
+                        Eina_Bool mkdir)
+{
+   const char *base = getenv("XDG_CONFIG_HOME");
+   char dir[PATH_MAX];
+
+   if (base && base[0])
+      snprintf(dir, sizeof(dir), "%s/epulse", base);
+   else if (getenv("HOME"))
+      snprintf(dir, sizeof(dir), "%s/.config/epulse", getenv("HOME"));
+   else
+      return EINA_FALSE;
+
+   if (mkdir && !ecore_file_is_dir(dir) && !ecore_file_mkpath(dir))
+     {
+        WRN("Could not create the config directory %s", dir);
+        return EINA_FALSE;
+     }
+
+   snprintf(buf, size, "%s/%s", dir, file);
+   return EINA_TRUE;
+}
+
+static void
+_scene_device_free(Scene_Device *dev)
+{
+   eina_stringshare_del(dev->key);
+   eina_stringshare_del(dev->port);
+   free(dev);
+}
+
+static void
+_scene_free(Scene *scene)
+{
+   Scene_Device *dev;
+   Scene_Route *route;
+
+   if (!scene)
+      return;
+
+   EINA_LIST_FREE(scene->devices, dev)
+      _scene_device_free(dev);
+
+   EINA_LIST_FREE(scene->routes, route)
+     {
+        eina_stringshare_del(route->app);
+        eina_stringshare_del(route->sink);
+        free(route);
+     }
+
+   eina_stringshare_del(scene->default_sink);
+   eina_stringshare_del(scene->default_source);
+   free(scene);
+}
+
+/*
+ * Drops the devices the file cannot be trusted with: apply indexes
+ * dev->volume by the stored channel count.
+ */
+static void
+_scene_devices_check(Scene *scene, const char *name)
+{
+   Scene_Device *dev;
+   Eina_List *l, *ll;
+
+   EINA_LIST_FOREACH_SAFE(scene->devices, l, ll, dev)
+     {
+        if (dev->key && dev->channels >= 1 &&
+            dev->channels <= PA_CHANNELS_MAX &&
+            (dev->type == EPULSE_METER_SINK ||
+             dev->type == EPULSE_METER_SOURCE))
+           continue;
+
+        WRN("Ignoring broken device '%s' in scene '%s'",
+            dev->key ? dev->key : "(null)", name);
+        scene->devices = eina_list_remove_list(scene->devices, l);
+        _scene_device_free(dev);
+     }
+}
+
+static Scene *
+_scene_load(const char *name)
+{
+   char path[PATH_MAX];
+   Scene *scene;
+   Eet_File *ef;
+
+   if (!_epulse_config_path_get(path, sizeof(path), SCENE_FILE, EINA_FALSE))
+      return NULL;
+
+   ef = eet_open(path, EET_FILE_MODE_READ);
+   if (!ef)
+      return NULL;
+
+   scene = eet_data_read(ef, _scene_edd, name);
+   eet_close(ef);
+
+   if (scene && scene->version != SCENE_VERSION)
+     {
+        WRN("Ignoring scene '%s' with unknown version %u", name,
+            scene->version);
+        _scene_free(scene);
+        return NULL;
+     }
+
+   if (scene)
+      _scene_devices_check(scene, name);
+
+   return scene;
+}
+
+static void
+_scene_devices_add(Scene *scene, Eina_Hash *hash, Epulse_Meter_Type type)
+{
+   Eina_Iterator *it;
+   Epulse_Object *obj;
+   Scene_Device *dev;
+   const Eina_List *l;
+   Port *port;
+   unsigned int i;
+
+   it = eina_hash_iterator_data_new(hash);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (!obj->key || obj->stale)
+           continue;
+
+        dev = calloc(1, sizeof(Scene_Device));
+        if (!dev)
+           break;
+
+        dev->key = eina_stringshare_add(obj->key);
+        dev->type = type;
+        dev->channels = obj->volume.channels;
+        for (i = 0; i < obj->volume.channels; i++)
+           dev->volume[i] = obj->volume.values[i];
+        dev->mute = obj->mute;
+        EINA_LIST_FOREACH(obj->ports, l, port)
+           if (port->active)
+              dev->port = eina_stringshare_add(port->name);
+
+        scene->devices = eina_list_append(scene->devices, dev);
+     }
+   eina_iterator_free(it);
+}
+
+static void
+_scene_routes_add(Scene *scene, Eina_Hash *inputs, Eina_Hash *sinks)
+{
+   Eina_Hash *seen = eina_hash_string_superfast_new(NULL);
+   Epulse_Object *obj, *sink;
+   Eina_Iterator *it;
+   Scene_Route *route;
+
+   it = eina_hash_iterator_data_new(inputs);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        /* one route per application, its first stream decides */
+        if (!obj->key || obj->stale || eina_hash_find(seen, obj->key))
+           continue;
+
+        sink = eina_hash_find(sinks, &obj->sink);
+        if (!sink || !sink->key)
+           continue;
+
+        route = calloc(1, sizeof(Scene_Route));
+        if (!route)
+           break;
+
+        route->app = eina_stringshare_add(obj->key);
+        route->sink = eina_stringshare_add(sink->key);
+        scene->routes = eina_list_append(scene->routes, route);
+        eina_hash_add(seen, obj->key, route);
+     }
+   eina_iterator_free(it);
+   eina_hash_free(seen);
+}
+
+/*
+ * Stores the current state under name, replacing a scene with the same
+ * name.
+ */
+Eina_Bool
+epulse_scene_save(const char *name)
+{
+   Eina_Hash *sinks = _epulse_objects_get(EPULSE_METER_SINK);
+   int default_sink = _epulse_default_sink_get();
+   const char *default_source = _epulse_default_source_get();
+   Epulse_Object *obj;
+   char path[PATH_MAX];
+   Eina_Bool ret;
+   Scene *scene;
+   Eet_File *ef;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(name, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(sinks, EINA_FALSE);
+
+   if (!_epulse_config_path_get(path, sizeof(path), SCENE_FILE, EINA_TRUE))
+      return EINA_FALSE;
+
+   scene = calloc(1, sizeof(Scene));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(scene, EINA_FALSE);
+
+   scene->version = SCENE_VERSION;
+   _scene_devices_add(scene, sinks, EPULSE_METER_SINK);
+   _scene_devices_add(scene, _epulse_objects_get(EPULSE_METER_SOURCE),
+                      EPULSE_METER_SOURCE);
+   _scene_routes_add(scene, _epulse_objects_get(EPULSE_METER_SINK_INPUT),
+                     sinks);
+   obj = eina_hash_find(sinks, &default_sink);
+   if (obj && obj->key)
+      scene->default_sink = eina_stringshare_add(obj->key);
+   if (default_source)
+      scene->default_source = eina_stringshare_add(default_source);
+
+   ef = eet_open(path, EET_FILE_MODE_READ_WRITE);
+   if (!ef)
+     {
+        WRN("Could not open the scene file %s", path);
+        _scene_free(scene);
+        return EINA_FALSE;
+     }
+
+   ret = eet_data_write(ef, _scene_edd, name, scene, EINA_TRUE) > 0;
+   eet_close(ef);
+
+   DBG("Scene '%s' saved: %u devices, %u routes", name,
+       eina_list_count(scene->devices), eina_list_count(scene->routes));
+   _scene_free(scene);
+
+   return ret;
+}
+
+Eina_Bool
+epulse_scene_del(const char *name)
+{
+   char path[PATH_MAX];
+   Eina_Bool ret;
+   Eet_File *ef;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(name, EINA_FALSE);
+
+   if (!_epulse_config_path_get(path, sizeof(path), SCENE_FILE, EINA_FALSE))
+      return EINA_FALSE;
+
+   ef = eet_open(path, EET_FILE_MODE_READ_WRITE);
+   if (!ef)
+      return EINA_FALSE;
+
+   ret = eet_delete(ef, name);
+   eet_close(ef);
+
+   return ret;
+}
+
+/*
+ * Returns the names of the saved scenes as stringshares.
+ */
+Eina_List *
+epulse_scene_list(void)
+{
+   Eina_List *names = NULL;
+   char path[PATH_MAX];
+   char **keys;
+   Eet_File *ef;
+   int i, count = 0;
+
+   if (!_epulse_config_path_get(path, sizeof(path), SCENE_FILE, EINA_FALSE))
+      return NULL;
+
+   ef = eet_open(path, EET_FILE_MODE_READ);
+   if (!ef)
+      return NULL;
+
+   keys = eet_list(ef, "*", &count);
+   for (i = 0; i < count; i++)
+      names = eina_list_sorted_insert(names, EINA_COMPARE_CB(strcmp),
+                                      eina_stringshare_add(keys[i]));
+   free(keys);
+   eet_close(ef);
+
+   return names;
+}
+
+static Eina_Hash *
+_key_index_new(Eina_Hash *objects)
+{
+   Eina_Hash *index = eina_hash_string_superfast_new(NULL);
+   Eina_Iterator *it;
+   Epulse_Object *obj;
+
+   it = eina_hash_iterator_data_new(objects);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        /* stale objects are on their way out, like when saving */
+        if (obj->key && !obj->stale && !eina_hash_find(index, obj->key))
+           eina_hash_add(index, obj->key, obj);
+     }
+   eina_iterator_free(it);
+
+   return index;
+}
+
+/* application name to the list of its streams */
+static Eina_Hash *
+_app_index_new(Eina_Hash *inputs)
+{
+   Eina_Hash *index;
+   Eina_Iterator *it;
+   Epulse_Object *obj;
+   Eina_List *streams;
+
+   index = eina_hash_string_superfast_new(EINA_FREE_CB(eina_list_free));
+   it = eina_hash_iterator_data_new(inputs);
+   EINA_ITERATOR_FOREACH(it, obj)
+     {
+        if (!obj->key || obj->stale)
+           continue;
+
+        streams = eina_hash_find(index, obj->key);
+        if (streams)
+           eina_hash_modify(index, obj->key,
+                            eina_list_append(streams, obj));
+        else
+           eina_hash_add(index, obj->key, eina_list_append(NULL, obj));
+     }
+   eina_iterator_free(it);
+
+   return index;
+}
+
+static void
+_scene_device_apply(const Scene_Device *dev, const Epulse_Object *obj)
+{
+   pa_cvolume volume;
+   unsigned int i;
+   const Eina_List *l;
+   Port *port;
+
+   if (dev->channels == obj->volume.channels)
+     {
+        volume.channels = dev->channels;
+        for (i = 0; i < dev->channels; i++)
+           volume.values[i] = dev->volume[i];
+     }
+   else
+     {
+        /* the channel map changed, keep the level and drop the balance */
+        pa_volume_t sum = 0;
+
+        for (i = 0; i < dev->channels; i++)
+           sum += dev->volume[i] / dev->channels;
+        pa_cvolume_set(&volume, obj->volume.channels, sum);
+     }
+
+   if (pa_cvolume_valid(&volume) && !pa_cvolume_equal(&volume, &obj->volume))
+     {
+        if (dev->type == EPULSE_METER_SINK)
+           epulse_sink_volume_set(obj->index, volume);
+        else
+           epulse_source_volume_set(obj->index, volume);
+     }
+
+   if (!!dev->mute != !!obj->mute)
+     {
+        if (dev->type == EPULSE_METER_SINK)
+           epulse_sink_mute_set(obj->index, dev->mute);
+        else
+           epulse_source_mute_set(obj->index, dev->mute);
+     }
+
+   if (dev->type != EPULSE_METER_SINK || !dev->port)
+      return;
+
+   EINA_LIST_FOREACH(obj->ports, l, port)
+     {
+        if (!port->name || strcmp(port->name, dev->port))
+           continue;
+        if (!port->active)
+           epulse_sink_port_set(obj->index, dev->port);
+        break;
+     }
+}
+
+static void
+_scene_applied_cb(void *data, const Eina_Bool *status, unsigned int count)
+{
+   Scene_Apply *apply = data;
+   unsigned int i, failed = 0;
+
+   for (i = 0; i < count; i++)
+      if (!status[i])
+         failed++;
+
+   INF("Scene '%s' applied in %.2f ms: %u operations, %u failed",
+       apply->name, (ecore_time_get() - apply->start) * 1000.0, count,
+       failed);
+
+   if (apply->cb)
+      apply->cb((void *)apply->data, status, count);
+   free(apply->name);
+   free(apply);
+}
+
+/*
+ * Applies a saved scene as one batch, cb gets the batch status once
+ * everything landed. Devices and applications missing now are skipped.
+ */
+Eina_Bool
+epulse_scene_apply(const char *name, Epulse_Batch_Cb cb, const void *data)
+{
+   Eina_Hash *sinks, *sources, *apps;
+   const Epulse_Object *obj, *sink, *source;
+   const char *default_source;
+   const Scene_Device *dev;
+   const Scene_Route *route;
+   const Eina_List *l, *ll;
+   Scene_Apply *apply;
+   Scene *scene;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(name, EINA_FALSE);
+
+   if (!_epulse_pa_context_get())
+      return EINA_FALSE;
+
+   scene = _scene_load(name);
+   if (!scene)
+     {
+        WRN("No scene named '%s'", name);
+        return EINA_FALSE;
+     }
+
+   apply = calloc(1, sizeof(Scene_Apply));
+   if (!apply || !epulse_batch_begin())
+     {
+        free(apply);
+        _scene_free(scene);
+        return EINA_FALSE;
+     }
+
+   apply->name = strdup(name);
+   apply->start = ecore_time_get();
+   apply->cb = cb;
+   apply->data = data;
+
+   /* every rule is a lookup instead of a walk over the objects */
+   sinks = _key_index_new(_epulse_objects_get(EPULSE_METER_SINK));
+   sources = _key_index_new(_epulse_objects_get(EPULSE_METER_SOURCE));
+   apps = _app_index_new(_epulse_objects_get(EPULSE_METER_SINK_INPUT));
+
+   EINA_LIST_FOREACH(scene->devices, l, dev)
+     {
+        obj = eina_hash_find(dev->type == EPULSE_METER_SINK ? sinks : sources,
+                             dev->key);
+        if (obj)
+           _scene_device_apply(dev, obj);
+     }
+
+   if (scene->default_sink &&
+       (sink = eina_hash_find(sinks, scene->default_sink)) &&
+       sink->index != _epulse_default_sink_get())
+      epulse_sink_default_set(sink->index);
+
+   default_source = _epulse_default_source_get();
+   if (scene->default_source &&
+       (source = eina_hash_find(sources, scene->default_source)) &&
+       (!default_source || strcmp(default_source, source->key)))
+      epulse_source_default_set(source->index);
+
+   EINA_LIST_FOREACH(scene->routes, l, route)
+     {
+        if (!(sink = eina_hash_find(sinks, route->sink)))
+           continue;
+
+        EINA_LIST_FOREACH(eina_hash_find(apps, route->app), ll, obj)
+           if (obj->sink != sink->index)
+              _epulse_sink_input_move(obj->index, sink->index);
+     }
+
+   eina_hash_free(sinks);
+   eina_hash_free(sources);
+   eina_hash_free(apps);
+   _scene_free(scene);
+
+   return epulse_batch_commit(_scene_applied_cb, apply);
+}
@@ -0,0 +1,209 @@
+#include "epulse_private.h"
+
+/*
+ * Records mono float samples from a source (or a sink monitor), decimates
+ * them with a box filter and keeps the latest fft_size samples in a ring.
+ * The transform only runs when the consumer asks for bands, so nothing is
+ * computed between redraws.
+ */
+struct _Epulse_Spectrum
+{
+   pa_stream *stream;
+   Epulse_Fft *fft;
+
+   float *ring;
+   float *frame;
+   float *power;
+   unsigned int size;
+   unsigned int pos;
+
+   unsigned int decimation;
+   float acc;
+   unsigned int acc_n;
+
+   Eina_Bool dirty;
+   Eina_Bool paused;
+};
+
+static void
+_spectrum_push(Epulse_Spectrum *spectrum, const float *samples, size_t count)
+{
+   float acc = spectrum->acc;
+   unsigned int acc_n = spectrum->acc_n;
+   size_t i;
+
+   for (i = 0; i < count; i++)
+     {
+        acc += samples[i];
+        if (++acc_n < spectrum->decimation)
+           continue;
+
+        spectrum->ring[spectrum->pos] = acc / acc_n;
+        spectrum->pos = (spectrum->pos + 1) & (spectrum->size - 1);
+        acc = 0.0f;
+        acc_n = 0;
+     }
+
+   spectrum->acc = acc;
+   spectrum->acc_n = acc_n;
+   spectrum->dirty = EINA_TRUE;
+}
+
+static void
+_stream_read_cb(pa_stream *s, size_t length EINA_UNUSED, void *userdata)
+{
+   Epulse_Spectrum *spectrum = userdata;
+   const void *data;
+   size_t nbytes;
+
+   while (pa_stream_readable_size(s) > 0)
+     {
+        if (pa_stream_peek(s, &data, &nbytes) < 0)
+          {
+             WRN("Failed to read from the spectrum stream");
+             return;
+          }
+
+        if (!nbytes)
+           break;
+
+        if (data)
+           _spectrum_push(spectrum, data, nbytes / sizeof(float));
+        pa_stream_drop(s);
+     }
+}
+
+Epulse_Spectrum *
+epulse_spectrum_add(Epulse_Meter_Type type, int index, unsigned int fft_size)
+{
+   Epulse_Spectrum *spectrum;
+   pa_context *context = _epulse_pa_context_get();
+   pa_sample_spec ss;
+   pa_buffer_attr attr;
+   char dev[16];
+   int source;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(context, NULL);
+
+   source = _epulse_monitor_source_get(type, index);
+   if (source < 0)
+      return NULL;
+
+   spectrum = calloc(1, sizeof(Epulse_Spectrum));
+   EINA_SAFETY_ON_NULL_RETURN_VAL(spectrum, NULL);
+
+   spectrum->fft = epulse_fft_new(fft_size);
+   EINA_SAFETY_ON_NULL_GOTO(spectrum->fft, err);
+
+   spectrum->size = fft_size;
+   spectrum->decimation = EPULSE_SPECTRUM_DECIMATION;
+   spectrum->ring = calloc(fft_size, sizeof(float));
+   spectrum->frame = calloc(fft_size, sizeof(float));
+   spectrum->power = calloc(fft_size / 2, sizeof(float));
+   if (!spectrum->ring || !spectrum->frame || !spectrum->power)
+      goto err;
+
+   ss.format = PA_SAMPLE_FLOAT32NE;
+   ss.channels = 1;
+   ss.rate = EPULSE_SPECTRUM_RATE;
+
+   /* deliver roughly a quarter of a window per fragment */
+   memset(&attr, 0, sizeof(attr));
+   attr.maxlength = (uint32_t)-1;
+   attr.fragsize = fft_size / 4 * spectrum->decimation * sizeof(float);
+
+   spectrum->stream = pa_stream_new(context, "Spectrum", &ss, NULL);
+   EINA_SAFETY_ON_NULL_GOTO(spectrum->stream, err);
+
+   if (type == EPULSE_METER_SINK_INPUT)
+      pa_stream_set_monitor_stream(spectrum->stream, index);
+
+   pa_stream_set_read_callback(spectrum->stream, _stream_read_cb, spectrum);
+
+   snprintf(dev, sizeof(dev), "%d", source);
+   if (pa_stream_connect_record(spectrum->stream, dev, &attr,
+                                (pa_stream_flags_t)
+                                (PA_STREAM_DONT_MOVE |
+                                 PA_STREAM_ADJUST_LATENCY |
+                                 PA_STREAM_DONT_INHIBIT_AUTO_SUSPEND)) < 0)
+     {
+        ERR("pa_stream_connect_record() failed");
+        goto err;
+     }
+
+   return spectrum;
+
+ err:
+   epulse_spectrum_del(spectrum);
+   return NULL;
+}
+
+void
+epulse_spectrum_del(Epulse_Spectrum *spectrum)
+{
+   if (!spectrum)
+      return;
+
+   if (spectrum->stream)
+     {
+        pa_stream_set_read_callback(spectrum->stream, NULL, NULL);
+        pa_stream_disconnect(spectrum->stream);
+        pa_stream_unref(spectrum->stream);
+     }
+
+   epulse_fft_free(spectrum->fft);
+   free(spectrum->ring);
+   free(spectrum->frame);
+   free(spectrum->power);
+   free(spectrum);
+}
+
+void
+epulse_spectrum_pause_set(Epulse_Spectrum *spectrum, Eina_Bool pause)
+{
+   pa_operation *o;
+
+   EINA_SAFETY_ON_NULL_RETURN(spectrum);
+
+   if (spectrum->paused == !!pause)
+      return;
+
+   spectrum->paused = !!pause;
+   if (pa_stream_get_state(spectrum->stream) != PA_STREAM_READY)
+      return;
+
+   if ((o = pa_stream_cork(spectrum->stream, spectrum->paused, NULL, NULL)))
+      pa_operation_unref(o);
+}
+
+/*
+ * Returns EINA_FALSE when no samples arrived since the previous call, in
+ * which case bands is left untouched and the caller can skip the redraw.
+ */
+Eina_Bool
+epulse_spectrum_bands_get(Epulse_Spectrum *spectrum, float *bands,
+                          unsigned int nbands)
+{
+   unsigned int tail;
+
+   EINA_SAFETY_ON_NULL_RETURN_VAL(spectrum, EINA_FALSE);
+   EINA_SAFETY_ON_NULL_RETURN_VAL(bands, EINA_FALSE);
+
+   if (!spectrum->dirty)
+      return EINA_FALSE;
+
+   /* unroll the ring so the oldest sample comes first */
+   tail = spectrum->size - spectrum->pos;
+   memcpy(spectrum->frame, spectrum->ring + spectrum->pos,
+          tail * sizeof(float));
+   memcpy(spectrum->frame + tail, spectrum->ring,
+          spectrum->pos * sizeof(float));
+
+   epulse_fft_power(spectrum->fft, spectrum->frame, spectrum->power);
+   epulse_fft_bands(spectrum->fft, spectrum->power,
+                    (float)EPULSE_SPECTRUM_RATE / spectrum->decimation,
+                    bands, nbands);
+   spectrum->dirty = EINA_FALSE;
+
+   return EINA_TRUE;
+}
@@ -4,12 +4,24 @@
 #include <Ecore.h>
 #include <epulse.h>
 #include "e_mod_main.h"
+#if E_VERSION_MAJOR >= 20
+#include "main_window.h"
+#include "icon_cache.h"
+#endif
 #ifdef HAVE_ENOTIFY
 #include <E_Notify.h>
 #endif
 
 //~ #define VOLUME_STEP (PA_VOLUME_NORM / BASE_VOLUME_STEP)
 #define VOLUME_STEP (PA_VOLUME_NORM / 100 * 5) // volume step set up to 5%
+#define CONNECT_FALLBACK 5.0 // seconds to wait for the end of E's startup
+#define CONNECT_RETRY 2.0 // seconds before trying again when connecting failed
+#define GADGET_RATE 30.0 // max gadget redraws per second
+#define OSD_TIMEOUT 1.5 // seconds the volume OSD stays after the last change
+#define NOTIFY_DEBOUNCE 0.5 // quiet time before the fallback notification
+#define STEP_REPEAT 0.3 // steps closer than this are part of one gesture
+#define STEP_ACCEL_MAX 3.0 // largest step, in VOLUME_STEPs, when held
+#define STEP_ACCEL_RAMP 10 // repeated steps needed to reach the largest one
 
 /* module requirements */
 EAPI E_Module_Api e_modapi =
@@ -51,12 +63,53 @@ struct _Sink {
    char *name;
 };
 
+/* What a gadget displays, compared to skip redundant messages */
+typedef struct _Gadget_State Gadget_State;
+struct _Gadget_State {
+   int mute;
+   int left;
+   int right;
+};
+
 typedef struct _Context Context;
 struct _Context
 {
    char *theme;
    Ecore_Exe *epulse;
+   Ecore_Event_Handler *connected_handler;
    Ecore_Event_Handler *disconnected_handler;
+   Ecore_Event_Handler *init_end_handler;
+   Ecore_Timer *connect_timer;
+   Epulse_Ipc *ctl;
+   double connect_time;
+   Ecore_Timer *gadget_timer;
+   double gadget_last;
+   unsigned int gadget_sent;
+   unsigned int gadget_suppressed;
+
+   struct {
+      Evas_Object *obj;
+#if E_VERSION_MAJOR >= 20
+      Evas_Object *comp;
+#else
+      E_Popup *popup;
+#endif
+      Ecore_Timer *timer;
+      Eina_Bool failed;
+   } osd;
+
+   Ecore_Timer *notify_timer;
+   int notify_val;
+
+   /* volume predicted from the steps not yet confirmed by the server */
+   struct {
+      pa_cvolume target;
+      int sink;
+      int direction;
+      unsigned int repeat;
+      double last;
+      Ecore_Animator *flush;
+   } step;
    Ecore_Event_Handler *epulse_event_handler;
    Ecore_Event_Handler *sink_default_handler;
    Ecore_Event_Handler *sink_changed_handler;
@@ -68,6 +121,9 @@ struct _Context
    Eina_List *sinks;
    E_Menu *menu;
    unsigned int notification_id;
+#if E_VERSION_MAJOR >= 20
+   E_Dialog *dialog;
+#endif
 
    struct {
       E_Action *incr;
@@ -83,12 +139,20 @@ struct _Instance
    E_Gadcon_Orient orient;
 
    E_Gadcon_Popup *popup;
+   Evas *popup_evas;
+   Eina_Bool popup_visible;
+   Eina_Bool popup_built;
+   double popup_open;
    Evas_Object *gadget;
    Evas_Object *list;
    Evas_Object *slider;
    Evas_Object *check;
+   Epulse_Throttle *throttle;
 	Ecore_Timer *popup_timer;   
 
+   Gadget_State shown;
+   Eina_Bool shown_valid;
+
    int mute;
    
     struct
@@ -115,19 +179,20 @@ static void				_mixer_popup_input_window_create(Instance *inst);
 static void				_mixer_popup_input_window_destroy(Instance *inst);
 static Context *mixer_context = NULL;
 
-static void
-_notify(const int val)
+static Eina_Bool
+_notify_timer_cb(void *data EINA_UNUSED)
 {
-   if (val < 0)
-     return;
 #ifdef HAVE_ENOTIFY
-   static E_Notification *n;
-   char *icon, buf[56];
-   int ret;
+   E_Notification *n;
+   const char *icon;
+   char buf[56];
+   int ret, val = mixer_context->notify_val;
+
+   mixer_context->notify_timer = NULL;
 
    ret = snprintf(buf, (sizeof(buf) - 1), "%s: %d%%", _("New volume"), val);
    if ((ret < 0) || ((unsigned int)ret > sizeof(buf)))
-     return;
+     return ECORE_CALLBACK_CANCEL;
    //Names are taken from FDO icon naming scheme
    if (val == 0)
      icon = "audio-volume-muted";
@@ -137,58 +202,432 @@ _notify(const int val)
      icon = "audio-volume-low";
    else
      icon = "audio-volume-high";
-   if (n) return;
    n = e_notification_full_new(_("EPulse"), 0, icon, _("Volume Changed"), buf, 2000);
    e_notification_replaces_id_set(n, EINA_TRUE);
    e_notification_send(n, NULL, NULL);
    e_notification_unref(n);
-   n = NULL;
+#else
+   mixer_context->notify_timer = NULL;
+#endif
+   return ECORE_CALLBACK_CANCEL;
+}
+
+/*
+ * Fallback when the OSD is not available: one notification once the
+ * volume settles instead of one D-Bus call per step.
+ */
+static void
+_notify_schedule(int val)
+{
+   mixer_context->notify_val = val;
+   if (mixer_context->notify_timer)
+      ecore_timer_reset(mixer_context->notify_timer);
+   else
+      mixer_context->notify_timer =
+         ecore_timer_add(NOTIFY_DEBOUNCE, _notify_timer_cb, NULL);
+}
+
+static Eina_Bool
+_osd_timer_cb(void *data EINA_UNUSED)
+{
+   mixer_context->osd.timer = NULL;
+#if E_VERSION_MAJOR >= 20
+   evas_object_hide(mixer_context->osd.comp);
+#else
+   e_popup_hide(mixer_context->osd.popup);
+#endif
+   return ECORE_CALLBACK_CANCEL;
+}
+
+/*
+ * The OSD is created on first use and then only updated, moved to the
+ * current zone and shown again.
+ */
+static Eina_Bool
+_osd_create(void)
+{
+   Evas_Object *o;
+#if E_VERSION_MAJOR >= 20
+   o = edje_object_add(e_comp->evas);
+#else
+   E_Zone *zone = e_util_zone_current_get(e_manager_current_get());
+
+   mixer_context->osd.popup = e_popup_new(zone, 0, 0, 1, 1);
+   if (!mixer_context->osd.popup)
+      return EINA_FALSE;
+   e_popup_layer_set(mixer_context->osd.popup, 255);
+   o = edje_object_add(mixer_context->osd.popup->evas);
+#endif
+
+   if (!edje_object_file_set(o, mixer_context->theme, "e/modules/mixer/osd"))
+     {
+        WRN("No OSD group in %s", mixer_context->theme);
+        evas_object_del(o);
+#if E_VERSION_MAJOR < 20
+        e_object_del(E_OBJECT(mixer_context->osd.popup));
+        mixer_context->osd.popup = NULL;
 #endif
+        return EINA_FALSE;
+     }
+   evas_object_pass_events_set(o, EINA_TRUE);
+   mixer_context->osd.obj = o;
+
+#if E_VERSION_MAJOR >= 20
+   mixer_context->osd.comp = e_comp_object_util_add(o, E_COMP_OBJECT_TYPE_POPUP);
+   evas_object_layer_set(mixer_context->osd.comp, E_LAYER_POPUP);
+   evas_object_pass_events_set(mixer_context->osd.comp, EINA_TRUE);
+#else
+   e_popup_edje_bg_object_set(mixer_context->osd.popup, o);
+   evas_object_show(o);
+#endif
+
+   return EINA_TRUE;
 }
 
+static void
+_osd_del(void)
+{
+   if (mixer_context->osd.timer)
+     {
+        ecore_timer_del(mixer_context->osd.timer);
+        mixer_context->osd.timer = NULL;
+     }
+#if E_VERSION_MAJOR >= 20
+   if (mixer_context->osd.comp)
+      evas_object_del(mixer_context->osd.comp);
+   mixer_context->osd.comp = NULL;
+#else
+   if (mixer_context->osd.popup)
+      e_object_del(E_OBJECT(mixer_context->osd.popup));
+   mixer_context->osd.popup = NULL;
+#endif
+   mixer_context->osd.obj = NULL;
+}
+
+static Eina_Bool
+_osd_show(int val, Eina_Bool mute)
+{
+   E_Zone *zone;
+   Evas_Coord w, h, x, y;
+   char buf[32];
+
+   if (mixer_context->osd.failed)
+      return EINA_FALSE;
+
+#if E_VERSION_MAJOR < 20
+   /* popups belong to a zone, follow the pointer to another screen */
+   zone = e_util_zone_current_get(e_manager_current_get());
+   if (mixer_context->osd.popup && mixer_context->osd.popup->zone != zone)
+      _osd_del();
+#endif
+
+   if (!mixer_context->osd.obj && !_osd_create())
+     {
+        mixer_context->osd.failed = EINA_TRUE;
+        return EINA_FALSE;
+     }
+
+   snprintf(buf, sizeof(buf), "%d%%", val);
+   edje_object_part_text_set(mixer_context->osd.obj, "e.text.label", buf);
+   edje_object_part_drag_value_set(mixer_context->osd.obj, "e.dragable.level",
+                                   val / 100.0, 0.0);
+   edje_object_signal_emit(mixer_context->osd.obj,
+                           mute ? "e,state,mute" : "e,state,unmute", "e");
+   edje_object_message_signal_process(mixer_context->osd.obj);
+   edje_object_size_min_calc(mixer_context->osd.obj, &w, &h);
+
+#if E_VERSION_MAJOR >= 20
+   zone = e_zone_current_get();
+   x = zone->x + (zone->w - w) / 2;
+   y = zone->y + zone->h - h - zone->h / 8;
+   evas_object_geometry_set(mixer_context->osd.comp, x, y, w, h);
+   evas_object_show(mixer_context->osd.comp);
+#else
+   zone = e_util_zone_current_get(e_manager_current_get());
+   x = (zone->w - w) / 2;
+   y = zone->h - h - zone->h / 8;
+   e_popup_move_resize(mixer_context->osd.popup, x, y, w, h);
+   evas_object_resize(mixer_context->osd.obj, w, h);
+   e_popup_show(mixer_context->osd.popup);
+#endif
+
+   if (mixer_context->osd.timer)
+      ecore_timer_reset(mixer_context->osd.timer);
+   else
+      mixer_context->osd.timer = ecore_timer_add(OSD_TIMEOUT, _osd_timer_cb,
+                                                 NULL);
+   return EINA_TRUE;
+}
+
+static void
+_notify(const int val, Eina_Bool mute)
+{
+   if (val < 0)
+     return;
+
+   if (_osd_show(val, mute))
+      return;
+
+   _notify_schedule(mute ? 0 : val);
+}
+
+static void _popup_hide(Instance *inst);
+
 static void
 _mixer_popup_update(Instance *inst, int mute, int vol)
 {
    e_widget_check_checked_set(inst->check, mute);
-   e_slider_value_set(inst->slider, vol);
+   if (!inst->throttle || !epulse_throttle_busy_get(inst->throttle))
+      e_slider_value_set(inst->slider, vol);
 }
 
-static void _popup_del(Instance *inst);
+static void
+_mixer_gadget_state_get(Gadget_State *st)
+{
+   if (!mixer_context->sink_default)
+     {
+        st->mute = EINA_FALSE;
+        st->left = 0;
+        st->right = 0;
+     }
+   else
+     {
+        pa_volume_t vol =
+           pa_cvolume_avg(&mixer_context->sink_default->volume);
+        st->mute = mixer_context->sink_default->mute;
+        st->left = PA_VOLUME_TO_INT(vol);
+        st->right = st->left;
+     }
+}
 
 static void
-_mixer_gadget_update(void)
+_mixer_gadget_send(Instance *inst, const Gadget_State *st)
 {
    Edje_Message_Int_Set *msg;
+
+   if (inst->shown_valid &&
+       !memcmp(&inst->shown, st, sizeof(Gadget_State)))
+     {
+        mixer_context->gadget_suppressed++;
+        return;
+     }
+
+   msg = alloca(sizeof(Edje_Message_Int_Set) + (2 * sizeof(int)));
+   msg->count = 3;
+   msg->val[0] = st->mute;
+   msg->val[1] = st->left;
+   msg->val[2] = st->right;
+   edje_object_message_send(inst->gadget, EDJE_MESSAGE_INT_SET, 0, msg);
+   edje_object_signal_emit(inst->gadget, "e,action,volume,change", "e");
+
+   inst->shown = *st;
+   inst->shown_valid = EINA_TRUE;
+   mixer_context->gadget_sent++;
+}
+
+static void
+_mixer_gadget_flush(void)
+{
+   Gadget_State st;
    Instance *inst;
-   Eina_List*l;
+   Eina_List *l;
+
+   _mixer_gadget_state_get(&st);
+   EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+      _mixer_gadget_send(inst, &st);
+
+   mixer_context->gadget_last = ecore_loop_time_get();
+   DBG("Gadget messages: %u sent, %u suppressed",
+       mixer_context->gadget_sent, mixer_context->gadget_suppressed);
+}
+
+static Eina_Bool
+_mixer_gadget_timer_cb(void *data EINA_UNUSED)
+{
+   mixer_context->gadget_timer = NULL;
+   _mixer_gadget_flush();
+   return ECORE_CALLBACK_CANCEL;
+}
+
+/*
+ * Popups follow every change, even while hidden, gadgets are sent the
+ * state at most GADGET_RATE times per second and only when what they
+ * show differs.
+ */
+static void
+_mixer_gadget_update(void)
+{
+   Instance *inst;
+   Eina_List *l;
+   double elapsed;
 
    EINA_LIST_FOREACH(mixer_context->instances, l, inst)
      {
-        msg = alloca(sizeof(Edje_Message_Int_Set) + (2 * sizeof(int)));
-        msg->count = 3;
+        if (!inst->popup)
+           continue;
 
         if (!mixer_context->sink_default)
-          {
-             msg->val[0] = EINA_FALSE;
-             msg->val[1] = 0;
-             msg->val[2] = 0;
-             if (inst->popup)
-               _popup_del(inst);
-          }
+           _popup_hide(inst);
         else
-          {
-             pa_volume_t vol =
-                pa_cvolume_avg(&mixer_context->sink_default->volume);
-             msg->val[0] = mixer_context->sink_default->mute;
-             msg->val[1] = PA_VOLUME_TO_INT(vol);
-             msg->val[2] = msg->val[1];
-             if (inst->popup)
-               _mixer_popup_update(inst, mixer_context->sink_default->mute,
-                                    msg->val[1]);
-          }
-        edje_object_message_send(inst->gadget, EDJE_MESSAGE_INT_SET, 0, msg);
-        edje_object_signal_emit(inst->gadget, "e,action,volume,change", "e");
+           _mixer_popup_update(inst, mixer_context->sink_default->mute,
+                               PA_VOLUME_TO_INT(pa_cvolume_avg(
+                                  &mixer_context->sink_default->volume)));
      }
+
+   /* the pending flush will pick up the latest state */
+   if (mixer_context->gadget_timer)
+     {
+        mixer_context->gadget_suppressed +=
+           eina_list_count(mixer_context->instances);
+        return;
+     }
+
+   elapsed = ecore_loop_time_get() - mixer_context->gadget_last;
+   if (elapsed < 1.0 / GADGET_RATE)
+     {
+        mixer_context->gadget_timer =
+           ecore_timer_add(1.0 / GADGET_RATE - elapsed,
+                           _mixer_gadget_timer_cb, NULL);
+        return;
+     }
+
+   _mixer_gadget_flush();
+}
+
+static void
+_mixer_gadget_connection_update(Instance *inst)
+{
+   if (epulse_connected_get())
+      edje_object_signal_emit(inst->gadget, "e,state,connected", "e");
+   else
+      edje_object_signal_emit(inst->gadget, "e,state,connecting", "e");
+}
+
+static void _mixer_connect(void);
+
+static Eina_Bool
+_connect_timer_cb(void *data EINA_UNUSED)
+{
+   /* the init end event did not come in time, or the last try failed */
+   mixer_context->connect_timer = NULL;
+   _mixer_connect();
+   return ECORE_CALLBACK_CANCEL;
+}
+
+/*
+ * Connecting is deferred until E finished starting up, so the module
+ * never holds the main loop while the server is slow or absent.
+ */
+static void
+_mixer_connect(void)
+{
+   if (mixer_context->connect_timer)
+     {
+        ecore_timer_del(mixer_context->connect_timer);
+        mixer_context->connect_timer = NULL;
+     }
+   if (mixer_context->init_end_handler)
+     {
+        ecore_event_handler_del(mixer_context->init_end_handler);
+        mixer_context->init_end_handler = NULL;
+     }
+
+   mixer_context->connect_time = ecore_time_get();
+   if (!epulse_connect())
+     {
+        ERR("Could not start connecting to PulseAudio");
+        mixer_context->connect_timer =
+           ecore_timer_add(CONNECT_RETRY, _connect_timer_cb, NULL);
+     }
+}
+
+static Eina_Bool
+_module_init_end_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
+                    void *info EINA_UNUSED)
+{
+   _mixer_connect();
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+
+static Eina_Bool
+_connected_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
+              void *info EINA_UNUSED)
+{
+   Instance *inst;
+   Eina_List *l;
+
+   INF("Connected to PulseAudio in %.1f ms",
+       (ecore_time_get() - mixer_context->connect_time) * 1000.0);
+
+   EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+      _mixer_gadget_connection_update(inst);
+
+   return ECORE_CALLBACK_PASS_ON;
+}
+
+static Eina_Bool
+_volume_step_active(int index)
+{
+   return mixer_context->step.sink == index &&
+      (ecore_loop_time_get() - mixer_context->step.last) < STEP_REPEAT;
+}
+
+static Eina_Bool
+_volume_flush_cb(void *data EINA_UNUSED)
+{
+   mixer_context->step.flush = NULL;
+   epulse_sink_volume_set(mixer_context->step.sink,
+                          mixer_context->step.target);
+   return ECORE_CALLBACK_CANCEL;
+}
+
+/*
+ * Steps are applied to a locally predicted volume, so quick repeats do
+ * not start again from a value the server has not confirmed yet. Held
+ * keys and fast scrolling take growing steps, and all the steps of one
+ * frame end up in a single write.
+ */
+static void
+_volume_step(int direction, unsigned int ticks)
+{
+   Sink *s = mixer_context->sink_default;
+   double now = ecore_loop_time_get();
+   double accel;
+   pa_volume_t inc;
+
+   EINA_SAFETY_ON_NULL_RETURN(s);
+
+   if (!_volume_step_active(s->index))
+     {
+        mixer_context->step.sink = s->index;
+        mixer_context->step.target = s->volume;
+        mixer_context->step.repeat = 0;
+     }
+   else if (mixer_context->step.direction == direction)
+      mixer_context->step.repeat++;
+   else
+      mixer_context->step.repeat = 0;
+
+   mixer_context->step.direction = direction;
+   mixer_context->step.last = now;
+
+   accel = 1.0 + (STEP_ACCEL_MAX - 1.0) *
+      MIN(mixer_context->step.repeat, STEP_ACCEL_RAMP) / STEP_ACCEL_RAMP;
+   inc = VOLUME_STEP * accel * MAX(ticks, 1);
+
+   if (direction > 0)
+      pa_cvolume_inc(&mixer_context->step.target, inc);
+   else
+      pa_cvolume_dec(&mixer_context->step.target, inc);
+
+   /* show the predicted volume right away */
+   s->volume = mixer_context->step.target;
+   _mixer_gadget_update();
+   _notify(PA_VOLUME_TO_INT(pa_cvolume_avg(&s->volume)), s->mute);
+
+   if (!mixer_context->step.flush)
+      mixer_context->step.flush = ecore_animator_add(_volume_flush_cb, NULL);
 }
 
 static void
@@ -196,10 +635,7 @@ _volume_increase_cb(E_Object *obj EINA_UNUSED, const char *params EINA_UNUSED)
 {
    EINA_SAFETY_ON_NULL_RETURN(mixer_context->sink_default);
 
-   Sink *s = mixer_context->sink_default;
-   pa_cvolume v = s->volume;
-   pa_cvolume_inc(&v, VOLUME_STEP);
-   epulse_sink_volume_set(s->index, v);
+   _volume_step(1, 1);
 }
 
 static void
@@ -207,11 +643,7 @@ _volume_decrease_cb(E_Object *obj EINA_UNUSED, const char *params EINA_UNUSED)
 {
    EINA_SAFETY_ON_NULL_RETURN(mixer_context->sink_default);
 
-   Sink *s = mixer_context->sink_default;
-   pa_cvolume v = s->volume;
-   pa_cvolume_dec(&v, VOLUME_STEP);
-
-   epulse_sink_volume_set(s->index, v);
+   _volume_step(-1, 1);
 }
 
 static void
@@ -298,21 +730,62 @@ _actions_unregister(void)
 }
 
 static void
-_popup_del(Instance *inst)
+_popup_render_post_cb(void *data, Evas *e, void *event_info EINA_UNUSED)
 {
+   Instance *inst = data;
+
+   evas_event_callback_del_full(e, EVAS_CALLBACK_RENDER_POST,
+                                _popup_render_post_cb, inst);
+   DBG("Popup visible %.2f ms after opening (%s)",
+       (ecore_time_get() - inst->popup_open) * 1000.0,
+       inst->popup_built ? "built" : "reused");
+}
+
+static void
+_popup_hide(Instance *inst)
+{
+   if (!inst->popup_visible)
+      return;
+
+   if (inst->throttle)
+      epulse_throttle_flush(inst->throttle);
+   _mixer_popup_input_window_destroy(inst);
+   e_gadcon_popup_hide(inst->popup);
+   inst->popup_visible = EINA_FALSE;
+}
+
+static void
+_popup_del_cb(void *obj)
+{
+   Instance *inst = e_object_data_get(obj);
+
+   if (inst->popup_visible)
+      _mixer_popup_input_window_destroy(inst);
+   if (inst->throttle)
+     {
+        epulse_throttle_flush(inst->throttle);
+        epulse_throttle_del(inst->throttle);
+        inst->throttle = NULL;
+     }
+   if (inst->popup_evas)
+      evas_event_callback_del_full(inst->popup_evas,
+                                   EVAS_CALLBACK_RENDER_POST,
+                                   _popup_render_post_cb, inst);
+   inst->popup_evas = NULL;
+   inst->popup_visible = EINA_FALSE;
+   inst->list = NULL;
    inst->slider = NULL;
    inst->check = NULL;
-#ifdef E_VERSION_MAJOR
-   E_FREE_FUNC(inst->popup, e_object_del);
-#else
-   E_FN_DEL(e_object_del, inst->popup);
-#endif
+   inst->popup = NULL;
 }
 
 static void
-_popup_del_cb(void *obj)
+_popup_del(Instance *inst)
 {
-   _popup_del(e_object_data_get(obj));
+   if (!inst->popup)
+      return;
+
+   e_object_del(E_OBJECT(inst->popup));
 }
 
 static Eina_Bool
@@ -327,22 +800,90 @@ _epulse_del_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
 }
 
 static void
-_epulse_exec_cb(void *data, void *data2 EINA_UNUSED)
+_epulse_show_cb(void *data EINA_UNUSED, Eina_Bool delivered)
 {
-   Instance *inst = data;
-
-   _popup_del(inst);
-   _mixer_popup_input_window_destroy(inst);
-   if (mixer_context->epulse)
+   /* Nothing is listening yet: start a resident mixer, unless one
+      spawned by a previous click is still coming up */
+   if (delivered || !mixer_context || mixer_context->epulse)
       return;
 
-   mixer_context->epulse = ecore_exe_run("epulse", NULL);
+   mixer_context->epulse = ecore_exe_run("epulse --resident", NULL);
    if (mixer_context->epulse_event_handler)
       ecore_event_handler_del(mixer_context->epulse_event_handler);
    mixer_context->epulse_event_handler =
       ecore_event_handler_add(ECORE_EXE_EVENT_DEL, _epulse_del_cb, NULL);
 }
 
+#if E_VERSION_MAJOR >= 20
+static void
+_mixer_dialog_del_cb(void *obj EINA_UNUSED)
+{
+   mixer_context->dialog = NULL;
+}
+
+static void
+_mixer_dialog_close_cb(void *data EINA_UNUSED, E_Dialog *dia)
+{
+   e_object_del(E_OBJECT(dia));
+}
+
+/*
+ * The full mixer in an E dialog, sharing the module's connection. The
+ * views are filled from libepulse's cached state with a replay instead
+ * of querying the server again.
+ */
+static void
+_mixer_dialog_show(void)
+{
+   E_Dialog *dia;
+   Evas_Object *content;
+
+   if (mixer_context->dialog)
+     {
+        elm_win_raise(mixer_context->dialog->win);
+        elm_win_activate(mixer_context->dialog->win);
+        return;
+     }
+
+   dia = e_dialog_new(NULL, "E", "_pulse_mixer");
+   EINA_SAFETY_ON_NULL_RETURN(dia);
+
+   content = main_window_content_add(dia->win);
+   if (!content)
+     {
+        e_object_del(E_OBJECT(dia));
+        return;
+     }
+
+   e_dialog_title_set(dia, _("Efl Volume Control"));
+   e_dialog_icon_set(dia, "audio-volume", 48);
+   e_dialog_resizable_set(dia, EINA_TRUE);
+   e_dialog_content_set(dia, content, 480, 360);
+   e_dialog_button_add(dia, _("Close"), NULL, _mixer_dialog_close_cb, NULL);
+   e_object_del_attach_func_set(E_OBJECT(dia), _mixer_dialog_del_cb);
+   elm_win_center(dia->win, 1, 1);
+   e_dialog_show(dia);
+   mixer_context->dialog = dia;
+
+   /* goes to every handler, the gadget ones skip the sinks they know */
+   epulse_replay();
+}
+#endif
+
+static void
+_epulse_exec_cb(void *data, void *data2 EINA_UNUSED)
+{
+   Instance *inst = data;
+
+   _popup_hide(inst);
+
+#if E_VERSION_MAJOR >= 20
+   _mixer_dialog_show();
+#else
+   epulse_ipc_send("show", _epulse_show_cb, NULL);
+#endif
+}
+
 static void
 _check_changed_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
                   void *event EINA_UNUSED)
@@ -360,20 +901,28 @@ _check_changed_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED,
 }
 
 static void
-_slider_changed_cb(void *data EINA_UNUSED, Evas_Object *obj,
-                   void *event EINA_UNUSED)
+_slider_volume_set_cb(void *data EINA_UNUSED, double value)
 {
-   int val;
+   int val = (int)value;
    pa_volume_t v;
    Sink *s = mixer_context->sink_default;
 
-   val = (int)e_slider_value_get(obj);
-   v = INT_TO_PA_VOLUME(val);
+   EINA_SAFETY_ON_NULL_RETURN(s);
 
+   v = INT_TO_PA_VOLUME(val);
    pa_cvolume_set(&s->volume, s->volume.channels, v);
    epulse_sink_volume_set(s->index, s->volume);
 }
 
+static void
+_slider_changed_cb(void *data, Evas_Object *obj,
+                   void *event EINA_UNUSED)
+{
+   Instance *inst = data;
+
+   epulse_throttle_push(inst->throttle, e_slider_value_get(obj));
+}
+
 static Evas_Object *
 _popup_add_slider(Instance *inst)
 {
@@ -389,24 +938,56 @@ _popup_add_slider(Instance *inst)
    e_slider_orientation_set(slider, 1);
    e_slider_value_range_set(slider, 0.0, 100.0);
    e_slider_value_format_display_set(slider, NULL);
+
+   inst->throttle = epulse_throttle_new(epulse_volume_rate_get(),
+                                        _slider_volume_set_cb, inst);
    evas_object_smart_callback_add(slider, "changed", _slider_changed_cb,
-                                  NULL);
+                                  inst);
 
    e_slider_value_set(slider, value);
    return slider;
 }
 
+static void
+_output_switched_cb(void *data EINA_UNUSED, const Eina_Bool *status,
+                    unsigned int count)
+{
+   unsigned int i, failed = 0;
+
+   for (i = 0; i < count; i++)
+      if (!status[i])
+         failed++;
+
+   if (failed)
+      WRN("Output switch incomplete, %u of %u operations failed", failed,
+          count);
+}
+
+/*
+ * Selecting a sink switches the whole output: the server default and
+ * every playing stream follow. Also called when the list is synced to
+ * the current default, which is then left alone.
+ */
 static void
 _sink_selected_cb(void *data)
 {
    Sink *s = data;
 
+   if (mixer_context->sink_default == s)
+      return;
+
    mixer_context->sink_default = s;
+   epulse_output_switch(s->index, _output_switched_cb, NULL);
    _mixer_gadget_update();
 }
 
+/*
+ * The popup content is built the first time it is opened and then kept,
+ * hidden, for the life of the gadget. The sink list is kept in sync by
+ * the sink callbacks so opening the popup is only a show.
+ */
 static void
-_popup_new(Instance *inst)
+_popup_build(Instance *inst)
 {
    Evas_Object *button, *list;
    Evas *evas;
@@ -415,8 +996,6 @@ _popup_new(Instance *inst)
    Eina_List *l;
    int pos = 0;
 
-   EINA_SAFETY_ON_NULL_RETURN(mixer_context->sink_default);
-
 #if E_VERSION_MAJOR >= 20
    inst->popup = e_gadcon_popup_new(inst->gcc, 0);
    evas = e_comp->evas;
@@ -424,6 +1003,7 @@ _popup_new(Instance *inst)
    inst->popup = e_gadcon_popup_new(inst->gcc);
    evas = inst->popup->win->evas;
 #endif
+   inst->popup_evas = evas;
 
    list = e_widget_list_add(evas, 0, 0);
 
@@ -462,12 +1042,91 @@ _popup_new(Instance *inst)
 
    e_gadcon_popup_content_set(inst->popup, list);
 
-   e_gadcon_popup_show(inst->popup);
    e_object_data_set(E_OBJECT(inst->popup), inst);
    E_OBJECT_DEL_SET(inst->popup, _popup_del_cb);
+}
+
+static void
+_popup_show(Instance *inst)
+{
+   EINA_SAFETY_ON_NULL_RETURN(mixer_context->sink_default);
+
+   if (inst->popup_visible)
+      return;
+
+   inst->popup_open = ecore_time_get();
+   inst->popup_built = !inst->popup;
+   if (!inst->popup)
+      _popup_build(inst);
+
+   e_gadcon_popup_show(inst->popup);
+   inst->popup_visible = EINA_TRUE;
+   evas_event_callback_add(inst->popup_evas, EVAS_CALLBACK_RENDER_POST,
+                           _popup_render_post_cb, inst);
    _mixer_popup_input_window_create(inst);
 }
 
+static void
+_popup_sink_append(Sink *s)
+{
+   Instance *inst;
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+      if (inst->list)
+         e_widget_ilist_append_full(inst->list, NULL, NULL, s->name,
+                                    _sink_selected_cb, s, NULL);
+}
+
+static void
+_popup_sink_remove(int pos)
+{
+   Instance *inst;
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+      if (inst->list)
+         e_widget_ilist_remove_num(inst->list, pos);
+}
+
+static void
+_popup_sink_label_set(int pos, const char *name)
+{
+   Instance *inst;
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+      if (inst->list)
+         e_widget_ilist_nth_label_set(inst->list, pos, name);
+}
+
+static void
+_popup_sinks_clear(void)
+{
+   Instance *inst;
+   Eina_List *l;
+
+   EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+      if (inst->list)
+         e_widget_ilist_clear(inst->list);
+}
+
+static void
+_popup_sink_default_select(void)
+{
+   Instance *inst;
+   Eina_List *l;
+   int pos;
+
+   pos = eina_list_data_idx(mixer_context->sinks, mixer_context->sink_default);
+   if (pos < 0)
+      return;
+
+   EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+      if (inst->list && e_widget_ilist_selected_get(inst->list) != pos)
+         e_widget_ilist_selected_set(inst->list, pos);
+}
+
 static void
 _menu_cb(void *data, E_Menu *menu EINA_UNUSED, E_Menu_Item *mi EINA_UNUSED)
 {
@@ -512,13 +1171,13 @@ _mouse_down_cb(void *data, Evas *evas EINA_UNUSED,
 
    if (ev->button == 1)
      {
-        if (!inst->popup)
+        if (!inst->popup_visible)
           {
-             _popup_new(inst);
+             _popup_show(inst);
           }
         else
           {
-             _popup_del(inst);
+             _popup_hide(inst);
           }
      }
    else if (ev->button == 2)
@@ -537,10 +1196,14 @@ _mouse_wheel_cb(void *data EINA_UNUSED, Evas *evas EINA_UNUSED,
 {
    Evas_Event_Mouse_Wheel *ev = event;
 
+   if (!mixer_context->sink_default)
+     return;
+
+   /* smooth scrolling reports several notches in one event */
    if (ev->z > 0)
-     _volume_decrease_cb(NULL, NULL);
+     _volume_step(-1, ev->z);
    else if (ev->z < 0)
-     _volume_increase_cb(NULL, NULL);
+     _volume_step(1, -ev->z);
 }
 
 /*
@@ -572,6 +1235,7 @@ _gc_init(E_Gadcon *gc, const char *name, const char *id, const char *style)
 
    if (mixer_context->sink_default)
      _mixer_gadget_update();
+   _mixer_gadget_connection_update(inst);
 
    return gcc;
 }
@@ -582,6 +1246,7 @@ _gc_shutdown(E_Gadcon_Client *gcc)
    Instance *inst;
 
    inst = gcc->data;
+   _popup_del(inst);
    evas_object_del(inst->gadget);
    mixer_context->instances = eina_list_remove(mixer_context->instances, inst);
    free(inst);
@@ -667,10 +1332,12 @@ _sink_default_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
 
    mixer_context->sinks = eina_list_append(mixer_context->sinks, s);
    mixer_context->sink_default = s;
+   _popup_sink_append(s);
 
  end:
+   _popup_sink_default_select();
    _mixer_gadget_update();
-   return ECORE_CALLBACK_DONE;
+   return ECORE_CALLBACK_PASS_ON;
 }
 
 static Eina_Bool
@@ -680,34 +1347,48 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
    Epulse_Event *ev = info;
    Eina_List *l;
    Sink *s;
-   Eina_Bool volume_changed;
+   int pos = -1;
+
+   if (!(ev->changed & (EPULSE_CHANGE_VOLUME | EPULSE_CHANGE_MUTE |
+                        EPULSE_CHANGE_NAME)))
+      return ECORE_CALLBACK_PASS_ON;
 
    EINA_LIST_FOREACH(mixer_context->sinks, l, s)
      {
+        pos++;
         if (ev->index == s->index)
           {
-             volume_changed = (s->mute != ev->mute ||
-                               !pa_cvolume_equal(&s->volume, &ev->volume))
-                ? EINA_TRUE : EINA_FALSE;
              s->mute = ev->mute;
-             s->volume = ev->volume;
-             if (ev->index == mixer_context->sink_default->index)
+             /* echoes of earlier steps would move the gadget backwards */
+             if (!_volume_step_active(s->index))
+                s->volume = ev->volume;
+             if (ev->changed & EPULSE_CHANGE_NAME)
+               {
+                  free(s->name);
+                  s->name = strdup(ev->name);
+                  _popup_sink_label_set(pos, s->name);
+               }
+             if (mixer_context->sink_default &&
+                 ev->index == mixer_context->sink_default->index &&
+                 ev->changed & (EPULSE_CHANGE_VOLUME | EPULSE_CHANGE_MUTE))
                {
                   _mixer_gadget_update();
-                  if (volume_changed)
-                     _notify(s->mute ? 0 : PA_VOLUME_TO_INT(
-                         pa_cvolume_avg(&mixer_context->sink_default->volume)));
+                  _notify(PA_VOLUME_TO_INT(
+                      pa_cvolume_avg(&mixer_context->sink_default->volume)),
+                          s->mute);
                }
           }
      }
 
-    return ECORE_CALLBACK_DONE;
+    return ECORE_CALLBACK_PASS_ON;
  }
 
  static Eina_Bool
  _disconnected_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
                   void *info EINA_UNUSED)
  {
+    Instance *inst;
+    Eina_List *l;
     Sink *s;
 
     EINA_LIST_FREE(mixer_context->sinks, s)
@@ -718,9 +1399,12 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
 
     mixer_context->sinks = NULL;
     mixer_context->sink_default = NULL;
+    _popup_sinks_clear();
     _mixer_gadget_update();
+    EINA_LIST_FOREACH(mixer_context->instances, l, inst)
+       _mixer_gadget_connection_update(inst);
 
-    return ECORE_CALLBACK_DONE;
+    return ECORE_CALLBACK_PASS_ON;
  }
 
  static Eina_Bool
@@ -733,7 +1417,7 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
 
     EINA_LIST_FOREACH(mixer_context->sinks, l, s)
        if (s->index == ev->index)
-          return ECORE_CALLBACK_DONE;
+          return ECORE_CALLBACK_PASS_ON;
 
     s = malloc(sizeof(*s));
     s->index = ev->index;
@@ -742,7 +1426,8 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
     s->mute = ev->mute;
 
     mixer_context->sinks = eina_list_append(mixer_context->sinks, s);
-    return ECORE_CALLBACK_DONE;
+    _popup_sink_append(s);
+    return ECORE_CALLBACK_PASS_ON;
  }
 
  static Eina_Bool
@@ -753,35 +1438,42 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
     Eina_List *l, *ll;
     Sink *s;
     Eina_Bool need_change_sink;
+    int pos = 0;
 
-    need_change_sink = (ev->index == mixer_context->sink_default->index)
-       ? EINA_TRUE : EINA_FALSE;
+    need_change_sink = mixer_context->sink_default &&
+       ev->index == mixer_context->sink_default->index;
 
     EINA_LIST_FOREACH_SAFE(mixer_context->sinks, l, ll, s)
       {
-         if (ev->index == s->index)
+         if (ev->index != s->index)
            {
-              free(s->name);
-              free(s);
-              mixer_context->sinks =
-                 eina_list_remove_list(mixer_context->sinks, l);
+              pos++;
+              continue;
            }
+
+         _popup_sink_remove(pos);
+         free(s->name);
+         free(s);
+         mixer_context->sinks =
+            eina_list_remove_list(mixer_context->sinks, l);
       }
 
     if (need_change_sink)
       {
-         s = mixer_context->sinks->data;
+         s = eina_list_data_get(mixer_context->sinks);
          mixer_context->sink_default = s;
+         _popup_sink_default_select();
          _mixer_gadget_update();
       }
 
-    return ECORE_CALLBACK_DONE;
+    return ECORE_CALLBACK_PASS_ON;
  }
 
  EAPI void *
  e_modapi_init(E_Module *m)
  {
     char buf[4096];
+    double start = ecore_time_get();
     printf("Load module");
     epulse_module = m;
 #ifdef HAVE_ENOTIFY
@@ -789,10 +1481,11 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
 #endif
     EINA_SAFETY_ON_FALSE_RETURN_VAL(epulse_common_init("epulse_mod"),
                                     NULL);
-    EINA_SAFETY_ON_FALSE_RETURN_VAL(epulse_init() > 0, NULL);
+    EINA_SAFETY_ON_FALSE_RETURN_VAL(epulse_init_deferred() > 0, NULL);
     if (!mixer_context)
       {
          mixer_context = E_NEW(Context, 1);
+         mixer_context->step.sink = -1;
 
          mixer_context->sink_default_handler =
             ecore_event_handler_add(SINK_DEFAULT, _sink_default_cb, NULL);
@@ -804,14 +1497,37 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
             ecore_event_handler_add(SINK_REMOVED, _sink_removed_cb, NULL);
          mixer_context->disconnected_handler =
             ecore_event_handler_add(DISCONNECTED, _disconnected_cb, NULL);
+         mixer_context->connected_handler =
+            ecore_event_handler_add(CONNECTED, _connected_cb, NULL);
+#if E_VERSION_MAJOR >= 20
+         /* enabled once E is up, there is no startup to wait for */
+         if (!e_module_loading_get())
+            _mixer_connect();
+         else
+#endif
+           {
+              /* older E cannot tell, enabled late it waits for the timer */
+              mixer_context->init_end_handler =
+                 ecore_event_handler_add(E_EVENT_MODULE_INIT_END,
+                                         _module_init_end_cb, NULL);
+              mixer_context->connect_timer =
+                 ecore_timer_add(CONNECT_FALLBACK, _connect_timer_cb, NULL);
+           }
+         /* epulse-ctl commands, unless a resident epulse serves them */
+         mixer_context->ctl = epulse_ctl_server_add();
          mixer_context->module = m;
          snprintf(buf, sizeof(buf), "%s/mixer.edj",
                   e_module_dir_get(mixer_context->module));
          mixer_context->theme = strdup(buf);
       }
+#if E_VERSION_MAJOR >= 20
+    /* the in-process mixer dialog uses the epulse views */
+    elm_theme_extension_add(NULL, EPULSE_THEME);
+#endif
     e_gadcon_provider_register(&_gadcon_class);
     _actions_register();
 
+    INF("Module init took %.2f ms", (ecore_time_get() - start) * 1000.0);
     return m;
  }
 
@@ -824,6 +1540,48 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
     _actions_unregister();
     e_gadcon_provider_unregister((const E_Gadcon_Client_Class *)&_gadcon_class);
 
+    if (mixer_context)
+      _osd_del();
+    if (mixer_context && mixer_context->step.flush)
+      {
+         ecore_animator_del(mixer_context->step.flush);
+         mixer_context->step.flush = NULL;
+      }
+    if (mixer_context && mixer_context->notify_timer)
+      {
+         ecore_timer_del(mixer_context->notify_timer);
+         mixer_context->notify_timer = NULL;
+      }
+    if (mixer_context && mixer_context->gadget_timer)
+      {
+         ecore_timer_del(mixer_context->gadget_timer);
+         mixer_context->gadget_timer = NULL;
+      }
+
+    /* a deferred connection that has not started yet */
+    if (mixer_context && mixer_context->connect_timer)
+      {
+         ecore_timer_del(mixer_context->connect_timer);
+         mixer_context->connect_timer = NULL;
+      }
+    if (mixer_context && mixer_context->init_end_handler)
+      {
+         ecore_event_handler_del(mixer_context->init_end_handler);
+         mixer_context->init_end_handler = NULL;
+      }
+    if (mixer_context && mixer_context->ctl)
+      {
+         epulse_ipc_server_del(mixer_context->ctl);
+         mixer_context->ctl = NULL;
+      }
+
+#if E_VERSION_MAJOR >= 20
+    if (mixer_context && mixer_context->dialog)
+       e_object_del(E_OBJECT(mixer_context->dialog));
+    icon_cache_shutdown();
+    elm_theme_extension_del(NULL, EPULSE_THEME);
+#endif
+
     if (!mixer_context)
       {
          if (mixer_context->theme)
@@ -833,6 +1591,7 @@ _sink_changed_cb(void *data EINA_UNUSED, int type EINA_UNUSED,
         ecore_event_handler_del(mixer_context->sink_changed_handler);
         ecore_event_handler_del(mixer_context->sink_added_handler);
         ecore_event_handler_del(mixer_context->sink_removed_handler);
+        ecore_event_handler_del(mixer_context->connected_handler);
 
         EINA_LIST_FREE(mixer_context->sinks, s)
           {
@@ -922,15 +1681,7 @@ _mixer_popup_input_window_create(Instance *inst)
 static void
 _mixer_popup_del(Instance *inst)
 {
-   _mixer_popup_input_window_destroy(inst);
-   e_object_del(E_OBJECT(inst->popup));
-   inst->ui.label = NULL;
-   inst->ui.left = NULL;
-   inst->ui.right = NULL;
-   inst->ui.mute = NULL;
-   inst->ui.table = NULL;
-   inst->ui.button = NULL;
-   inst->popup = NULL;
+   _popup_hide(inst);
    if (inst->popup_timer)
      ecore_timer_del(inst->popup_timer);
    inst->popup_timer = NULL;